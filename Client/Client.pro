@@ -16,6 +16,7 @@ SOURCES += \
     info.cpp \
     main.cpp \
     mainwindow.cpp \
+    mediacache.cpp \
     registerform.cpp \
     statusform.cpp \
     clickablelabel.cpp
@@ -24,6 +25,7 @@ HEADERS += \
     ClickableLabel.h \
     info.h \
     mainwindow.h \
+    mediacache.h \
     registerform.h \
     statusform.h \
     clickablelabel.h
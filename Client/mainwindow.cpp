@@ -92,6 +92,12 @@ void MainWindow::readData() {
 
     QString response = QString::fromUtf8(data);
 
+    // Keep the session token of a successful login
+    const QString token = QJsonDocument::fromJson(data.trimmed()).object().value("token").toString();
+    if (!token.isEmpty()) {
+        sessionToken = token;
+    }
+
     // Handle login response
     handleLoginResponse(response);
 
@@ -100,6 +106,8 @@ void MainWindow::readData() {
         QMessageBox::information(this, "Status Update", "User status saved successfully.");
     } else if (response.contains("Failed to save user status")) {
         QMessageBox::warning(this, "Status Update", "Failed to save user status.");
+    } else if (response.contains("retryAfter")) {
+        QMessageBox::warning(this, "Server busy", "Server is busy, please try again in a moment.");
     }
 }
 
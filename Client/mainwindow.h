@@ -24,6 +24,9 @@ public:
     // Getter for username
     QString getUsername() const;
 
+    // Session token from the last successful login, empty before one
+    QString getSessionToken() const { return sessionToken; }
+
     // Method to disconnect from the server
     void disconnectFromServer();
 
@@ -60,6 +63,9 @@ private:
 
     // Socket pointer
     QTcpSocket *socket;
+
+    // Sent with later requests so reconnects need no password check
+    QString sessionToken;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,104 @@
+#include "mediacache.h"
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+
+MediaCache::MediaCache(QObject *parent)
+    : QObject(parent)
+    , manager(new QNetworkAccessManager(this))
+    , cacheDir(QDir::currentPath() + "/cache")
+{
+    QDir dir(cacheDir);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qDebug() << "MediaCache: Failed to create cache directory:" << cacheDir;
+    }
+}
+
+QString MediaCache::entryPath(const QString &key) const {
+    return cacheDir + "/" + key;
+}
+
+QString MediaCache::cachedPath(const QString &key) const {
+    QString path = entryPath(key);
+    if (QFile::exists(path) && QFile::exists(path + ".etag")) {
+        return path;
+    }
+    return QString();
+}
+
+QString MediaCache::readETag(const QString &key) const {
+    QFile file(entryPath(key) + ".etag");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    return QString::fromUtf8(file.readAll().trimmed());
+}
+
+void MediaCache::writeETag(const QString &key, const QByteArray &etag) {
+    QSaveFile file(entryPath(key) + ".etag");
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "MediaCache: Failed to write etag for" << key << file.errorString();
+        return;
+    }
+    file.write(etag);
+    file.commit();
+}
+
+void MediaCache::fetch(const QString &key, const QUrl &url) {
+    QNetworkRequest request(url);
+    const QString cached = cachedPath(key);
+    if (!cached.isEmpty()) {
+        const QString etag = readETag(key);
+        if (!etag.isEmpty()) {
+            request.setRawHeader("If-None-Match", etag.toUtf8());
+        }
+    }
+
+    QNetworkReply *reply = manager->get(request);
+
+    // Stream the body straight to disk so large videos never sit in memory.
+    // QSaveFile only replaces the cached copy once the download is complete.
+    QSaveFile *target = new QSaveFile(entryPath(key), reply);
+
+    connect(reply, &QNetworkReply::readyRead, this, [reply, target]() {
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 200) {
+            return;
+        }
+        if (!target->isOpen() && !target->open(QIODevice::WriteOnly)) {
+            qDebug() << "MediaCache: Failed to open cache file:" << target->errorString();
+            reply->abort();
+            return;
+        }
+        target->write(reply->readAll());
+    });
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, target, key]() {
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+        if (reply->error() == QNetworkReply::NoError && status == 304) {
+            emit mediaReady(key, entryPath(key), false);
+        } else if (reply->error() == QNetworkReply::NoError && status == 200) {
+            if (!target->isOpen() && !target->open(QIODevice::WriteOnly)) {
+                emit fetchFailed(key, target->errorString());
+            } else {
+                target->write(reply->readAll());
+                if (target->commit()) {
+                    writeETag(key, reply->rawHeader("ETag"));
+                    emit mediaReady(key, entryPath(key), true);
+                } else {
+                    emit fetchFailed(key, target->errorString());
+                }
+            }
+        } else {
+            if (target->isOpen()) {
+                target->cancelWriting();
+            }
+            emit fetchFailed(key, reply->errorString());
+        }
+        reply->deleteLater();
+    });
+}
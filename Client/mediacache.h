@@ -0,0 +1,39 @@
+#ifndef MEDIACACHE_H
+#define MEDIACACHE_H
+
+#include <QObject>
+#include <QUrl>
+#include <QString>
+
+class QNetworkAccessManager;
+
+// On-disk cache for media downloaded from the server. Each entry is stored as
+// <key> plus a <key>.etag sidecar and is revalidated with If-None-Match, so an
+// unchanged file costs one 304 round trip instead of a full download.
+class MediaCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MediaCache(QObject *parent = nullptr);
+
+    // Path of the cached copy, or an empty string when nothing is cached yet
+    QString cachedPath(const QString &key) const;
+
+    // Revalidate (or download) the entry; emits mediaReady or fetchFailed
+    void fetch(const QString &key, const QUrl &url);
+
+signals:
+    void mediaReady(const QString &key, const QString &localPath, bool changed);
+    void fetchFailed(const QString &key, const QString &error);
+
+private:
+    QString entryPath(const QString &key) const;
+    QString readETag(const QString &key) const;
+    void writeETag(const QString &key, const QByteArray &etag);
+
+    QNetworkAccessManager *manager;
+    QString cacheDir;
+};
+
+#endif // MEDIACACHE_H
@@ -88,5 +88,8 @@ void registerform::handleServerResponse() {
         QMessageBox::information(this, "Registration Success", "You have successfully created an account.");
         this->close();
         mainWindow->show();
+    } else if (status == "Failed to save data" || status == "retryAfter") {
+        QMessageBox::warning(this, "Registration Error", "The server couldn't create the account right now, please try again.");
+        connect(ui->btnRegisterSubmit, &QPushButton::clicked, this, &registerform::on_btnSubmit_clicked); // Reconnect the button
     }
 }
@@ -34,6 +34,19 @@
 #include <QFile>
 #include <functional>
 #include <QImageReader>
+#include "mediacache.h"
+
+// Decode an avatar straight to 64 px. QImageReader lets the JPEG decoder
+// downscale while decoding instead of expanding the full camera capture.
+static QPixmap loadAvatarPixmap(const QString &filePath) {
+    QImageReader reader(filePath);
+    reader.setAutoTransform(true);
+    QSize sourceSize = reader.size();
+    if (sourceSize.isValid()) {
+        reader.setScaledSize(sourceSize.scaled(64, 64, Qt::KeepAspectRatio));
+    }
+    return QPixmap::fromImage(reader.read());
+}
 
 // Constructor for statusForm
 statusForm::statusForm(QWidget *parent, MainWindow *mainWindow)
@@ -49,14 +62,17 @@ statusForm::statusForm(QWidget *parent, MainWindow *mainWindow)
     , mediaPlayer(new QMediaPlayer(this))
     , videoWidget(new QVideoWidget(this))
     , videoSink(new QVideoSink(this))
+    , mediaCache(new MediaCache(this))
 {
     ui->setupUi(this);
+    connect(mediaCache, &MediaCache::mediaReady, this, &statusForm::onCachedMediaReady);
     mediaPlayer->setVideoSink(videoSink);
     displayIntroVideo(mainWindow->getUsername());
 
     // Connect frame updates to a slot
     connect(videoSink, &QVideoSink::videoFrameChanged, this, &statusForm::updateVideoFrame);
     connect(mediaPlayer, &QMediaPlayer::errorOccurred, this, &statusForm::handleMediaPlayerError);
+    connect(mediaPlayer, &QMediaPlayer::mediaStatusChanged, this, &statusForm::onMediaStatusChanged);
 
     // Connect the exit button to the on_btnExit_clicked slot
     connect(ui->btnExit, &QPushButton::clicked, this, &statusForm::on_btnExit_clicked);
@@ -199,6 +215,11 @@ void statusForm::sendFileToServer(const QString &filePath, const QUrl &serverUrl
 void statusForm::on_btnPlay_clicked() {
     disconnect(ui->btnPlay, &QPushButton::clicked, this, &statusForm::on_btnPlay_clicked);
 
+    // The full intro is only pulled from the server once someone asks to watch it
+    if (mediaPlayer->source().isEmpty()) {
+        loadRemoteIntroVideo(currentUsername);
+    }
+
     mediaPlayer->play();
     qDebug() << "Video playback started.";
 }
@@ -214,9 +235,51 @@ void statusForm::on_btnStop_clicked() {
 // Function to display the intro video for a user
 void statusForm::displayIntroVideo(const QString &username) {
     QString videoPath = QDir::currentPath() + "/intro/" + username + ".mp4";
-    mediaPlayer->setSource(QUrl::fromLocalFile(videoPath));
-    qDebug() << "Setting video source to:" << videoPath;
-    mediaPlayer->setSource(QUrl::fromLocalFile(videoPath));
+    if (QFile::exists(videoPath)) {
+        qDebug() << "Setting video source to:" << videoPath;
+        mediaPlayer->setSource(QUrl::fromLocalFile(videoPath));
+        return;
+    }
+
+    // Show the server-generated poster frame until Play is pressed
+    QString cachedPoster = mediaCache->cachedPath("poster_" + username);
+    if (!cachedPoster.isEmpty()) {
+        showIntroPoster(cachedPoster);
+    }
+    mediaCache->fetch("poster_" + username, QUrl("http://localhost:8080/intro/" + username + "/poster"));
+}
+
+void statusForm::showIntroPoster(const QString &posterPath) {
+    QPixmap poster(posterPath);
+    if (!poster.isNull()) {
+        ui->lblDisplayIntroVideo->setPixmap(poster.scaled(ui->lblDisplayIntroVideo->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    }
+}
+
+void statusForm::loadRemoteIntroVideo(const QString &username) {
+    // Play the validated cache copy and revalidate it (usually a 304). On a
+    // miss, stream the intro with range requests so playback starts at once;
+    // the cache is filled after playback ends, not side by side with it.
+    QUrl videoUrl("http://localhost:8080/intro/" + username);
+    QString cachedPath = mediaCache->cachedPath("intro_" + username);
+    if (!cachedPath.isEmpty()) {
+        qDebug() << "Setting video source to cached copy:" << cachedPath;
+        mediaPlayer->setSource(QUrl::fromLocalFile(cachedPath));
+        mediaCache->fetch("intro_" + username, videoUrl);
+        return;
+    }
+    qDebug() << "Streaming video from:" << videoUrl;
+    mediaPlayer->setSource(videoUrl);
+    introCacheFillPending = true;
+}
+
+void statusForm::onMediaStatusChanged(QMediaPlayer::MediaStatus status) {
+    if (status != QMediaPlayer::EndOfMedia || !introCacheFillPending) {
+        return;
+    }
+    // The stream has finished, so the download no longer competes with it
+    introCacheFillPending = false;
+    mediaCache->fetch("intro_" + currentUsername, QUrl("http://localhost:8080/intro/" + currentUsername));
 }
 
 void statusForm::updateVideoFrame(const QVideoFrame &frame) {
@@ -460,9 +523,9 @@ void statusForm::onImageSaved(int id, const QString &fileName) {
         return;
     }
     // Set captured image to lblAvatar
-    QPixmap avatarPixmap;
-    if (avatarPixmap.load(fileName)) {
-        ui->lblAvatar->setPixmap(avatarPixmap.scaled(64, 64, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    QPixmap avatarPixmap = loadAvatarPixmap(fileName);
+    if (!avatarPixmap.isNull()) {
+        ui->lblAvatar->setPixmap(avatarPixmap);
         qDebug() << "Avatar pixmap set successfully.";
         QMessageBox::information(this, "Success", "Avatar image saved successfully at " + fileName);
     } else {
@@ -492,14 +555,49 @@ void statusForm::setAvatarForUser(const QString &username) {
     QPixmap avatarPixmap;
 
     if (QFile::exists(filePath)) {
-        avatarPixmap.load(filePath);
+        avatarPixmap = loadAvatarPixmap(filePath);
         qDebug() << "Avatar set for user:" << username;
     } else {
-        avatarPixmap.load(":/icon/user.png");
+        avatarPixmap = loadAvatarPixmap(":/icon/user.png");
         qDebug() << "Avatar file does not exist for user:" << username << ". Setting default avatar.";
+        fetchAvatarFromServer(username);
+    }
+
+    ui->lblAvatar->setPixmap(avatarPixmap);
+}
+
+// Load the avatar from the media cache and revalidate it against the server
+void statusForm::fetchAvatarFromServer(const QString &username) {
+    QString cachedPath = mediaCache->cachedPath("avatar_" + username);
+    if (!cachedPath.isEmpty()) {
+        QPixmap avatarPixmap = loadAvatarPixmap(cachedPath);
+        if (!avatarPixmap.isNull()) {
+            ui->lblAvatar->setPixmap(avatarPixmap);
+        }
+    }
+    // The server keeps pre-scaled thumbnails, so only the 64 px version is transferred
+    mediaCache->fetch("avatar_" + username, QUrl("http://localhost:8080/avatar/" + username + "?size=64"));
+}
+
+void statusForm::onCachedMediaReady(const QString &key, const QString &localPath, bool changed) {
+    if (!changed) {
+        return; // Cached copy already in use
     }
 
-    ui->lblAvatar->setPixmap(avatarPixmap.scaled(64, 64, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    if (key == "avatar_" + currentUsername) {
+        QPixmap avatarPixmap = loadAvatarPixmap(localPath);
+        if (!avatarPixmap.isNull()) {
+            ui->lblAvatar->setPixmap(avatarPixmap);
+            qDebug() << "Avatar updated from server for user:" << currentUsername;
+        }
+    } else if (key == "poster_" + currentUsername && mediaPlayer->source().isEmpty()) {
+        showIntroPoster(localPath);
+    } else if (key == "intro_" + currentUsername
+               && mediaPlayer->playbackState() != QMediaPlayer::PlayingState
+               && !QFile::exists(QDir::currentPath() + "/intro/" + currentUsername + ".mp4")) {
+        qDebug() << "Setting video source to refreshed cache copy:" << localPath;
+        mediaPlayer->setSource(QUrl::fromLocalFile(localPath));
+    }
 }
 
 // Function to request user data from the server
@@ -510,6 +608,11 @@ void statusForm::requestUserData(const QString &requestType, const QString &user
         if (!username.isEmpty()) {
             requestData["username"] = username; // Include the username in the request if provided
         }
+        // Identifies this connection, also after a reconnect, without sending the password again
+        const QString token = mainWindow ? mainWindow->getSessionToken() : QString();
+        if (!token.isEmpty()) {
+            requestData["token"] = token;
+        }
         QJsonDocument doc(requestData);
         QByteArray message = doc.toJson(QJsonDocument::Compact);
         socket->write(message);
@@ -584,6 +687,16 @@ void statusForm::handleServerResponse(const QJsonObject &jsonObj) {
             QMessageBox::information(this, "Information", "Information is already available, if you want to adjust please update.");
         } else if (responseType == "currentPoints") {
             handleUserPoints(jsonObj["username"].toString(), jsonObj["points"].toInt());
+        } else if (responseType == "retryAfter") {
+            // The server is busy; ask again once it says so. The points timer
+            // already asks for showPoints every second.
+            const QString request = jsonObj["request"].toString();
+            if (!request.isEmpty() && request != "showPoints") {
+                const QString username = request == "currentLoginUser" || request == "Exit" ? QString() : currentUsername;
+                QTimer::singleShot(jsonObj["retryAfterMs"].toInt(1000), this, [this, request, username]() {
+                    requestUserData(request, username);
+                });
+            }
         }
     }
 }
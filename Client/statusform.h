@@ -15,6 +15,7 @@
 
 // Forward declaration of MainWindow class
 class MainWindow;
+class MediaCache;
 
 namespace Ui {
 class statusForm;
@@ -57,6 +58,8 @@ private slots:
     void startCamera();
     void captureImage();
     void setAvatarForUser(const QString &username);
+    void fetchAvatarFromServer(const QString &username);
+    void onCachedMediaReady(const QString &key, const QString &localPath, bool changed);
     void on_btnCreateIntroVideo_clicked();
     void on_btnUpdateIntroVideo_clicked();
     void startRecordingIntroVideo();
@@ -68,6 +71,9 @@ private slots:
     void on_btnPlay_clicked();
     void on_btnStop_clicked();
     void displayIntroVideo(const QString &username);
+    void showIntroPoster(const QString &posterPath);
+    void loadRemoteIntroVideo(const QString &username);
+    void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
     void updateVideoFrame(const QVideoFrame &frame);
     void uploadFile(const QString &filePath, const QUrl &url);
     void sendFileToServer(const QString &filePath, const QUrl &serverUrl);
@@ -85,6 +91,8 @@ private:
     QMediaPlayer *mediaPlayer;
     QVideoWidget *videoWidget;
     QVideoSink *videoSink;
+    MediaCache *mediaCache;
+    bool introCacheFillPending = false; // The intro was streamed on a cache miss; cache it once playback ends
 
 };
 
@@ -1,4 +1,4 @@
-QT += core gui network httpserver websockets
+QT += core gui network httpserver websockets multimedia concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -10,11 +10,58 @@ CONFIG+=test
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    accountstore.cpp \
+    accounttransfer.cpp \
+    accountworker.cpp \
+    asyncfilesink.cpp \
+    clock.cpp \
+    commandscheduler.cpp \
+    eventloopwatchdog.cpp \
+    filerangedevice.cpp \
+    intropreviewworker.cpp \
     main.cpp \
-    server.cpp
+    metrics.cpp \
+    passwordhash.cpp \
+    presencemodel.cpp \
+    quotaledger.cpp \
+    requestlog.cpp \
+    rollupstore.cpp \
+    rosterindex.cpp \
+    scoringrules.cpp \
+    server.cpp \
+    sessiontokens.cpp \
+    timesheetmodel.cpp \
+    timesheetstore.cpp \
+    tracer.cpp \
+    trafficcapture.cpp
 
 HEADERS += \
-    server.h
+    accountstore.h \
+    accounttransfer.h \
+    accountworker.h \
+    asyncfilesink.h \
+    clock.h \
+    commandscheduler.h \
+    eventloopwatchdog.h \
+    filerangedevice.h \
+    intropreviewworker.h \
+    keyedtablemodel.h \
+    metrics.h \
+    passwordhash.h \
+    presencemodel.h \
+    quotaledger.h \
+    requestlog.h \
+    rollupstore.h \
+    rosterindex.h \
+    scoringrules.h \
+    server.h \
+    sessiontokens.h \
+    timesheetmodel.h \
+    timesheetstore.h \
+    tracer.h \
+    trafficcapture.h
+
+win32: LIBS += -lpsapi
 
 FORMS += \
     server.ui
@@ -0,0 +1,488 @@
+#include "accountstore.h"
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+#include <QUuid>
+
+Q_DECLARE_LOGGING_CATEGORY(serverCategory)
+
+AccountStore::AccountStore(const QString &baseDir)
+    : store(baseDir)
+{
+}
+
+AccountStore::FileStamp AccountStore::stampOf(const QString &filePath)
+{
+    const QFileInfo info(filePath);
+    FileStamp stamp;
+    if (info.exists()) {
+        stamp.size = info.size();
+        stamp.modified = info.lastModified();
+    }
+    return stamp;
+}
+
+void AccountStore::refreshCredentials()
+{
+    const FileStamp stamp = stampOf(store.accountFilePath());
+    if (credentialsLoaded && stamp == credentialStamp) {
+        return;
+    }
+
+    const QJsonObject root = store.loadAccounts();
+    credentialsLoaded = true;
+    credentialStamp = stamp;
+
+    const QJsonArray users = root.value("users").toArray();
+    for (const QJsonValue &value : users) {
+        if (value.toObject().contains("info")) {
+            if (!writeCredentials(root)) {
+                // Still logs in from what is on disk; the move is retried on the next save
+                cacheCredentials(root);
+                credentialsLoaded = true;
+                credentialStamp = stamp;
+            }
+            return;
+        }
+    }
+
+    cacheCredentials(root);
+}
+
+static QByteArray tagOf(const QString &storedPassword)
+{
+    return QCryptographicHash::hash(storedPassword.toUtf8(), QCryptographicHash::Sha256).left(6);
+}
+
+void AccountStore::cacheCredentials(const QJsonObject &accounts)
+{
+    credentialRoot = accounts;
+    passwords.clear();
+    plaintextCount = 0;
+    auto tags = std::make_shared<QHash<QString, QByteArray>>();
+    const QJsonArray users = accounts.value("users").toArray();
+    for (const QJsonValue &value : users) {
+        const QJsonObject account = value.toObject();
+        const QString username = account.value("username").toString();
+        const QString password = account.value("password").toString();
+        passwords.insert(username, password);
+        // The last duplicate wins, as in passwords.constFind()
+        tags->insert(username, tagOf(password));
+        if (!PasswordHash::isHash(password)) {
+            ++plaintextCount;
+        }
+    }
+    std::atomic_store(&credentialTags, std::shared_ptr<const QHash<QString, QByteArray>>(std::move(tags)));
+}
+
+void AccountStore::refreshProfiles()
+{
+    const FileStamp stamp = stampOf(store.profilesFilePath());
+    if (profilesLoaded && stamp == profileStamp) {
+        return;
+    }
+    // No profiles file yet is the normal state of a fresh server
+    profiles = stamp.size >= 0 ? store.loadProfiles().value("profiles").toObject() : QJsonObject();
+    profilesLoaded = true;
+    profileStamp = stamp;
+}
+
+bool AccountStore::writeProfiles()
+{
+    QJsonObject root;
+    root["profiles"] = profiles;
+    const bool ok = store.saveProfiles(root);
+    profileStamp = stampOf(store.profilesFilePath());
+    if (!ok) {
+        profilesLoaded = false; // The cache is ahead of the file; read it back
+    }
+    return ok;
+}
+
+bool AccountStore::writeCredentials(QJsonObject accounts)
+{
+    QJsonArray users = accounts.value("users").toArray();
+    QJsonObject moved;
+    for (int i = 0; i < users.size(); ++i) {
+        QJsonObject account = users.at(i).toObject();
+        if (account.contains("info")) {
+            // Info still in account.json was written after the split, so it is the newer copy
+            moved[account.value("username").toString()] = account.take("info");
+            users[i] = account;
+        }
+    }
+    accounts["users"] = users;
+
+    bool profilesSaved = true;
+    if (!moved.isEmpty()) {
+        refreshProfiles();
+        for (auto it = moved.constBegin(); it != moved.constEnd(); ++it) {
+            profiles[it.key()] = it.value();
+        }
+        profilesSaved = writeProfiles();
+        if (profilesSaved) {
+            qCInfo(serverCategory) << "AccountStore: Moved" << moved.size() << "profiles to" << store.profilesFilePath();
+        }
+    }
+
+    // account.json keeps the info objects until they are safely in profiles.json
+    if (!profilesSaved) {
+        return false;
+    }
+    // Nobody logs in against accounts that never reached the disk
+    if (!store.saveAccounts(accounts)) {
+        credentialsLoaded = false;
+        return false;
+    }
+    credentialsLoaded = true;
+    credentialStamp = stampOf(store.accountFilePath());
+    cacheCredentials(accounts);
+    return true;
+}
+
+void AccountStore::setHashIterations(int iterations)
+{
+    QMutexLocker locker(&mutex);
+    hashIterations = iterations;
+    dummyHash.clear();
+}
+
+QString AccountStore::hashPassword(const QString &password) const
+{
+    return PasswordHash::create(password, hashIterations);
+}
+
+bool AccountStore::checkCredentials(const QString &username, const QString &password)
+{
+    QStringList stored;
+    {
+        QMutexLocker locker(&mutex);
+        refreshCredentials();
+        stored = passwords.values(username);
+    }
+
+    if (stored.isEmpty()) {
+        PasswordHash::verify(password, unknownUserHash());
+        return false;
+    }
+    for (const QString &entry : std::as_const(stored)) {
+        if (PasswordHash::verify(password, entry)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AccountStore::hasPlaintextPasswords()
+{
+    QMutexLocker locker(&mutex);
+    refreshCredentials();
+    return plaintextCount > 0;
+}
+
+QList<AccountStore::PasswordUpgrade> AccountStore::plaintextPasswords()
+{
+    QMutexLocker locker(&mutex);
+    refreshCredentials();
+    QList<PasswordUpgrade> upgrades;
+    upgrades.reserve(plaintextCount);
+    for (auto it = passwords.constBegin(); it != passwords.constEnd(); ++it) {
+        if (!PasswordHash::isHash(it.value())) {
+            upgrades.append({it.key(), it.value(), QString()});
+        }
+    }
+    return upgrades;
+}
+
+int AccountStore::applyPasswordUpgrades(const QList<PasswordUpgrade> &upgrades)
+{
+    // Keyed by both, account.json allows duplicate usernames
+    QHash<QPair<QString, QString>, QString> hashOf;
+    for (const PasswordUpgrade &upgrade : upgrades) {
+        if (!upgrade.hash.isEmpty()) {
+            hashOf.insert(qMakePair(upgrade.username, upgrade.plaintext), upgrade.hash);
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+    refreshCredentials();
+    QJsonObject accounts = credentialRoot;
+    QJsonArray users = accounts.value("users").toArray();
+    int replaced = 0;
+    for (int i = 0; i < users.size(); ++i) {
+        QJsonObject account = users.at(i).toObject();
+        // A password changed since it was read keeps the new value
+        auto it = hashOf.constFind(qMakePair(account.value("username").toString(),
+                                             account.value("password").toString()));
+        if (it != hashOf.constEnd()) {
+            account["password"] = *it;
+            users[i] = account;
+            ++replaced;
+        }
+    }
+    if (replaced == 0) {
+        return 0;
+    }
+    accounts["users"] = users;
+    return writeCredentials(accounts) ? replaced : -1;
+}
+
+// A hash with the current cost; its password is random and never matches
+QString AccountStore::unknownUserHash()
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (!dummyHash.isEmpty()) {
+            return dummyHash;
+        }
+    }
+    const QString hash = hashPassword(QUuid::createUuid().toString());
+    QMutexLocker locker(&mutex);
+    if (dummyHash.isEmpty()) {
+        dummyHash = hash;
+    }
+    return dummyHash;
+}
+
+bool AccountStore::contains(const QString &username)
+{
+    QMutexLocker locker(&mutex);
+    refreshCredentials();
+    return passwords.contains(username);
+}
+
+QByteArray AccountStore::credentialTag(const QString &username)
+{
+    auto tags = std::atomic_load(&credentialTags);
+    if (!tags) {
+        // Nothing loaded yet
+        QMutexLocker locker(&mutex);
+        refreshCredentials();
+        tags = std::atomic_load(&credentialTags);
+    }
+    return tags ? tags->value(username) : QByteArray();
+}
+
+QJsonObject AccountStore::accounts()
+{
+    QMutexLocker locker(&mutex);
+    refreshCredentials();
+    return credentialRoot;
+}
+
+bool AccountStore::saveAccounts(const QJsonObject &accounts)
+{
+    QMutexLocker locker(&mutex);
+    return writeCredentials(accounts);
+}
+
+bool AccountStore::hasProfile(const QString &username)
+{
+    QMutexLocker locker(&mutex);
+    refreshProfiles();
+    return profiles.contains(username);
+}
+
+QJsonObject AccountStore::profile(const QString &username)
+{
+    QMutexLocker locker(&mutex);
+    refreshProfiles();
+    return profiles.value(username).toObject();
+}
+
+QJsonObject AccountStore::allProfiles()
+{
+    QMutexLocker locker(&mutex);
+    refreshProfiles();
+    return profiles;
+}
+
+bool AccountStore::setProfile(const QString &username, const QJsonObject &info)
+{
+    QMutexLocker locker(&mutex);
+    refreshProfiles();
+    profiles[username] = info;
+    return writeProfiles();
+}
+
+bool AccountStore::removeProfile(const QString &username)
+{
+    QMutexLocker locker(&mutex);
+    refreshProfiles();
+    if (!profiles.contains(username)) {
+        return true;
+    }
+    profiles.remove(username);
+    return writeProfiles();
+}
+
+AccountStore::EditResult AccountStore::addAccount(const QString &username, const QString &storedPassword)
+{
+    QMutexLocker locker(&mutex);
+    refreshCredentials();
+    if (passwords.contains(username)) {
+        return EditResult::Exists;
+    }
+    QJsonObject account;
+    account["username"] = username;
+    account["password"] = storedPassword;
+    QJsonObject accounts = credentialRoot;
+    QJsonArray users = accounts.value("users").toArray();
+    users.append(account);
+    accounts["users"] = users;
+    return writeCredentials(accounts) ? EditResult::Done : EditResult::WriteFailed;
+}
+
+AccountStore::EditResult AccountStore::removeAccount(const QString &username)
+{
+    QMutexLocker locker(&mutex);
+    refreshCredentials();
+    if (!passwords.contains(username)) {
+        return EditResult::NotFound;
+    }
+    QJsonObject accounts = credentialRoot;
+    const QJsonArray users = accounts.value("users").toArray();
+    QJsonArray remaining;
+    for (const QJsonValue &user : users) {
+        if (user.toObject().value("username").toString() != username) {
+            remaining.append(user);
+        }
+    }
+    accounts["users"] = remaining;
+    if (!writeCredentials(accounts)) {
+        return EditResult::WriteFailed;
+    }
+
+    // The profile of a dropped user goes with it
+    refreshProfiles();
+    if (profiles.contains(username)) {
+        profiles.remove(username);
+        if (!writeProfiles()) {
+            return EditResult::WriteFailed;
+        }
+    }
+    return EditResult::Done;
+}
+
+AccountStore::EditResult AccountStore::mergeProfile(const QString &username, const QJsonObject &fields,
+                                                    QJsonObject *merged)
+{
+    QMutexLocker locker(&mutex);
+    refreshCredentials();
+    if (!passwords.contains(username)) {
+        return EditResult::NotFound;
+    }
+    refreshProfiles();
+    QJsonObject info = profiles.value(username).toObject();
+    for (auto it = fields.begin(); it != fields.end(); ++it) {
+        info[it.key()] = it.value();
+    }
+    if (merged) {
+        *merged = info;
+    }
+    profiles[username] = info;
+    return writeProfiles() ? EditResult::Done : EditResult::WriteFailed;
+}
+
+AccountStore::BatchResult AccountStore::applyBatch(const QList<Change> &changes)
+{
+    BatchResult result;
+    QMutexLocker locker(&mutex);
+    refreshCredentials();
+    refreshProfiles();
+    const QJsonObject previousProfiles = profiles;
+
+    // Accounts are edited in place by index; dropped ones are blanked and
+    // left out when the array is written back
+    const QJsonArray users = credentialRoot.value("users").toArray();
+    QList<QJsonObject> accountList;
+    accountList.reserve(users.size() + changes.size());
+    QMultiHash<QString, qsizetype> indexOf;
+    for (const QJsonValue &value : users) {
+        const QJsonObject account = value.toObject();
+        indexOf.insert(account.value("username").toString(), accountList.size());
+        accountList.append(account);
+    }
+
+    bool profilesChanged = false;
+    for (const Change &change : changes) {
+        if (change.username.isEmpty()) {
+            result.errors.append("A row has no username");
+            continue;
+        }
+
+        const QList<qsizetype> indices = indexOf.values(change.username);
+        if (change.drop) {
+            if (indices.isEmpty()) {
+                result.errors.append(change.username + ": not found, not dropped");
+                continue;
+            }
+            for (qsizetype index : indices) {
+                accountList[index] = QJsonObject();
+            }
+            indexOf.remove(change.username);
+            profilesChanged |= profiles.contains(change.username);
+            profiles.remove(change.username);
+            ++result.dropped;
+            continue;
+        }
+
+        if (indices.isEmpty()) {
+            if (change.password.isEmpty()) {
+                result.errors.append(change.username + ": new account without a password");
+                continue;
+            }
+            QJsonObject account;
+            account["username"] = change.username;
+            account["password"] = change.password;
+            indexOf.insert(change.username, accountList.size());
+            accountList.append(account);
+            ++result.added;
+        } else {
+            if (!change.password.isEmpty()) {
+                for (qsizetype index : indices) {
+                    accountList[index]["password"] = change.password;
+                }
+            }
+            ++result.updated;
+        }
+
+        if (!change.profile.isEmpty()) {
+            QJsonObject info = profiles.value(change.username).toObject();
+            for (auto it = change.profile.begin(); it != change.profile.end(); ++it) {
+                info[it.key()] = it.value();
+            }
+            profiles[change.username] = info;
+            profilesChanged = true;
+        }
+    }
+
+    QJsonArray updatedUsers;
+    for (const QJsonObject &account : std::as_const(accountList)) {
+        if (!account.isEmpty()) {
+            updatedUsers.append(account);
+        }
+    }
+    QJsonObject accounts = credentialRoot;
+    accounts["users"] = updatedUsers;
+
+    // Profiles first, as in writeCredentials. If account.json then fails the
+    // previous profiles are written back, so a failed batch changes nothing,
+    // and both caches are read back from disk.
+    if (profilesChanged && !writeProfiles()) {
+        return result;
+    }
+    result.ok = writeCredentials(accounts);
+    if (!result.ok && profilesChanged) {
+        profiles = previousProfiles;
+        if (!writeProfiles()) {
+            qCWarning(serverCategory) << "applyBatch: Couldn't restore" << store.profilesFilePath()
+                                      << "after account.json failed; it holds the batch's profile changes";
+        }
+        profilesLoaded = false;
+        credentialsLoaded = false;
+    }
+    return result;
+}
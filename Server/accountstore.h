@@ -0,0 +1,140 @@
+#ifndef ACCOUNTSTORE_H
+#define ACCOUNTSTORE_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QMultiHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include "passwordhash.h"
+#include "timesheetstore.h"
+
+// Accounts in two tiers. Credentials are small and read on every login, so
+// they stay parsed in memory and account.json is only re-read when it changes
+// on disk. Profiles (the info objects behind showInfo and saveInfo) live in
+// profiles.json, which is not touched until a profile is first asked for.
+// Info objects found in account.json, as older servers wrote them, are moved
+// to profiles.json the first time the credentials are loaded or saved.
+//
+// Passwords are stored as PasswordHash strings. Plaintext entries left by
+// older servers still log in; AccountWorker::upgradePasswords replaces all of
+// them with hashes in one write, so a login never rewrites account.json.
+class AccountStore
+{
+public:
+    // One row of a bulk import: an account to add or update, or to drop
+    struct Change {
+        QString username;
+        QString password;    // As stored, a PasswordHash string; empty keeps the current one
+        QJsonObject profile; // Fields to set; the others are kept
+        bool drop = false;
+    };
+    struct BatchResult {
+        bool ok = false;
+        int added = 0;
+        int updated = 0;
+        int dropped = 0;
+        QStringList errors; // Rows that were skipped
+    };
+
+    enum class EditResult { Done, Exists, NotFound, WriteFailed };
+
+    // A plaintext password still in account.json and what replaces it
+    struct PasswordUpgrade {
+        QString username;
+        QString plaintext;
+        QString hash;
+    };
+
+    explicit AccountStore(const QString &baseDir);
+
+    void setHashIterations(int iterations);
+    // What to store as the password of a new account
+    QString hashPassword(const QString &password) const;
+
+    // Runs the slow hash outside the lock, so concurrent logins do not queue.
+    // An unknown username costs the same hash, so the time taken does not
+    // tell whether it exists.
+    bool checkCredentials(const QString &username, const QString &password);
+    bool contains(const QString &username);
+    // Short digest of the stored password, put in session tokens; it changes
+    // with the password and is empty once the account is gone. Read from a
+    // snapshot taken whenever the credentials are loaded or written, so it
+    // neither waits for the lock nor stats account.json.
+    QByteArray credentialTag(const QString &username);
+
+    bool hasPlaintextPasswords();
+    // Every plaintext entry, without its hash yet
+    QList<PasswordUpgrade> plaintextPasswords();
+    // Stores the hashes of the entries that are still the same plaintext, in
+    // one write; the number replaced, or -1 when the write failed
+    int applyPasswordUpgrades(const QList<PasswordUpgrade> &upgrades);
+
+    // {"users": [{username, password}]}
+    QJsonObject accounts();
+    // Replaces every account; info objects in it go to the profile store
+    bool saveAccounts(const QJsonObject &accounts);
+
+    bool hasProfile(const QString &username);
+    // Empty when the user has no profile
+    QJsonObject profile(const QString &username);
+    // {username: info} of every account that has a profile
+    QJsonObject allProfiles();
+    bool setProfile(const QString &username, const QJsonObject &info);
+    bool removeProfile(const QString &username);
+
+    // Single-account edits, each checked and written under one lock so a
+    // concurrent login upgrade or profile save is never overwritten.
+    // storedPassword is a PasswordHash string.
+    EditResult addAccount(const QString &username, const QString &storedPassword);
+    // Drops the account and its profile
+    EditResult removeAccount(const QString &username);
+    // Sets these fields on the profile and keeps the others; merged gets the result
+    EditResult mergeProfile(const QString &username, const QJsonObject &fields, QJsonObject *merged = nullptr);
+
+    // Applies all changes in order, then writes profiles.json and
+    // account.json once each. A new account without a password is skipped.
+    BatchResult applyBatch(const QList<Change> &changes);
+
+private:
+    struct FileStamp {
+        qint64 size = -1;
+        QDateTime modified;
+
+        bool operator==(const FileStamp &other) const
+        {
+            return size == other.size && modified == other.modified;
+        }
+    };
+
+    static FileStamp stampOf(const QString &filePath);
+    // Called with the mutex held
+    void refreshCredentials();
+    void refreshProfiles();
+    void cacheCredentials(const QJsonObject &accounts);
+    // Update the caches only once the file is written
+    bool writeCredentials(QJsonObject accounts);
+    bool writeProfiles();
+    QString unknownUserHash();
+
+    TimesheetStore store;
+    int hashIterations = PasswordHash::defaultIterations;
+    QString dummyHash; // Verified against for unknown usernames, made on first use
+
+    QMutex mutex;
+    bool credentialsLoaded = false;
+    FileStamp credentialStamp;
+    QJsonObject credentialRoot;
+    QMultiHash<QString, QString> passwords; // username -> stored password; account.json allows duplicates
+    int plaintextCount = 0;
+    // username -> credentialTag of the cached passwords, swapped with std::atomic_store
+    std::shared_ptr<const QHash<QString, QByteArray>> credentialTags;
+
+    bool profilesLoaded = false;
+    FileStamp profileStamp;
+    QJsonObject profiles; // username -> info
+};
+
+#endif // ACCOUNTSTORE_H
@@ -0,0 +1,258 @@
+#include "accounttransfer.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QSaveFile>
+#include <QSet>
+#include <QTextStream>
+#include <algorithm>
+
+// Profile fields the client edits, first and in this order; others follow sorted
+static const QStringList knownProfileFields = {"Fullname", "Birthday", "Sex", "Email", "Tel"};
+
+bool AccountTransfer::isCsv(const QString &filePath)
+{
+    return QFileInfo(filePath).suffix().compare("csv", Qt::CaseInsensitive) == 0;
+}
+
+// Next record of the stream into cells; quoted cells may span lines
+static bool readCsvRecord(QTextStream &in, QStringList &cells, qint64 &lineNumber)
+{
+    cells.clear();
+    if (in.atEnd()) {
+        return false;
+    }
+
+    QString cell;
+    bool quoted = false;
+    QString line = in.readLine();
+    ++lineNumber;
+    for (;;) {
+        for (qsizetype i = 0; i < line.size(); ++i) {
+            const QChar c = line.at(i);
+            if (quoted) {
+                if (c != QLatin1Char('"')) {
+                    cell.append(c);
+                } else if (i + 1 < line.size() && line.at(i + 1) == QLatin1Char('"')) {
+                    cell.append(c);
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else if (c == QLatin1Char('"')) {
+                quoted = true;
+            } else if (c == QLatin1Char(',')) {
+                cells.append(cell);
+                cell.clear();
+            } else {
+                cell.append(c);
+            }
+        }
+        if (!quoted || in.atEnd()) {
+            break;
+        }
+        cell.append(QLatin1Char('\n'));
+        line = in.readLine();
+        ++lineNumber;
+    }
+    cells.append(cell);
+    return true;
+}
+
+QString AccountTransfer::csvCell(const QString &value)
+{
+    if (!value.contains(QLatin1Char(',')) && !value.contains(QLatin1Char('"')) && !value.contains(QLatin1Char('\n'))
+        && !value.contains(QLatin1Char('\r'))) {
+        return value;
+    }
+    QString quoted = value;
+    quoted.replace(QLatin1String("\""), QLatin1String("\"\""));
+    return QLatin1Char('"') + quoted + QLatin1Char('"');
+}
+
+// Applies the action column or field; false when it is not one we know
+static bool applyAction(AccountStore::Change &change, const QString &action)
+{
+    const QString normalized = action.trimmed().toLower();
+    if (normalized == "drop") {
+        change.drop = true;
+        return true;
+    }
+    return normalized.isEmpty() || normalized == "add";
+}
+
+AccountTransfer::ReadResult AccountTransfer::read(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        ReadResult result;
+        result.errors.append(QString("Couldn't open %1: %2").arg(filePath, file.errorString()));
+        return result;
+    }
+    return isCsv(filePath) ? readCsv(&file) : readJsonLines(&file);
+}
+
+AccountTransfer::ReadResult AccountTransfer::readCsv(QIODevice *device)
+{
+    ReadResult result;
+    QTextStream in(device);
+    qint64 lineNumber = 0;
+
+    QStringList header;
+    if (!readCsvRecord(in, header, lineNumber)) {
+        result.errors.append("The file is empty");
+        return result;
+    }
+    for (QString &name : header) {
+        name = name.trimmed();
+    }
+    const qsizetype usernameColumn = header.indexOf("username");
+    const qsizetype passwordColumn = header.indexOf("password");
+    const qsizetype actionColumn = header.indexOf("action");
+    if (usernameColumn < 0) {
+        result.errors.append("The header has no username column");
+        return result;
+    }
+
+    QStringList cells;
+    for (qint64 first = lineNumber + 1; readCsvRecord(in, cells, lineNumber); first = lineNumber + 1) {
+        if (cells.size() == 1 && cells.first().trimmed().isEmpty()) {
+            continue; // Blank line
+        }
+        if (cells.size() != header.size()) {
+            result.errors.append(QString("Line %1: %2 cells, the header has %3").arg(first).arg(cells.size()).arg(header.size()));
+            continue;
+        }
+
+        AccountStore::Change change;
+        change.username = cells.at(usernameColumn).trimmed();
+        if (passwordColumn >= 0) {
+            change.password = cells.at(passwordColumn);
+        }
+        if (actionColumn >= 0 && !applyAction(change, cells.at(actionColumn))) {
+            result.errors.append(QString("Line %1: unknown action %2").arg(first).arg(cells.at(actionColumn)));
+            continue;
+        }
+        for (qsizetype column = 0; column < header.size(); ++column) {
+            if (column != usernameColumn && column != passwordColumn && column != actionColumn
+                && !cells.at(column).isEmpty()) {
+                change.profile[header.at(column)] = cells.at(column);
+            }
+        }
+        result.changes.append(change);
+    }
+    return result;
+}
+
+AccountTransfer::ReadResult AccountTransfer::readJsonLines(QIODevice *device)
+{
+    ReadResult result;
+    qint64 lineNumber = 0;
+    while (!device->atEnd()) {
+        const QByteArray line = device->readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            result.errors.append(QString("Line %1: %2").arg(lineNumber).arg(
+                parseError.error != QJsonParseError::NoError ? parseError.errorString() : QString("not an object")));
+            continue;
+        }
+
+        const QJsonObject obj = doc.object();
+        AccountStore::Change change;
+        change.username = obj.value("username").toString().trimmed();
+        change.password = obj.value("password").toString();
+        change.profile = obj.value("info").toObject();
+        if (!applyAction(change, obj.value("action").toString())) {
+            result.errors.append(QString("Line %1: unknown action %2").arg(lineNumber).arg(obj.value("action").toString()));
+            continue;
+        }
+        result.changes.append(change);
+    }
+    return result;
+}
+
+bool AccountTransfer::write(const QString &filePath, const QJsonObject &accounts, const QJsonObject &profiles,
+                            QString *error)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    if (isCsv(filePath)) {
+        writeCsv(&file, accounts, profiles);
+    } else {
+        writeJsonLines(&file, accounts, profiles);
+    }
+    if (!file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+void AccountTransfer::writeCsv(QIODevice *device, const QJsonObject &accounts, const QJsonObject &profiles)
+{
+    QSet<QString> otherFields;
+    for (auto it = profiles.begin(); it != profiles.end(); ++it) {
+        const QStringList keys = it.value().toObject().keys();
+        for (const QString &key : keys) {
+            if (!knownProfileFields.contains(key)) {
+                otherFields.insert(key);
+            }
+        }
+    }
+    QStringList fields = knownProfileFields;
+    QStringList sortedOthers = otherFields.values();
+    std::sort(sortedOthers.begin(), sortedOthers.end());
+    fields.append(sortedOthers);
+
+    QTextStream out(device);
+    QStringList header = {"username", "password"};
+    for (const QString &field : std::as_const(fields)) {
+        header.append(csvCell(field));
+    }
+    out << header.join(QLatin1Char(',')) << '\n';
+
+    const QJsonArray users = accounts.value("users").toArray();
+    QStringList row;
+    for (const QJsonValue &value : users) {
+        const QJsonObject account = value.toObject();
+        const QString username = account.value("username").toString();
+        const QJsonObject info = profiles.value(username).toObject();
+
+        row.clear();
+        row.append(csvCell(username));
+        row.append(csvCell(account.value("password").toString()));
+        for (const QString &field : std::as_const(fields)) {
+            row.append(csvCell(info.value(field).toString()));
+        }
+        out << row.join(QLatin1Char(',')) << '\n';
+    }
+}
+
+void AccountTransfer::writeJsonLines(QIODevice *device, const QJsonObject &accounts, const QJsonObject &profiles)
+{
+    const QJsonArray users = accounts.value("users").toArray();
+    for (const QJsonValue &value : users) {
+        QJsonObject account = value.toObject();
+        const QJsonObject info = profiles.value(account.value("username").toString()).toObject();
+        if (!info.isEmpty()) {
+            account["info"] = info;
+        }
+        device->write(QJsonDocument(account).toJson(QJsonDocument::Compact));
+        device->write("\n");
+    }
+}
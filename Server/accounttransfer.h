@@ -0,0 +1,50 @@
+#ifndef ACCOUNTTRANSFER_H
+#define ACCOUNTTRANSFER_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "accountstore.h"
+
+class QIODevice;
+
+// Reads and writes accounts with their profiles for bulk import and export,
+// one record at a time, in two formats picked by file suffix:
+//
+//   .csv    A header row, then one row per account. username is required;
+//           password and action (add, the default, or drop) are optional;
+//           every other column is a profile field, e.g. Fullname or Email.
+//           Empty cells leave the current value alone.
+//   .jsonl  One object per line, as in account.json:
+//           {"username", "password", "info": {...}, "action": "drop"}
+//
+// Passwords are read as given; plaintext ones still have to be hashed before
+// the changes go to AccountStore::applyBatch. Exports carry the stored hashes,
+// so an export imports into another server unchanged.
+class AccountTransfer
+{
+public:
+    struct ReadResult {
+        QList<AccountStore::Change> changes;
+        QStringList errors; // Lines that could not be read
+    };
+
+    static ReadResult read(const QString &filePath);
+    static ReadResult readCsv(QIODevice *device);
+    static ReadResult readJsonLines(QIODevice *device);
+
+    // Replaces the file only once everything is written
+    static bool write(const QString &filePath, const QJsonObject &accounts, const QJsonObject &profiles,
+                      QString *error = nullptr);
+    static void writeCsv(QIODevice *device, const QJsonObject &accounts, const QJsonObject &profiles);
+    static void writeJsonLines(QIODevice *device, const QJsonObject &accounts, const QJsonObject &profiles);
+
+    // The value as one CSV cell, quoted when it holds a comma, quote or line break
+    static QString csvCell(const QString &value);
+
+private:
+    static bool isCsv(const QString &filePath);
+};
+
+#endif // ACCOUNTTRANSFER_H
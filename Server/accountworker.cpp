@@ -0,0 +1,184 @@
+#include "accountworker.h"
+#include "accountstore.h"
+#include "accounttransfer.h"
+#include "passwordhash.h"
+#include "requestlog.h"
+#include "tracer.h"
+#include <QJsonArray>
+#include <QLoggingCategory>
+#include <QtConcurrent>
+
+Q_DECLARE_LOGGING_CATEGORY(serverCategory)
+
+AccountWorker::AccountWorker(AccountStore *store, QObject *parent)
+    : QObject(parent),
+    store(store)
+{
+}
+
+void AccountWorker::verifyLogin(quint64 ticket, const QString &username, const QString &password)
+{
+    loginPool.start([this, ticket, username, password]() {
+        TraceSpan span("verifyLogin", "storage");
+        const bool ok = store->checkCredentials(username, password);
+        // account.json changed on disk with plaintext in it; hash it all in one go
+        if (ok && !upgradeQueued.load(std::memory_order_relaxed) && store->hasPlaintextPasswords()) {
+            scheduleUpgradePasswords();
+        }
+        emit loginVerified(ticket, username, ok);
+    });
+}
+
+void AccountWorker::scheduleUpgradePasswords()
+{
+    if (!upgradeQueued.exchange(true)) {
+        QMetaObject::invokeMethod(this, &AccountWorker::upgradePasswords, Qt::QueuedConnection);
+    }
+}
+
+void AccountWorker::upgradePasswords()
+{
+    TraceSpan span("upgradePasswords", "storage");
+    upgradeQueued.store(false);
+    QList<AccountStore::PasswordUpgrade> upgrades = store->plaintextPasswords();
+    if (upgrades.isEmpty()) {
+        return;
+    }
+
+    QtConcurrent::blockingMap(upgrades, [this](AccountStore::PasswordUpgrade &upgrade) {
+        upgrade.hash = store->hashPassword(upgrade.plaintext);
+    });
+
+    StorageTimer storageTimer;
+    const int replaced = store->applyPasswordUpgrades(upgrades);
+    storageTimer.stop();
+    if (replaced < 0) {
+        qCWarning(serverCategory) << "upgradePasswords: Couldn't write" << upgrades.size() << "hashed passwords";
+    } else {
+        qCInfo(serverCategory) << "upgradePasswords: Replaced" << replaced << "plaintext passwords with hashes";
+    }
+}
+
+void AccountWorker::createAccount(const QString &username, const QString &password)
+{
+    TraceSpan span("createAccount", "storage");
+    if (username.isEmpty()) {
+        emit accountCreated(username, false, "Username is empty");
+        return;
+    }
+    // Checked again under the store lock; this only saves hashing for a taken name
+    if (store->contains(username)) {
+        emit accountCreated(username, false, "Username already exists");
+        return;
+    }
+
+    const QString hash = store->hashPassword(password);
+    StorageTimer storageTimer;
+    switch (store->addAccount(username, hash)) {
+    case AccountStore::EditResult::Done:
+        emit accountCreated(username, true, QString());
+        break;
+    case AccountStore::EditResult::Exists:
+        emit accountCreated(username, false, "Username already exists");
+        break;
+    default:
+        emit accountCreated(username, false, "Couldn't save the accounts");
+        break;
+    }
+}
+
+void AccountWorker::dropAccount(const QString &username)
+{
+    TraceSpan span("dropAccount", "storage");
+    StorageTimer storageTimer;
+    switch (store->removeAccount(username)) {
+    case AccountStore::EditResult::Done:
+        emit accountDropped(username, true, QString());
+        break;
+    case AccountStore::EditResult::NotFound:
+        emit accountDropped(username, false, "Username not exist");
+        break;
+    default:
+        emit accountDropped(username, false, "Couldn't save the accounts");
+        break;
+    }
+}
+
+void AccountWorker::changeProfile(const QString &username, const QJsonObject &fields)
+{
+    TraceSpan span("changeProfile", "storage");
+    // Empty fields in the admin form leave the current value alone
+    QJsonObject changed;
+    for (auto it = fields.begin(); it != fields.end(); ++it) {
+        if (!it.value().toString().isEmpty()) {
+            changed[it.key()] = it.value();
+        }
+    }
+
+    StorageTimer storageTimer;
+    QJsonObject profile;
+    switch (store->mergeProfile(username, changed, &profile)) {
+    case AccountStore::EditResult::Done:
+        emit profileChanged(username, profile, true, QString());
+        break;
+    case AccountStore::EditResult::NotFound:
+        emit profileChanged(username, QJsonObject(), false, "Username not exist");
+        break;
+    default:
+        emit profileChanged(username, profile, false, "Couldn't save the profile");
+        break;
+    }
+}
+
+void AccountWorker::registerAccount(quint64 ticket, const QString &username, const QString &password)
+{
+    TraceSpan span("registerAccount", "storage");
+    if (store->contains(username)) {
+        emit accountRegistered(ticket, username, "userExist");
+        return;
+    }
+
+    const QString hash = store->hashPassword(password);
+    StorageTimer storageTimer;
+    switch (store->addAccount(username, hash)) {
+    case AccountStore::EditResult::Done:
+        emit accountRegistered(ticket, username, "newUser");
+        break;
+    case AccountStore::EditResult::Exists:
+        emit accountRegistered(ticket, username, "userExist");
+        break;
+    default:
+        emit accountRegistered(ticket, username, "Failed to save data");
+        break;
+    }
+}
+
+void AccountWorker::importAccounts(const QString &filePath)
+{
+    TraceSpan span("importAccounts", "storage");
+    AccountTransfer::ReadResult read = AccountTransfer::read(filePath);
+
+    // Hashing dominates a large import, so plaintext passwords are hashed on
+    // every core; hashes from an export are kept as they are
+    QtConcurrent::blockingMap(read.changes, [this](AccountStore::Change &change) {
+        if (!change.password.isEmpty() && !PasswordHash::isHash(change.password)) {
+            change.password = store->hashPassword(change.password);
+        }
+    });
+
+    StorageTimer storageTimer;
+    const AccountStore::BatchResult result = store->applyBatch(read.changes);
+    storageTimer.stop();
+    emit accountsImported(filePath, result.ok, result.added, result.updated, result.dropped,
+                          read.errors + result.errors);
+}
+
+void AccountWorker::exportAccounts(const QString &filePath)
+{
+    TraceSpan span("exportAccounts", "storage");
+    StorageTimer storageTimer;
+    const QJsonObject accounts = store->accounts();
+    QString error;
+    const bool ok = AccountTransfer::write(filePath, accounts, store->allProfiles(), &error);
+    emit accountsExported(filePath, ok, int(accounts.value("users").toArray().size()), error);
+}
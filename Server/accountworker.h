@@ -0,0 +1,64 @@
+#ifndef ACCOUNTWORKER_H
+#define ACCOUNTWORKER_H
+
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+
+class AccountStore;
+
+// Account mutations from the admin window and from Register, run one at a
+// time on their own thread. Rewriting account.json and hashing a password
+// both take long enough on a large roster to stall the window and every TCP
+// client, so callers only queue a job and act on its signal. Each edit is
+// checked and written under the AccountStore lock, so a client saving its
+// profile on the GUI thread is never lost.
+class AccountWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AccountWorker(AccountStore *store, QObject *parent = nullptr);
+
+    // Checks a login on the worker's login pool and answers with
+    // loginVerified. Callable from any thread: logins neither wait behind
+    // an import on the worker thread nor behind each other.
+    void verifyLogin(quint64 ticket, const QString &username, const QString &password);
+    // Queues upgradePasswords unless a run is already queued
+    void scheduleUpgradePasswords();
+
+public slots:
+    void createAccount(const QString &username, const QString &password);
+    void dropAccount(const QString &username);
+    // Sets the non-empty fields on the user's profile
+    void changeProfile(const QString &username, const QJsonObject &fields);
+    void registerAccount(quint64 ticket, const QString &username, const QString &password);
+    // A CSV or JSON-lines file, see AccountTransfer, applied as one batch
+    void importAccounts(const QString &filePath);
+    void exportAccounts(const QString &filePath);
+    // Hashes every plaintext password left by older servers on all cores and
+    // writes account.json once, instead of once per first login
+    void upgradePasswords();
+
+signals:
+    void accountCreated(const QString &username, bool ok, const QString &error);
+    void accountDropped(const QString &username, bool ok, const QString &error);
+    void profileChanged(const QString &username, const QJsonObject &profile, bool ok, const QString &error);
+    // response is what the client gets: newUser, userExist or Failed to save data
+    void accountRegistered(quint64 ticket, const QString &username, const QString &response);
+    void loginVerified(quint64 ticket, const QString &username, bool ok);
+    // errors lists the rows that were skipped
+    void accountsImported(const QString &filePath, bool ok, int added, int updated, int dropped,
+                          const QStringList &errors);
+    void accountsExported(const QString &filePath, bool ok, int count, const QString &error);
+
+private:
+    AccountStore *store;
+    QThreadPool loginPool; // Waits for running checks when the worker is deleted
+    std::atomic<bool> upgradeQueued{false};
+};
+
+#endif // ACCOUNTWORKER_H
@@ -0,0 +1,231 @@
+#include "asyncfilesink.h"
+#include "clock.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+#include <QDateTime>
+
+AsyncFileSink::AsyncFileSink(const QString &dir, const QString &baseName, const QString &suffix,
+                             qint64 maxFileBytes, int maxFiles, int capacity)
+    : dir(dir),
+    baseName(baseName),
+    suffix(suffix),
+    maxFileBytes(maxFileBytes),
+    maxFiles(maxFiles),
+    capacity(qMax(2, capacity)),
+    ring(new Slot[qMax(2, capacity)])
+{
+    for (quint64 i = 0; i < this->capacity; ++i) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+AsyncFileSink::~AsyncFileSink()
+{
+    stop();
+}
+
+void AsyncFileSink::start()
+{
+    if (running.exchange(true)) {
+        return;
+    }
+    writer = QThread::create([this]() { run(); });
+    writer->setObjectName(baseName + "-writer");
+    writer->start(QThread::LowPriority);
+}
+
+void AsyncFileSink::stop()
+{
+    if (running.exchange(false)) {
+        {
+            QMutexLocker locker(&wakeMutex);
+            wakeWriter.wakeOne();
+        }
+        writer->wait();
+        delete writer;
+        writer = nullptr;
+    }
+    // Whatever producers pushed after the writer's last pass
+    drain();
+    if (file.isOpen()) {
+        file.close();
+    }
+}
+
+void AsyncFileSink::flush()
+{
+    if (!running.load()) {
+        return;
+    }
+    if (QThread::currentThread() == writer) {
+        return;
+    }
+    const quint64 request = flushRequest.fetch_add(1) + 1;
+    QMutexLocker locker(&wakeMutex);
+    wakeWriter.wakeOne();
+    while (flushDone.load() < request && running.load()) {
+        flushed.wait(&wakeMutex, 100);
+    }
+}
+
+bool AsyncFileSink::append(QByteArray record)
+{
+    quint64 pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    for (;;) {
+        slot = &ring[pos % capacity];
+        const quint64 sequence = slot->sequence.load(std::memory_order_acquire);
+        const qint64 diff = qint64(sequence) - qint64(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The writer has not freed this slot yet: buffer full
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->record = std::move(record);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool AsyncFileSink::pop(QByteArray *record)
+{
+    Slot *slot = &ring[dequeuePos % capacity];
+    if (slot->sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+        return false;
+    }
+    *record = std::move(slot->record);
+    slot->record = QByteArray();
+    slot->sequence.store(dequeuePos + capacity, std::memory_order_release);
+    ++dequeuePos;
+    return true;
+}
+
+void AsyncFileSink::run()
+{
+    while (running.load()) {
+        const int written = drain();
+
+        const quint64 request = flushRequest.load();
+        if (request != flushDone.load()) {
+            if (file.isOpen()) {
+                file.flush();
+            }
+            QMutexLocker locker(&wakeMutex);
+            flushDone.store(request);
+            flushed.wakeAll();
+            continue;
+        }
+
+        if (written == 0) {
+            // Idle: push buffered bytes out and sleep. Producers never signal,
+            // the timeout bounds how long a record waits in the buffer.
+            if (file.isOpen()) {
+                file.flush();
+            }
+            QMutexLocker locker(&wakeMutex);
+            if (running.load() && flushRequest.load() == flushDone.load()) {
+                wakeWriter.wait(&wakeMutex, 100);
+            }
+        }
+    }
+}
+
+int AsyncFileSink::drain()
+{
+    int written = 0;
+    QByteArray record;
+    while (pop(&record)) {
+        writeRecord(record);
+        ++written;
+    }
+
+    const quint64 droppedNow = dropped.load(std::memory_order_relaxed);
+    if (droppedNow != droppedReported) {
+        // Plain text note; JSON readers of the line-based sinks skip lines that do not parse
+        writeRecord(Clock::instance().now().toString("yyyy-MM-dd hh:mm:ss.zzz").toUtf8()
+                    + " [Warning] " + QByteArray::number(droppedNow - droppedReported)
+                    + " records dropped, buffer full");
+        droppedReported = droppedNow;
+    }
+    return written;
+}
+
+void AsyncFileSink::writeRecord(const QByteArray &record)
+{
+    const QDate today = Clock::instance().today();
+    if (!file.isOpen() || today != fileDate) {
+        fileDate = today;
+        fileIndex = 0;
+        openFile();
+    } else if (maxFileBytes > 0 && fileBytes + record.size() + 1 > maxFileBytes) {
+        ++fileIndex;
+        openFile();
+    }
+    if (!file.isOpen()) {
+        return;
+    }
+
+    file.write(record);
+    file.write("\n", 1);
+    fileBytes += record.size() + 1;
+}
+
+// Opens today's file with the current index, skipping indexes whose file is
+// already full (a restart on the same day appends to the last one)
+void AsyncFileSink::openFile()
+{
+    if (file.isOpen()) {
+        file.close();
+    }
+
+    QDir logDir(dir);
+    if (!logDir.exists() && !logDir.mkpath(".")) {
+        fprintf(stderr, "AsyncFileSink: Couldn't create %s\n", qPrintable(dir));
+        return;
+    }
+
+    const QString datePart = fileDate.toString("yyyy-MM-dd");
+    QString filePath;
+    for (;;) {
+        filePath = dir + "/" + baseName + "-" + datePart
+                   + (fileIndex > 0 ? "." + QString::number(fileIndex) : QString())
+                   + "." + suffix;
+        if (maxFileBytes <= 0 || QFileInfo(filePath).size() < maxFileBytes) {
+            break;
+        }
+        ++fileIndex;
+    }
+
+    file.setFileName(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        fprintf(stderr, "AsyncFileSink: Couldn't open %s: %s\n", qPrintable(filePath), qPrintable(file.errorString()));
+        return;
+    }
+    fileBytes = file.size();
+    if (fileBytes == 0 && !fileHeader.isEmpty()) {
+        file.write(fileHeader);
+        file.write("\n", 1);
+        fileBytes = fileHeader.size() + 1;
+    }
+    removeOldFiles();
+}
+
+void AsyncFileSink::removeOldFiles()
+{
+    if (maxFiles <= 0) {
+        return;
+    }
+    const QFileInfoList files = QDir(dir).entryInfoList({baseName + "-*." + suffix}, QDir::Files, QDir::Time);
+    for (int i = maxFiles; i < files.size(); ++i) {
+        QFile::remove(files.at(i).absoluteFilePath());
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef ASYNCFILESINK_H
+#define ASYNCFILESINK_H
+
+#include <QByteArray>
+#include <QDate>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+
+class QThread;
+
+// Append-only file sink for line records. Producers push into a bounded
+// lock-free ring buffer (any thread, never blocks, never touches the disk) and
+// a background writer thread drains it into <dir>/<baseName>-<date>.<suffix>.
+// Files roll over at midnight and whenever they grow past maxFileBytes; only
+// the newest maxFiles files are kept. When the buffer is full the record is
+// dropped and counted, and the writer notes the loss in the file.
+class AsyncFileSink
+{
+public:
+    AsyncFileSink(const QString &dir, const QString &baseName, const QString &suffix,
+                  qint64 maxFileBytes = 10 * 1024 * 1024, int maxFiles = 20,
+                  int capacity = 8192);
+    ~AsyncFileSink();
+
+    AsyncFileSink(const AsyncFileSink &) = delete;
+    AsyncFileSink &operator=(const AsyncFileSink &) = delete;
+
+    // Written first to every new file, e.g. the opening bracket of a JSON array
+    void setFileHeader(const QByteArray &header) { fileHeader = header; }
+
+    void start();
+    // Drains what is left in the buffer and stops the writer thread
+    void stop();
+    // Blocks until every record pushed so far is on disk (used before a fatal abort)
+    void flush();
+
+    // Returns false when the buffer was full and the record was dropped.
+    // A trailing newline is added by the writer.
+    bool append(QByteArray record);
+
+    quint64 droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<quint64> sequence;
+        QByteArray record;
+    };
+
+    bool pop(QByteArray *record);
+    void run();
+    int drain();
+    void writeRecord(const QByteArray &record);
+    void openFile();
+    void removeOldFiles();
+
+    QString dir;
+    QString baseName;
+    QString suffix;
+    qint64 maxFileBytes;
+    int maxFiles;
+    QByteArray fileHeader;
+
+    // Bounded multi-producer queue (sequence-numbered slots), single consumer
+    const quint64 capacity;
+    std::unique_ptr<Slot[]> ring;
+    alignas(64) std::atomic<quint64> enqueuePos{0};
+    alignas(64) quint64 dequeuePos = 0;
+    std::atomic<quint64> dropped{0};
+    quint64 droppedReported = 0;
+
+    // Writer thread state, only touched by the writer
+    QFile file;
+    QDate fileDate;
+    int fileIndex = 0;
+    qint64 fileBytes = 0; // QFile::size() would flush on every call
+
+    QThread *writer = nullptr;
+    std::atomic<bool> running{false};
+    std::atomic<quint64> flushRequest{0};
+    std::atomic<quint64> flushDone{0};
+    mutable QMutex wakeMutex;
+    QWaitCondition wakeWriter;
+    QWaitCondition flushed;
+};
+
+#endif // ASYNCFILESINK_H
@@ -0,0 +1,36 @@
+#include "clock.h"
+
+static SystemClock systemClock;
+static std::atomic<Clock *> currentClock{&systemClock};
+
+Clock &Clock::instance()
+{
+    return *currentClock.load(std::memory_order_acquire);
+}
+
+void Clock::setInstance(Clock *clock)
+{
+    currentClock.store(clock ? clock : &systemClock, std::memory_order_release);
+}
+
+VirtualClock::VirtualClock(const QDateTime &start, double rate)
+    : startMs(start.toMSecsSinceEpoch()),
+    speed(rate)
+{
+    elapsed.start();
+}
+
+qint64 VirtualClock::runningMs() const
+{
+    return startMs + qint64(elapsed.elapsed() * speed);
+}
+
+QDateTime VirtualClock::now() const
+{
+    return QDateTime::fromMSecsSinceEpoch(runningMs() + offsetMs.load(std::memory_order_relaxed));
+}
+
+void VirtualClock::set(const QDateTime &time)
+{
+    offsetMs.store(time.toMSecsSinceEpoch() - runningMs(), std::memory_order_relaxed);
+}
@@ -0,0 +1,64 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <QDate>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QTime>
+#include <atomic>
+
+// Source of wall-clock time for everything that depends on the date or time
+// of day: status and points files, the timesheet, log file rotation. The
+// server normally runs on the system clock; started with --virtual-clock it
+// runs on a VirtualClock that a test harness can fast-forward, so a workday
+// (and its midnight rollover) can be simulated without waiting for it.
+class Clock
+{
+public:
+    virtual ~Clock() = default;
+
+    virtual QDateTime now() const = 0;
+
+    QDate today() const { return now().date(); }
+    // Time of day to the second, the resolution of the status files
+    QTime timeOfDay() const
+    {
+        const QTime time = now().time();
+        return QTime(time.hour(), time.minute(), time.second());
+    }
+
+    // The process-wide clock; the system clock unless another was installed.
+    // Install before any thread reads it and keep it alive until exit.
+    static Clock &instance();
+    static void setInstance(Clock *clock);
+};
+
+class SystemClock : public Clock
+{
+public:
+    QDateTime now() const override { return QDateTime::currentDateTime(); }
+};
+
+// Starts at a given time and runs rate times faster than real time (rate 0
+// stops it). set() and advance() jump it; both are safe from any thread.
+class VirtualClock : public Clock
+{
+public:
+    explicit VirtualClock(const QDateTime &start, double rate = 1.0);
+
+    QDateTime now() const override;
+
+    void set(const QDateTime &time);
+    void advance(qint64 msecs) { offsetMs.fetch_add(msecs, std::memory_order_relaxed); }
+    double rate() const { return speed; }
+
+private:
+    qint64 runningMs() const;
+
+    const qint64 startMs;
+    const double speed;
+    QElapsedTimer elapsed;
+    std::atomic<qint64> offsetMs{0};
+};
+
+#endif // CLOCK_H
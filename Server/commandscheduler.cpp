@@ -0,0 +1,168 @@
+#include "commandscheduler.h"
+#include "metrics.h"
+#include <QHostAddress>
+#include <QMetaObject>
+#include <QTcpSocket>
+#include <cctype>
+#include <cmath>
+
+CommandScheduler::CommandScheduler(const Config &config, QObject *parent)
+    : QObject(parent),
+    config(config)
+{
+    clock.start();
+}
+
+bool CommandScheduler::isStateChange(const QString &command)
+{
+    return command == "loginRequest" || command == "Exit" || command == "Register"
+           || command == "saveInfo" || command == "resumeSession";
+}
+
+QString CommandScheduler::peekString(const QByteArray &data, const char *key)
+{
+    const QByteArray needle = '"' + QByteArray(key) + '"';
+    for (qsizetype pos = data.indexOf(needle); pos >= 0; pos = data.indexOf(needle, pos + 1)) {
+        qsizetype i = pos + needle.size();
+        while (i < data.size() && std::isspace(static_cast<unsigned char>(data.at(i)))) {
+            ++i;
+        }
+        if (i >= data.size() || data.at(i) != ':') {
+            continue; // The key text appeared as a value
+        }
+        ++i;
+        while (i < data.size() && std::isspace(static_cast<unsigned char>(data.at(i)))) {
+            ++i;
+        }
+        if (i >= data.size() || data.at(i) != '"') {
+            return QString();
+        }
+        const qsizetype end = data.indexOf('"', i + 1);
+        return end < 0 ? QString() : QString::fromUtf8(data.mid(i + 1, end - i - 1));
+    }
+    return QString();
+}
+
+int CommandScheduler::take(QHash<QString, Bucket> &buckets, const QString &key, double rate, double burst)
+{
+    if (rate <= 0) {
+        return 0;
+    }
+    const qint64 now = clock.elapsed();
+    auto it = buckets.find(key);
+    if (it == buckets.end()) {
+        it = buckets.insert(key, Bucket{burst, now});
+    }
+    Bucket &bucket = *it;
+    bucket.tokens = qMin(burst, bucket.tokens + (now - bucket.lastMs) * rate / 1000.0);
+    bucket.lastMs = now;
+    if (bucket.tokens >= 1) {
+        bucket.tokens -= 1;
+        return 0;
+    }
+    return qMax(1, int(std::ceil((1 - bucket.tokens) * 1000.0 / rate)));
+}
+
+void CommandScheduler::refund(QHash<QString, Bucket> &buckets, const QString &key, double burst)
+{
+    auto it = buckets.find(key);
+    if (it != buckets.end()) {
+        it->tokens = qMin(burst, it->tokens + 1);
+    }
+}
+
+void CommandScheduler::submit(QTcpSocket *socket, const QByteArray &data)
+{
+    const QString command = peekString(data, "request");
+    const bool stateChange = isStateChange(command);
+
+    // Exit always gets through; it is what frees the server again
+    if (command != "Exit") {
+        const QString ip = socket->peerAddress().toString();
+        int waitMs = 0;
+        if (stateChange) {
+            waitMs = take(stateBuckets, ip, config.stateRate, config.stateBurst);
+        } else {
+            waitMs = take(ipBuckets, ip, config.ipRate, config.ipBurst);
+            QString user = socket->property("username").toString();
+            if (user.isEmpty()) {
+                user = peekString(data, "username");
+            }
+            if (waitMs == 0 && !user.isEmpty()) {
+                waitMs = take(userBuckets, user, config.userRate, config.userBurst);
+                if (waitMs > 0) {
+                    // Only this user is over the limit; the others on the address are not charged
+                    refund(ipBuckets, ip, config.ipBurst);
+                }
+            }
+        }
+        if (waitMs > 0) {
+            Metrics::instance().commandsRateLimited.fetch_add(1, std::memory_order_relaxed);
+            emit reject(socket, command, waitMs);
+            return;
+        }
+    }
+
+    if (!stateChange && queries.size() >= config.queryShedDepth) {
+        Metrics::instance().commandsShed.fetch_add(1, std::memory_order_relaxed);
+        emit reject(socket, command, config.retryAfterMs);
+        return;
+    }
+
+    Pending pending{socket, data, QElapsedTimer()};
+    pending.queued.start();
+    (stateChange ? stateChanges : queries).enqueue(pending);
+    Metrics::instance().commandQueueDepth.store(stateChanges.size() + queries.size(), std::memory_order_relaxed);
+    scheduleDrain();
+}
+
+void CommandScheduler::scheduleDrain()
+{
+    if (!drainScheduled) {
+        drainScheduled = true;
+        QMetaObject::invokeMethod(this, &CommandScheduler::drain, Qt::QueuedConnection);
+    }
+}
+
+void CommandScheduler::drain()
+{
+    drainScheduled = false;
+    QElapsedTimer slice;
+    slice.start();
+    while ((!stateChanges.isEmpty() || !queries.isEmpty()) && slice.elapsed() < config.sliceMs) {
+        const Pending next = !stateChanges.isEmpty() ? stateChanges.dequeue() : queries.dequeue();
+        if (next.socket && next.socket->isOpen()) {
+            emit dispatch(next.socket, next.data, next.queued.nsecsElapsed() / 1000);
+        }
+    }
+    Metrics::instance().commandQueueDepth.store(stateChanges.size() + queries.size(), std::memory_order_relaxed);
+
+    // Whatever is left waits for one pass of the event loop, so new arrivals are sorted in first
+    if (!stateChanges.isEmpty() || !queries.isEmpty()) {
+        scheduleDrain();
+    }
+    pruneBuckets();
+}
+
+// Forgets buckets that have refilled completely; they would start full anyway
+void CommandScheduler::pruneBuckets()
+{
+    const qint64 now = clock.elapsed();
+    if (now - lastPruneMs < 60000) {
+        return;
+    }
+    lastPruneMs = now;
+
+    auto prune = [now](QHash<QString, Bucket> &buckets, double rate, double burst) {
+        for (auto it = buckets.begin(); it != buckets.end();) {
+            if (it->tokens + (now - it->lastMs) * rate / 1000.0 >= burst) {
+                it = buckets.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    };
+    prune(ipBuckets, config.ipRate, config.ipBurst);
+    prune(userBuckets, config.userRate, config.userBurst);
+    prune(stateBuckets, config.stateRate, config.stateBurst);
+}
@@ -0,0 +1,93 @@
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QString>
+
+class QTcpSocket;
+
+// Admission control for TCP commands, all on the GUI thread. Reads are
+// queued instead of handled straight from readyRead, and a drain pass runs
+// once the event loop has collected every socket that was ready:
+//
+//   - State changes (loginRequest, Exit, Register, saveInfo, resumeSession)
+//     always go before read-only queries, so dashboard polling never delays
+//     a login or a logout.
+//   - Each drain pass runs for at most sliceMs, then yields so that commands
+//     arriving meanwhile are sorted in before the remaining queries.
+//   - Token buckets limit how fast one client can send. Queries count against
+//     their IP and their user; state changes count against a separate per-IP
+//     bucket, so clients polling from behind one address (a NAT, or every
+//     stock client on 127.0.0.1) can never starve logins. Exit is never limited.
+//   - Once queryShedDepth queries are waiting, further queries are answered
+//     with a cheap retry-after instead of being queued.
+class CommandScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config {
+        double ipRate = 50;     // Tokens per second
+        double ipBurst = 200;
+        double userRate = 5;    // statusForm polls showPoints once a second
+        double userBurst = 20;
+        double stateRate = 20;  // State changes per IP, a login storm from one NAT included
+        double stateBurst = 200;
+        int queryShedDepth = 200;
+        int retryAfterMs = 1000;
+        int sliceMs = 20;
+    };
+
+    explicit CommandScheduler(const Config &config, QObject *parent = nullptr);
+
+    // Queues or rejects what was just read from the socket
+    void submit(QTcpSocket *socket, const QByteArray &data);
+
+    static bool isStateChange(const QString &command);
+    // The value of the first string field with this key, found by scanning
+    // instead of a full JSON parse; empty when absent
+    static QString peekString(const QByteArray &data, const char *key);
+
+signals:
+    // Handle the command now; it waited queuedUs in the scheduler
+    void dispatch(QTcpSocket *socket, const QByteArray &data, qint64 queuedUs);
+    // Answer with a retry-after instead of handling the command
+    void reject(QTcpSocket *socket, const QString &command, int retryAfterMs);
+
+private:
+    struct Bucket {
+        double tokens = 0;
+        qint64 lastMs = 0;
+    };
+    struct Pending {
+        QPointer<QTcpSocket> socket;
+        QByteArray data;
+        QElapsedTimer queued;
+    };
+
+    // Milliseconds until the key has a token, 0 when one was taken
+    int take(QHash<QString, Bucket> &buckets, const QString &key, double rate, double burst);
+    // Returns a token taken by a command that was then rejected elsewhere
+    void refund(QHash<QString, Bucket> &buckets, const QString &key, double burst);
+    void scheduleDrain();
+    void drain();
+    void pruneBuckets();
+
+    Config config;
+    QElapsedTimer clock;
+    QHash<QString, Bucket> ipBuckets;
+    QHash<QString, Bucket> userBuckets;
+    QHash<QString, Bucket> stateBuckets; // Per IP
+    qint64 lastPruneMs = 0;
+
+    QQueue<Pending> stateChanges;
+    QQueue<Pending> queries;
+    bool drainScheduled = false;
+};
+
+#endif // COMMANDSCHEDULER_H
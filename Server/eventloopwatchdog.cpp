@@ -0,0 +1,129 @@
+#include "eventloopwatchdog.h"
+#include "metrics.h"
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(serverCategory)
+
+std::atomic<const char *> EventLoopWatchdog::currentScope{nullptr};
+std::atomic<const char *> EventLoopWatchdog::sampledScope{nullptr};
+std::atomic<bool> EventLoopWatchdog::scopeReported{false};
+std::atomic<qint64> EventLoopWatchdog::thresholdNs{0};
+std::atomic<Qt::HANDLE> EventLoopWatchdog::watchedThread{nullptr};
+
+EventLoopWatchdog::EventLoopWatchdog(int thresholdMs, QObject *parent)
+    : QObject(parent),
+    heartbeat(new QTimer(this))
+{
+    thresholdNs.store(qint64(qMax(1, thresholdMs)) * 1000000);
+    heartbeat->setTimerType(Qt::PreciseTimer);
+    connect(heartbeat, &QTimer::timeout, this, &EventLoopWatchdog::onHeartbeat);
+}
+
+EventLoopWatchdog::~EventLoopWatchdog()
+{
+    stop();
+}
+
+void EventLoopWatchdog::start()
+{
+    if (running.exchange(true)) {
+        return;
+    }
+    watchedThread.store(QThread::currentThreadId());
+    clock.start();
+    lastBeatNs.store(0);
+    heartbeat->start(heartbeatIntervalMs);
+
+    monitorThread = QThread::create([this]() { monitor(); });
+    monitorThread->setObjectName("watchdog");
+    monitorThread->start();
+}
+
+void EventLoopWatchdog::stop()
+{
+    if (!running.exchange(false)) {
+        return;
+    }
+    heartbeat->stop();
+    watchedThread.store(nullptr);
+    monitorThread->wait();
+    delete monitorThread;
+    monitorThread = nullptr;
+}
+
+// GUI thread: every tick records how late it fired
+void EventLoopWatchdog::onHeartbeat()
+{
+    const qint64 now = clock.nsecsElapsed();
+    const qint64 lagNs = qMax<qint64>(0, now - lastBeatNs.exchange(now) - qint64(heartbeatIntervalMs) * 1000000);
+    Metrics::instance().recordEventLoopLag(lagNs / 1000);
+
+    const char *sampled = sampledScope.exchange(nullptr);
+    const bool reported = scopeReported.exchange(false);
+    if (lagNs >= thresholdNs.load() && !reported) {
+        // Nothing instrumented ran past the threshold: name whatever the
+        // monitor saw running, if anything
+        const char *where = sampled ? sampled : "other";
+        qCWarning(serverCategory) << "EventLoopWatchdog: Event loop stalled for" << lagNs / 1000000
+                                  << "ms, last seen in" << where;
+        Metrics::instance().recordStall(where, lagNs / 1000);
+    }
+}
+
+// Monitor thread: the heartbeat cannot report while the GUI thread is blocked,
+// so stalls in progress are sampled (and very long ones logged) from here
+void EventLoopWatchdog::monitor()
+{
+    bool longStallLogged = false;
+    while (running.load()) {
+        QThread::msleep(heartbeatIntervalMs / 2);
+
+        const qint64 sinceBeat = clock.nsecsElapsed() - lastBeatNs.load() - qint64(heartbeatIntervalMs) * 1000000;
+        if (sinceBeat < thresholdNs.load()) {
+            longStallLogged = false;
+            continue;
+        }
+
+        const char *scope = currentScope.load();
+        if (scope) {
+            const char *expected = nullptr;
+            sampledScope.compare_exchange_strong(expected, scope);
+        }
+        if (!longStallLogged && sinceBeat >= 10 * thresholdNs.load()) {
+            longStallLogged = true;
+            qCWarning(serverCategory) << "EventLoopWatchdog: Event loop blocked for" << sinceBeat / 1000000
+                                      << "ms so far in" << (scope ? scope : "unknown");
+        }
+    }
+}
+
+StallScope::StallScope(const char *name)
+    : name(name),
+    active(QThread::currentThreadId() == EventLoopWatchdog::watchedThread.load(std::memory_order_relaxed))
+{
+    if (active) {
+        previous = EventLoopWatchdog::currentScope.exchange(name);
+        timer.start();
+    }
+}
+
+StallScope::~StallScope()
+{
+    if (!active) {
+        return;
+    }
+    EventLoopWatchdog::currentScope.store(previous);
+
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    if (elapsedNs >= EventLoopWatchdog::thresholdNs.load(std::memory_order_relaxed)) {
+        // Nested scopes: the innermost slow one already named and counted the stall
+        if (!EventLoopWatchdog::scopeReported.exchange(true)) {
+            qCWarning(serverCategory) << "EventLoopWatchdog: Event loop blocked for" << elapsedNs / 1000000
+                                      << "ms in" << name;
+            Metrics::instance().recordStall(name, elapsedNs / 1000);
+        }
+    }
+}
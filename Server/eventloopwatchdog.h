@@ -0,0 +1,67 @@
+#ifndef EVENTLOOPWATCHDOG_H
+#define EVENTLOOPWATCHDOG_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <atomic>
+
+class QThread;
+class QTimer;
+
+// Measures how late the GUI event loop runs. A heartbeat timer on the GUI
+// thread records the lag of every tick; a monitor thread notices stalls while
+// they are still in progress and samples which StallScope is running. Stalls
+// longer than the threshold are reported to the log and to Metrics.
+class EventLoopWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EventLoopWatchdog(int thresholdMs, QObject *parent = nullptr);
+    ~EventLoopWatchdog();
+
+    void start();
+    void stop();
+
+private:
+    friend class StallScope;
+
+    void onHeartbeat();
+    void monitor();
+
+    static const int heartbeatIntervalMs = 100;
+
+    QTimer *heartbeat;
+    QThread *monitorThread = nullptr;
+    QElapsedTimer clock;
+    std::atomic<qint64> lastBeatNs{0};
+    std::atomic<bool> running{false};
+
+    // Shared with StallScope on the watched (GUI) thread
+    static std::atomic<const char *> currentScope;
+    static std::atomic<const char *> sampledScope;
+    static std::atomic<bool> scopeReported;
+    static std::atomic<qint64> thresholdNs;
+    static std::atomic<Qt::HANDLE> watchedThread;
+};
+
+// Names the handler or timer callback running on the GUI thread, e.g.
+// StallScope scope("showTimesheet"). If it runs past the watchdog threshold
+// the duration is reported under that name. No-op on other threads.
+class StallScope
+{
+public:
+    explicit StallScope(const char *name);
+    ~StallScope();
+
+    StallScope(const StallScope &) = delete;
+    StallScope &operator=(const StallScope &) = delete;
+
+private:
+    const char *name;
+    const char *previous = nullptr;
+    bool active;
+    QElapsedTimer timer;
+};
+
+#endif // EVENTLOOPWATCHDOG_H
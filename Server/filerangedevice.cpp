@@ -0,0 +1,80 @@
+#include "filerangedevice.h"
+
+FileRangeDevice::FileRangeDevice(const QString &filePath, qint64 offset, qint64 length, QObject *parent)
+    : QIODevice(parent),
+    file(filePath),
+    rangeOffset(offset),
+    rangeLength(length)
+{
+}
+
+bool FileRangeDevice::open(OpenMode mode)
+{
+    if (mode & QIODevice::WriteOnly) {
+        setErrorString("FileRangeDevice is read-only");
+        return false;
+    }
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        setErrorString(file.errorString());
+        return false;
+    }
+
+    if (rangeOffset < 0 || rangeLength < 0 || rangeOffset + rangeLength > file.size()) {
+        setErrorString("Requested range is outside of the file");
+        file.close();
+        return false;
+    }
+
+    if (!file.seek(rangeOffset)) {
+        setErrorString(file.errorString());
+        file.close();
+        return false;
+    }
+
+    // Unbuffered keeps pos() and the underlying file position in lock step
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void FileRangeDevice::close()
+{
+    file.close();
+    QIODevice::close();
+}
+
+bool FileRangeDevice::seek(qint64 pos)
+{
+    if (pos < 0 || pos > rangeLength) {
+        return false;
+    }
+    if (!file.seek(rangeOffset + pos)) {
+        return false;
+    }
+    return QIODevice::seek(pos);
+}
+
+qint64 FileRangeDevice::size() const
+{
+    return rangeLength;
+}
+
+bool FileRangeDevice::isSequential() const
+{
+    return false;
+}
+
+qint64 FileRangeDevice::readData(char *data, qint64 maxSize)
+{
+    const qint64 remaining = rangeOffset + rangeLength - file.pos();
+    if (remaining <= 0) {
+        return 0;
+    }
+    return file.read(data, qMin(maxSize, remaining));
+}
+
+qint64 FileRangeDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
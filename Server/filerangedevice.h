@@ -0,0 +1,32 @@
+#ifndef FILERANGEDEVICE_H
+#define FILERANGEDEVICE_H
+
+#include <QIODevice>
+#include <QFile>
+
+// Read-only view over a byte range of a file. QHttpServerResponder streams it
+// in chunks as the socket drains and takes size() as the Content-Length.
+class FileRangeDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    FileRangeDevice(const QString &filePath, qint64 offset, qint64 length, QObject *parent = nullptr);
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool seek(qint64 pos) override;
+    qint64 size() const override;
+    bool isSequential() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    QFile file;
+    qint64 rangeOffset;
+    qint64 rangeLength;
+};
+
+#endif // FILERANGEDEVICE_H
@@ -0,0 +1,257 @@
+#include "intropreviewworker.h"
+#include <QMediaPlayer>
+#include <QVideoSink>
+#include <QMediaCaptureSession>
+#include <QMediaRecorder>
+#include <QMediaFormat>
+#include <QImage>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTimer>
+#include <QUrl>
+#include <QDebug>
+#include <QLoggingCategory>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+#include <QVideoFrameInput>
+#endif
+
+Q_DECLARE_LOGGING_CATEGORY(serverCategory)
+
+// Poster edge length and preview clip settings
+static const int posterMaxSize = 640;
+static const int previewMaxSize = 320;
+static const int previewVideoBitRate = 250000;
+static const int jobTimeoutMs = 10 * 60 * 1000;
+
+IntroPreviewWorker::IntroPreviewWorker(QObject *parent)
+    : QObject(parent),
+    timeoutTimer(new QTimer(this))
+{
+    timeoutTimer->setSingleShot(true);
+    connect(timeoutTimer, &QTimer::timeout, this, &IntroPreviewWorker::onTimeout);
+}
+
+IntroPreviewWorker::~IntroPreviewWorker()
+{
+    releasePipeline();
+}
+
+QString IntroPreviewWorker::posterPath(const QString &introDir, const QString &username)
+{
+    return introDir + "/previews/" + username + "_poster.jpg";
+}
+
+QString IntroPreviewWorker::previewPath(const QString &introDir, const QString &username)
+{
+    return introDir + "/previews/" + username + "_preview.mp4";
+}
+
+void IntroPreviewWorker::enqueue(const QString &username, const QString &videoPath)
+{
+    // A newer upload of the same intro supersedes a queued one
+    for (int i = jobs.size() - 1; i >= 0; --i) {
+        if (jobs.at(i).username == username) {
+            jobs.removeAt(i);
+        }
+    }
+    jobs.enqueue({username, videoPath});
+
+    if (!busy) {
+        startNext();
+    }
+}
+
+void IntroPreviewWorker::startNext()
+{
+    if (busy || jobs.isEmpty()) {
+        return;
+    }
+
+    current = jobs.dequeue();
+    busy = true;
+    posterSaved = false;
+
+    const QString introDir = QFileInfo(current.videoPath).absolutePath();
+    QDir dir;
+    if (!dir.exists(introDir + "/previews") && !dir.mkpath(introDir + "/previews")) {
+        finishCurrent("Couldn't create previews directory");
+        return;
+    }
+
+    qCDebug(serverCategory) << "IntroPreviewWorker: Processing intro for" << current.username;
+
+    player = new QMediaPlayer(this);
+    sink = new QVideoSink(this);
+    player->setVideoSink(sink);
+    connect(sink, &QVideoSink::videoFrameChanged, this, &IntroPreviewWorker::onVideoFrame);
+    connect(player, &QMediaPlayer::mediaStatusChanged, this, &IntroPreviewWorker::onMediaStatusChanged);
+    connect(player, &QMediaPlayer::errorOccurred, this, &IntroPreviewWorker::onPlayerError);
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    // Decoded frames are fed back into a recorder that re-encodes them at a
+    // reduced resolution and bitrate
+    captureSession = new QMediaCaptureSession(this);
+    frameInput = new QVideoFrameInput(this);
+    recorder = new QMediaRecorder(this);
+    captureSession->setVideoFrameInput(frameInput);
+    captureSession->setRecorder(recorder);
+
+    QMediaFormat format(QMediaFormat::MPEG4);
+    format.setVideoCodec(QMediaFormat::VideoCodec::H264);
+    recorder->setMediaFormat(format);
+    recorder->setQuality(QMediaRecorder::LowQuality);
+    recorder->setVideoBitRate(previewVideoBitRate);
+    recorder->setOutputLocation(QUrl::fromLocalFile(previewPath(introDir, current.username) + ".part.mp4"));
+
+    connect(recorder, &QMediaRecorder::recorderStateChanged, this, [this](QMediaRecorder::RecorderState state) {
+        if (state == QMediaRecorder::StoppedState && player
+            && player->mediaStatus() == QMediaPlayer::EndOfMedia) {
+            finishCurrent();
+        }
+    });
+    connect(recorder, &QMediaRecorder::errorOccurred, this, [this](QMediaRecorder::Error, const QString &errorString) {
+        qCWarning(serverCategory) << "IntroPreviewWorker: Preview encoding failed for" << current.username << errorString;
+    });
+#endif
+
+    player->setSource(QUrl::fromLocalFile(current.videoPath));
+    player->play();
+    timeoutTimer->start(jobTimeoutMs);
+}
+
+void IntroPreviewWorker::onVideoFrame(const QVideoFrame &frame)
+{
+    if (!busy || !frame.isValid()) {
+        return;
+    }
+
+    if (!posterSaved) {
+        QImage image = frame.toImage();
+        if (image.isNull()) {
+            return;
+        }
+        if (image.width() > posterMaxSize || image.height() > posterMaxSize) {
+            image = image.scaled(posterMaxSize, posterMaxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+
+        const QString introDir = QFileInfo(current.videoPath).absolutePath();
+        QSaveFile posterFile(posterPath(introDir, current.username));
+        if (posterFile.open(QIODevice::WriteOnly) && image.save(&posterFile, "JPG", 85) && posterFile.commit()) {
+            posterSaved = true;
+        } else {
+            finishCurrent("Couldn't save poster frame");
+            return;
+        }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+        // The first frame fixes the aspect ratio of the preview clip
+        QSize previewSize = frame.size().scaled(previewMaxSize, previewMaxSize, Qt::KeepAspectRatio);
+        previewSize = QSize(previewSize.width() & ~1, previewSize.height() & ~1);
+        recorder->setVideoResolution(previewSize);
+        recorder->record();
+#else
+        // Without QVideoFrameInput there is no way to re-encode, poster only
+        finishCurrent();
+#endif
+        return;
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    // Frames the encoder is not ready for are dropped, which is fine for a preview
+    frameInput->sendVideoFrame(frame);
+#endif
+}
+
+void IntroPreviewWorker::onMediaStatusChanged()
+{
+    if (!busy || !player) {
+        return;
+    }
+
+    switch (player->mediaStatus()) {
+    case QMediaPlayer::EndOfMedia:
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+        if (recorder->recorderState() != QMediaRecorder::StoppedState) {
+            recorder->stop(); // finishCurrent() runs once the file is finalized
+            return;
+        }
+#endif
+        finishCurrent(posterSaved ? QString() : QString("No video frames decoded"));
+        break;
+    case QMediaPlayer::InvalidMedia:
+        finishCurrent("Invalid media");
+        break;
+    default:
+        break;
+    }
+}
+
+void IntroPreviewWorker::onPlayerError()
+{
+    if (busy && player) {
+        finishCurrent(player->errorString());
+    }
+}
+
+void IntroPreviewWorker::onTimeout()
+{
+    finishCurrent("Timed out");
+}
+
+void IntroPreviewWorker::finishCurrent(const QString &error)
+{
+    if (!busy) {
+        return;
+    }
+    timeoutTimer->stop();
+    releasePipeline();
+
+    const QString introDir = QFileInfo(current.videoPath).absolutePath();
+    const QString finalPreview = previewPath(introDir, current.username);
+    const QString partialPreview = finalPreview + ".part.mp4";
+
+    if (error.isEmpty() && posterSaved) {
+        if (QFile::exists(partialPreview)) {
+            QFile::remove(finalPreview);
+            if (!QFile::rename(partialPreview, finalPreview)) {
+                qCWarning(serverCategory) << "IntroPreviewWorker: Couldn't move preview clip into place for" << current.username;
+            }
+        }
+        qCDebug(serverCategory) << "IntroPreviewWorker: Preview ready for" << current.username;
+        emit previewReady(current.username);
+    } else {
+        QFile::remove(partialPreview);
+        qCWarning(serverCategory) << "IntroPreviewWorker: Failed for" << current.username << error;
+        emit previewFailed(current.username, error);
+    }
+
+    busy = false;
+    QTimer::singleShot(0, this, &IntroPreviewWorker::startNext);
+}
+
+void IntroPreviewWorker::releasePipeline()
+{
+    if (player) {
+        player->disconnect(this);
+        sink->disconnect(this);
+        player->stop();
+        player->deleteLater();
+        sink->deleteLater();
+        player = nullptr;
+        sink = nullptr;
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    if (recorder) {
+        recorder->disconnect(this);
+        recorder->stop();
+        recorder->deleteLater();
+        captureSession->deleteLater();
+        frameInput->deleteLater();
+        recorder = nullptr;
+        captureSession = nullptr;
+        frameInput = nullptr;
+    }
+#endif
+}
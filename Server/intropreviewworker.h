@@ -0,0 +1,66 @@
+#ifndef INTROPREVIEWWORKER_H
+#define INTROPREVIEWWORKER_H
+
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QVideoFrame>
+
+class QMediaPlayer;
+class QVideoSink;
+class QMediaCaptureSession;
+class QMediaRecorder;
+class QVideoFrameInput;
+class QTimer;
+
+// Background media job that turns an uploaded intro video into a poster JPEG
+// and a reduced-resolution, low-bitrate preview clip. Lives on its own thread
+// (QMediaPlayer needs an event loop) and processes one video at a time.
+class IntroPreviewWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit IntroPreviewWorker(QObject *parent = nullptr);
+    ~IntroPreviewWorker();
+
+    static QString posterPath(const QString &introDir, const QString &username);
+    static QString previewPath(const QString &introDir, const QString &username);
+
+public slots:
+    void enqueue(const QString &username, const QString &videoPath);
+
+signals:
+    void previewReady(const QString &username);
+    void previewFailed(const QString &username, const QString &error);
+
+private slots:
+    void onVideoFrame(const QVideoFrame &frame);
+    void onMediaStatusChanged();
+    void onPlayerError();
+    void onTimeout();
+
+private:
+    struct Job {
+        QString username;
+        QString videoPath;
+    };
+
+    void startNext();
+    void finishCurrent(const QString &error = QString());
+    void releasePipeline();
+
+    QQueue<Job> jobs;
+    Job current;
+    bool busy = false;
+    bool posterSaved = false;
+
+    QMediaPlayer *player = nullptr;
+    QVideoSink *sink = nullptr;
+    QMediaCaptureSession *captureSession = nullptr;
+    QMediaRecorder *recorder = nullptr;
+    QVideoFrameInput *frameInput = nullptr;
+    QTimer *timeoutTimer = nullptr;
+};
+
+#endif // INTROPREVIEWWORKER_H
@@ -0,0 +1,213 @@
+#ifndef KEYEDTABLEMODEL_H
+#define KEYEDTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <algorithm>
+
+// Table model over a list of rows keyed by username, for views that are
+// refreshed from a full snapshot every few seconds. setRows() keeps rows in
+// place by key and only signals what differs: removed runs, changed runs and
+// appended rows. The view then repaints just the visible rows that changed,
+// instead of rebuilding a QStandardItem per cell for every employee.
+//
+// The last snapshot is kept whole, so a filter (the admin's roster search)
+// can be set and cleared without going back to the files.
+//
+// Row needs a QString username and operator==.
+template <typename Row>
+class KeyedTableModel : public QAbstractTableModel
+{
+public:
+    using QAbstractTableModel::QAbstractTableModel;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : int(rows.size());
+    }
+
+    const Row &rowAt(int row) const { return rows.at(row); }
+
+    // Replaces the contents with a full snapshot; with a filter set only the
+    // filtered keys of it are shown
+    void setRows(const QList<Row> &incoming)
+    {
+        all = incoming;
+        allIndexBuilt = false;
+        showRows(filtered ? filteredRows() : all);
+    }
+
+    // Shows only the rows with these keys; rows already shown keep their place
+    void setFilter(const QStringList &keys)
+    {
+        filterKeys = keys;
+        filtered = true;
+        showRows(filteredRows());
+    }
+
+    void clearFilter()
+    {
+        if (filtered) {
+            filtered = false;
+            filterKeys.clear();
+            showRows(all);
+        }
+    }
+
+    // Row of the last snapshot with this key, shown or not; null when absent
+    const Row *find(const QString &key) const
+    {
+        if (!allIndexBuilt) {
+            allIndex.clear();
+            allIndex.reserve(all.size());
+            for (qsizetype i = 0; i < all.size(); ++i) {
+                allIndex.insert(all.at(i).username, i);
+            }
+            allIndexBuilt = true;
+        }
+        auto it = allIndex.constFind(key);
+        return it == allIndex.constEnd() ? nullptr : &all.at(*it);
+    }
+
+    const QList<Row> &snapshot() const { return all; }
+
+private:
+    QList<Row> filteredRows() const
+    {
+        QList<Row> shown;
+        shown.reserve(filterKeys.size());
+        for (const QString &key : filterKeys) {
+            if (const Row *row = find(key)) {
+                shown.append(*row);
+            }
+        }
+        return shown;
+    }
+
+    void showRows(const QList<Row> &incoming)
+    {
+        QHash<QString, qsizetype> incomingIndex;
+        incomingIndex.reserve(incoming.size());
+        for (qsizetype i = 0; i < incoming.size(); ++i) {
+            incomingIndex.insert(incoming.at(i).username, i); // A later duplicate wins
+        }
+
+        // Drop rows whose key is gone, back to front so earlier indices stay valid
+        bool removed = false;
+        for (int last = int(rows.size()) - 1; last >= 0; --last) {
+            if (incomingIndex.contains(rows.at(last).username)) {
+                continue;
+            }
+            int first = last;
+            while (first > 0 && !incomingIndex.contains(rows.at(first - 1).username)) {
+                --first;
+            }
+            beginRemoveRows(QModelIndex(), first, last);
+            rows.remove(first, last - first + 1);
+            endRemoveRows();
+            removed = true;
+            last = first;
+        }
+        if (removed) {
+            reindex();
+        }
+
+        // Update in place, then append what is new
+        QList<int> changed;
+        QList<Row> added;
+        for (qsizetype i = 0; i < incoming.size(); ++i) {
+            const Row &row = incoming.at(i);
+            if (incomingIndex.value(row.username) != i) {
+                continue;
+            }
+            auto it = rowOf.constFind(row.username);
+            if (it == rowOf.constEnd()) {
+                added.append(row);
+            } else if (!(rows.at(*it) == row)) {
+                rows[*it] = row;
+                changed.append(*it);
+            }
+        }
+        emitChanged(changed);
+
+        if (!added.isEmpty()) {
+            const int first = int(rows.size());
+            beginInsertRows(QModelIndex(), first, first + int(added.size()) - 1);
+            for (const Row &row : std::as_const(added)) {
+                rowOf.insert(row.username, rows.size());
+                rows.append(row);
+            }
+            endInsertRows();
+        }
+    }
+
+protected:
+    // For changes that alter the columns as well as the rows
+    void resetRows(const QList<Row> &incoming)
+    {
+        all = incoming;
+        allIndexBuilt = false;
+        const QList<Row> shown = filtered ? filteredRows() : all;
+
+        beginResetModel();
+        rows.clear();
+        rowOf.clear();
+        for (const Row &row : shown) {
+            auto it = rowOf.constFind(row.username);
+            if (it != rowOf.constEnd()) {
+                rows[*it] = row;
+            } else {
+                rowOf.insert(row.username, rows.size());
+                rows.append(row);
+            }
+        }
+        endResetModel();
+    }
+
+    QList<Row> rows; // Shown rows
+
+private:
+    void reindex()
+    {
+        rowOf.clear();
+        rowOf.reserve(rows.size());
+        for (qsizetype i = 0; i < rows.size(); ++i) {
+            rowOf.insert(rows.at(i).username, i);
+        }
+    }
+
+    // One dataChanged per run of adjacent rows
+    void emitChanged(QList<int> &changed)
+    {
+        if (changed.isEmpty()) {
+            return;
+        }
+        std::sort(changed.begin(), changed.end());
+        const int lastColumn = columnCount() - 1;
+        int first = changed.first();
+        int last = first;
+        for (qsizetype i = 1; i <= changed.size(); ++i) {
+            if (i < changed.size() && changed.at(i) == last + 1) {
+                last = changed.at(i);
+                continue;
+            }
+            emit this->dataChanged(this->index(first, 0), this->index(last, lastColumn));
+            if (i < changed.size()) {
+                first = last = changed.at(i);
+            }
+        }
+    }
+
+    QHash<QString, qsizetype> rowOf;
+
+    QList<Row> all;
+    mutable QHash<QString, qsizetype> allIndex; // Built on the first find() after a snapshot
+    mutable bool allIndexBuilt = false;
+    bool filtered = false;
+    QStringList filterKeys;
+};
+
+#endif // KEYEDTABLEMODEL_H
@@ -1,53 +1,111 @@
 #include "server.h"
+#include "asyncfilesink.h"
+#include "tracer.h"
+#include "trafficcapture.h"
+#include "clock.h"
 #include <QApplication>
 #include <QLoggingCategory>
 #include <QFile>
 #include <QDateTime>
 #include <QDir>
+#include <atomic>
+
+// Set once the application directory is known; messages before that only go to stderr
+static std::atomic<AsyncFileSink *> logSink{nullptr};
 
 void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
 {
-    QString txt;
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
-    
+    Q_UNUSED(context);
+    const char *level = "Debug";
     switch (type) {
     case QtDebugMsg:
-        txt = QString("%1 [Debug] %2").arg(timestamp, msg);
+        level = "Debug";
         break;
     case QtInfoMsg:
-        txt = QString("%1 [Info] %2").arg(timestamp, msg);
+        level = "Info";
         break;
     case QtWarningMsg:
-        txt = QString("%1 [Warning] %2").arg(timestamp, msg);
+        level = "Warning";
         break;
     case QtCriticalMsg:
-        txt = QString("%1 [Critical] %2").arg(timestamp, msg);
+        level = "Critical";
         break;
     case QtFatalMsg:
-        txt = QString("%1 [Fatal] %2").arg(timestamp, msg);
+        level = "Fatal";
         break;
     }
 
-    QString logPath = QCoreApplication::applicationDirPath() + "/server.log";
-    QFile outFile(logPath);
-    outFile.open(QIODevice::WriteOnly | QIODevice::Append);
-    QTextStream ts(&outFile);
-    ts << txt << Qt::endl;
-    outFile.close();
+    QByteArray txt = Clock::instance().now().toString("yyyy-MM-dd hh:mm:ss.zzz").toUtf8();
+    txt += " [";
+    txt += level;
+    txt += "] ";
+    txt += msg.toUtf8();
+
+    // Warnings and worse still go to stderr right away for immediate feedback
+    if (type != QtDebugMsg && type != QtInfoMsg) {
+        fprintf(stderr, "%s\n", txt.constData());
+    }
 
-    // Also output to stderr for immediate feedback
-    fprintf(stderr, "%s\n", qPrintable(txt));
+    // The sink only queues the line, the file is written by its own thread
+    AsyncFileSink *sink = logSink.load(std::memory_order_acquire);
+    if (sink) {
+        sink->append(std::move(txt));
+        if (type == QtFatalMsg) {
+            sink->flush(); // Qt aborts right after the handler returns
+        }
+    } else if (type == QtDebugMsg || type == QtInfoMsg) {
+        fprintf(stderr, "%s\n", txt.constData());
+    }
 }
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    // --virtual-clock <ISO date-time> [--clock-rate <factor>] runs the server on
+    // simulated time, e.g. a day at rate 60 in 24 minutes. Installed before
+    // anything reads the clock; never deleted, like the log sink below.
+    const QStringList args = QCoreApplication::arguments();
+    const qsizetype clockArg = args.indexOf("--virtual-clock");
+    if (clockArg >= 0 && clockArg + 1 < args.size()) {
+        const QDateTime start = QDateTime::fromString(args.at(clockArg + 1), Qt::ISODate);
+        const qsizetype rateArg = args.indexOf("--clock-rate");
+        const double rate = rateArg >= 0 && rateArg + 1 < args.size() ? args.at(rateArg + 1).toDouble() : 1.0;
+        if (start.isValid()) {
+            Clock::setInstance(new VirtualClock(start, rate));
+        } else {
+            fprintf(stderr, "Ignoring --virtual-clock, expected an ISO date-time\n");
+        }
+    }
+    
+    // Rotated daily and at 10 MB into logs/server-<date>[.N].log. Never deleted:
+    // pool threads may still log while the application shuts down.
+    AsyncFileSink *sink = new AsyncFileSink(QCoreApplication::applicationDirPath() + "/logs", "server", "log");
+    sink->start();
+    logSink.store(sink, std::memory_order_release);
+    struct LogSinkStopper {
+        AsyncFileSink *sink;
+        ~LogSinkStopper() { sink->stop(); }
+    } logSinkStopper{sink};
     
     // Install the custom message handler
     qInstallMessageHandler(messageHandler);
     
     qInfo() << "Application starting...";
     qInfo() << "Application path:" << QCoreApplication::applicationDirPath();
+    if (auto *virtualClock = dynamic_cast<VirtualClock *>(&Clock::instance())) {
+        qInfo() << "Running on a virtual clock at" << virtualClock->rate() << "x, now"
+                << virtualClock->now().toString(Qt::ISODate);
+    }
+
+    // Trace-event output can also be switched at runtime with POST /trace/start and /trace/stop
+    if (QCoreApplication::arguments().contains("--trace")) {
+        qInfo() << "Tracing to" << Tracer::start(QCoreApplication::applicationDirPath() + "/logs");
+    }
+    // TCP capture likewise, with POST /capture/start and /capture/stop
+    if (QCoreApplication::arguments().contains("--capture")) {
+        qInfo() << "Capturing TCP traffic to" << TrafficCapture::start(QCoreApplication::applicationDirPath() + "/logs");
+    }
     
     // Create log directory if it doesn't exist
     QDir appDir(QCoreApplication::applicationDirPath());
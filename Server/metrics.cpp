@@ -0,0 +1,191 @@
+#include "metrics.h"
+#include <QFile>
+#include <QMutexLocker>
+#include <QStringList>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+const qint64 MetricHistogram::boundsUs[MetricHistogram::bucketCount] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+    100000, 250000, 500000, 1000000, 5000000
+};
+
+void MetricHistogram::observe(qint64 us)
+{
+    int bucket = 0;
+    while (bucket < bucketCount && us > boundsUs[bucket]) {
+        ++bucket;
+    }
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sumUs.fetch_add(us, std::memory_order_relaxed);
+}
+
+void MetricHistogram::render(QByteArray &out, const QByteArray &name, const QByteArray &labels) const
+{
+    const QByteArray separator = labels.isEmpty() ? QByteArray() : QByteArray(",");
+    quint64 cumulative = 0;
+    for (int i = 0; i <= bucketCount; ++i) {
+        cumulative += buckets[i].load(std::memory_order_relaxed);
+        const QByteArray le = i < bucketCount ? QByteArray::number(boundsUs[i] / 1e6) : QByteArray("+Inf");
+        out += name + "_bucket{" + labels + separator + "le=\"" + le + "\"} " + QByteArray::number(cumulative) + "\n";
+    }
+    const QByteArray braces = labels.isEmpty() ? QByteArray() : "{" + labels + "}";
+    out += name + "_sum" + braces + " " + QByteArray::number(sumUs.load(std::memory_order_relaxed) / 1e6) + "\n";
+    out += name + "_count" + braces + " " + QByteArray::number(count.load(std::memory_order_relaxed)) + "\n";
+}
+
+Metrics &Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Metrics()
+{
+    // Everything handleClientData and setupHttpServer dispatch on; the rest lands in "other"
+    const QStringList tcpNames = {"loginRequest", "currentLoginUser", "Exit", "showInfo", "addInfo",
+                                  "saveInfo", "updateInfo", "showPoints", "Register", "resumeSession", "invalid", "other"};
+    const QStringList httpNames = {"GET /", "GET /health", "GET /metrics", "GET /intro/<user>",
+                                   "GET /intro/<user>/poster", "GET /intro/<user>/preview",
+                                   "GET /avatar/<user>", "POST /avatar", "POST /intro", "POST /scoring/reload", "other"};
+
+    commandTotal = tcpNames.size() + httpNames.size();
+    commandStorage.reset(new CommandStats[commandTotal]);
+    int index = 0;
+    auto add = [this, &index](CommandTable &table, const QString &transport, const QStringList &names) {
+        for (const QString &command : names) {
+            CommandStats *stats = &commandStorage[index++];
+            stats->labels = "transport=\"" + transport.toUtf8() + "\",command=\"" + command.toUtf8() + "\"";
+            table.byCommand.insert(command, stats);
+        }
+        table.other = table.byCommand.value("other");
+    };
+    add(tcpCommands, "tcp", tcpNames);
+    add(httpCommands, "http", httpNames);
+}
+
+void Metrics::recordRequest(const QString &transport, const QString &command, qint64 handlerUs)
+{
+    const CommandTable &table = transport == QLatin1String("tcp") ? tcpCommands : httpCommands;
+    CommandStats *stats = table.byCommand.value(command, table.other);
+    stats->requests.fetch_add(1, std::memory_order_relaxed);
+    stats->latency.observe(handlerUs);
+}
+
+void Metrics::recordEventLoopLag(qint64 us)
+{
+    eventLoopLag.observe(us);
+    eventLoopLagLastUs.store(us, std::memory_order_relaxed);
+}
+
+void Metrics::recordStall(const char *scope, qint64 us)
+{
+    QMutexLocker locker(&stallMutex);
+    StallStats &stats = stalls[QByteArray(scope)];
+    ++stats.count;
+    stats.totalUs += us;
+    stats.maxUs = qMax(stats.maxUs, us);
+}
+
+// Resident set size of this process, 0 when unknown
+static qint64 residentMemoryBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return qint64(counters.WorkingSetSize);
+    }
+    return 0;
+#elif defined(Q_OS_LINUX)
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() * 4096 : 0;
+#else
+    return 0;
+#endif
+}
+
+static void renderHeader(QByteArray &out, const char *name, const char *type, const char *help)
+{
+    out += QByteArray("# HELP ") + name + " " + help + "\n";
+    out += QByteArray("# TYPE ") + name + " " + type + "\n";
+}
+
+static void renderValue(QByteArray &out, const char *name, const char *type, const char *help, qint64 value)
+{
+    renderHeader(out, name, type, help);
+    out += QByteArray(name) + " " + QByteArray::number(value) + "\n";
+}
+
+QByteArray Metrics::render() const
+{
+    QByteArray out;
+    out.reserve(16 * 1024);
+
+    renderValue(out, "server_connections_open", "gauge", "Open TCP client connections",
+                connectionsOpen.load(std::memory_order_relaxed));
+    renderValue(out, "server_connections_total", "counter", "TCP client connections accepted",
+                qint64(connectionsTotal.load(std::memory_order_relaxed)));
+
+    renderHeader(out, "server_requests_total", "counter", "Requests handled per command");
+    for (int i = 0; i < commandTotal; ++i) {
+        out += "server_requests_total{" + commandStorage[i].labels + "} "
+               + QByteArray::number(commandStorage[i].requests.load(std::memory_order_relaxed)) + "\n";
+    }
+
+    renderHeader(out, "server_request_duration_seconds", "histogram", "Handler time per command");
+    for (int i = 0; i < commandTotal; ++i) {
+        commandStorage[i].latency.render(out, "server_request_duration_seconds", commandStorage[i].labels);
+    }
+
+    renderValue(out, "server_status_events_written_total", "counter", "User status events saved",
+                qint64(statusEventsWritten.load(std::memory_order_relaxed)));
+    renderValue(out, "server_session_tokens_accepted_total", "counter", "Requests identified by a valid session token",
+                qint64(sessionTokensAccepted.load(std::memory_order_relaxed)));
+    renderValue(out, "server_session_tokens_rejected_total", "counter", "Malformed, forged or expired session tokens",
+                qint64(sessionTokensRejected.load(std::memory_order_relaxed)));
+    renderValue(out, "server_command_queue_depth", "gauge", "TCP commands waiting in the scheduler",
+                commandQueueDepth.load(std::memory_order_relaxed));
+    renderValue(out, "server_commands_rate_limited_total", "counter", "TCP commands refused by a per-IP or per-user limit",
+                qint64(commandsRateLimited.load(std::memory_order_relaxed)));
+    renderValue(out, "server_commands_shed_total", "counter", "Read-only TCP commands answered with retry-after under load",
+                qint64(commandsShed.load(std::memory_order_relaxed)));
+    renderValue(out, "server_upload_bytes_total", "counter", "Media bytes stored by uploads",
+                qint64(uploadBytes.load(std::memory_order_relaxed)));
+    renderValue(out, "server_uploads_rejected_total", "counter", "Uploads refused for size or quota",
+                qint64(uploadsRejected.load(std::memory_order_relaxed)));
+
+    renderHeader(out, "server_storage_write_seconds", "histogram", "Time spent reading and writing data files");
+    storageWrite.render(out, "server_storage_write_seconds", QByteArray());
+
+    renderHeader(out, "server_event_loop_lag_seconds", "histogram", "Delay of the GUI event loop");
+    eventLoopLag.render(out, "server_event_loop_lag_seconds", QByteArray());
+    renderHeader(out, "server_event_loop_lag_last_seconds", "gauge", "Most recent event loop lag sample");
+    out += "server_event_loop_lag_last_seconds "
+           + QByteArray::number(eventLoopLagLastUs.load(std::memory_order_relaxed) / 1e6) + "\n";
+
+    {
+        QMutexLocker locker(&stallMutex);
+        renderHeader(out, "server_event_loop_stalls_total", "counter", "Event loop stalls over the watchdog threshold per scope");
+        for (auto it = stalls.constBegin(); it != stalls.constEnd(); ++it) {
+            out += "server_event_loop_stalls_total{scope=\"" + it.key() + "\"} " + QByteArray::number(it->count) + "\n";
+        }
+        renderHeader(out, "server_event_loop_stall_seconds_total", "counter", "Time spent in stalls per scope");
+        for (auto it = stalls.constBegin(); it != stalls.constEnd(); ++it) {
+            out += "server_event_loop_stall_seconds_total{scope=\"" + it.key() + "\"} " + QByteArray::number(it->totalUs / 1e6) + "\n";
+        }
+        renderHeader(out, "server_event_loop_stall_max_seconds", "gauge", "Longest stall per scope");
+        for (auto it = stalls.constBegin(); it != stalls.constEnd(); ++it) {
+            out += "server_event_loop_stall_max_seconds{scope=\"" + it.key() + "\"} " + QByteArray::number(it->maxUs / 1e6) + "\n";
+        }
+    }
+
+    renderValue(out, "process_resident_memory_bytes", "gauge", "Resident memory size", residentMemoryBytes());
+    return out;
+}
@@ -0,0 +1,90 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <memory>
+
+// Latency histogram with fixed bucket bounds. observe() is a couple of
+// relaxed atomic adds, so it can sit on any hot path and any thread.
+class MetricHistogram
+{
+public:
+    static constexpr int bucketCount = 14;
+    static const qint64 boundsUs[bucketCount];
+
+    void observe(qint64 us);
+    void render(QByteArray &out, const QByteArray &name, const QByteArray &labels) const;
+
+private:
+    std::atomic<quint64> buckets[bucketCount + 1] = {}; // Last one is +Inf
+    std::atomic<quint64> count{0};
+    std::atomic<qint64> sumUs{0};
+};
+
+// Process-wide counters and histograms exposed on /metrics in the Prometheus
+// text format. Every command label is registered up front, so recording never
+// takes a lock and unknown commands cannot grow the label set. recordRequest()
+// costs one hash lookup of the command name in a read-only table, then the
+// relaxed atomic adds.
+class Metrics
+{
+public:
+    static Metrics &instance();
+
+    void recordRequest(const QString &transport, const QString &command, qint64 handlerUs);
+    void recordStorage(qint64 us) { storageWrite.observe(us); }
+    void recordEventLoopLag(qint64 us);
+    // Stalls are rare, so these may take a lock
+    void recordStall(const char *scope, qint64 us);
+
+    std::atomic<qint64> connectionsOpen{0};
+    std::atomic<quint64> connectionsTotal{0};
+    std::atomic<quint64> statusEventsWritten{0};
+    std::atomic<quint64> sessionTokensAccepted{0};
+    std::atomic<quint64> sessionTokensRejected{0};
+    std::atomic<qint64> commandQueueDepth{0};
+    std::atomic<quint64> commandsRateLimited{0};
+    std::atomic<quint64> commandsShed{0};
+    std::atomic<quint64> uploadBytes{0};
+    std::atomic<quint64> uploadsRejected{0};
+
+    QByteArray render() const;
+
+private:
+    Metrics();
+
+    struct CommandStats {
+        QByteArray labels;
+        std::atomic<quint64> requests{0};
+        MetricHistogram latency;
+    };
+
+    // Per transport, keyed by the command name the dispatcher already holds.
+    // Read-only after construction, safe to look up from any thread.
+    struct CommandTable {
+        QHash<QString, CommandStats *> byCommand;
+        CommandStats *other = nullptr;
+    };
+    CommandTable tcpCommands;
+    CommandTable httpCommands;
+    std::unique_ptr<CommandStats[]> commandStorage;
+    int commandTotal = 0;
+
+    MetricHistogram storageWrite;
+    MetricHistogram eventLoopLag;
+    std::atomic<qint64> eventLoopLagLastUs{0};
+
+    struct StallStats {
+        quint64 count = 0;
+        qint64 totalUs = 0;
+        qint64 maxUs = 0;
+    };
+    mutable QMutex stallMutex;
+    QHash<QByteArray, StallStats> stalls;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,60 @@
+#include "passwordhash.h"
+#include <QCryptographicHash>
+#include <QList>
+#include <QPasswordDigestor>
+#include <QRandomGenerator>
+
+static const QString hashPrefix = QStringLiteral("pbkdf2-sha256$");
+static constexpr int saltBytes = 16;
+static constexpr int hashBytes = 32;
+
+static QByteArray derive(const QString &password, const QByteArray &salt, int iterations)
+{
+    return QPasswordDigestor::deriveKeyPbkdf2(QCryptographicHash::Sha256, password.toUtf8(), salt,
+                                              iterations, hashBytes);
+}
+
+QString PasswordHash::create(const QString &password, int iterations)
+{
+    QByteArray salt(saltBytes, Qt::Uninitialized);
+    QRandomGenerator::system()->fillRange(reinterpret_cast<quint32 *>(salt.data()), saltBytes / 4);
+    return hashPrefix + QString::number(iterations) + '$' + QString::fromLatin1(salt.toBase64()) + '$'
+           + QString::fromLatin1(derive(password, salt, iterations).toBase64());
+}
+
+bool PasswordHash::isHash(const QString &stored)
+{
+    return stored.startsWith(hashPrefix);
+}
+
+bool PasswordHash::verify(const QString &password, const QString &stored)
+{
+    if (!isHash(stored)) {
+        return constantTimeEquals(password.toUtf8(), stored.toUtf8());
+    }
+
+    const QStringList parts = stored.mid(hashPrefix.size()).split('$');
+    if (parts.size() != 3) {
+        return false;
+    }
+    bool ok = false;
+    const int iterations = parts.at(0).toInt(&ok);
+    if (!ok || iterations <= 0) {
+        return false;
+    }
+    const QByteArray salt = QByteArray::fromBase64(parts.at(1).toLatin1());
+    const QByteArray expected = QByteArray::fromBase64(parts.at(2).toLatin1());
+    return constantTimeEquals(derive(password, salt, iterations), expected);
+}
+
+bool PasswordHash::constantTimeEquals(const QByteArray &a, const QByteArray &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    unsigned char diff = 0;
+    for (qsizetype i = 0; i < a.size(); ++i) {
+        diff |= static_cast<unsigned char>(a.at(i) ^ b.at(i));
+    }
+    return diff == 0;
+}
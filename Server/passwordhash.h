@@ -0,0 +1,29 @@
+#ifndef PASSWORDHASH_H
+#define PASSWORDHASH_H
+
+#include <QByteArray>
+#include <QString>
+
+// Salted PBKDF2-HMAC-SHA256 password hashes as stored in account.json:
+//
+//   pbkdf2-sha256$<iterations>$<base64 salt>$<base64 hash>
+//
+// Verifying one costs the full iteration count on purpose, so the server
+// only does it on an actual login; reconnects present a session token
+// instead. Entries without the prefix are plaintext from older servers and
+// still verify until AccountWorker::upgradePasswords replaces them.
+class PasswordHash
+{
+public:
+    static constexpr int defaultIterations = 100000;
+
+    static QString create(const QString &password, int iterations = defaultIterations);
+    static bool verify(const QString &password, const QString &stored);
+    static bool isHash(const QString &stored);
+
+    // Compares without an early exit, so the time taken does not reveal how
+    // many leading bytes matched
+    static bool constantTimeEquals(const QByteArray &a, const QByteArray &b);
+};
+
+#endif // PASSWORDHASH_H
@@ -0,0 +1,58 @@
+#include "presencemodel.h"
+#include <QJsonObject>
+
+PresenceModel::PresenceModel(QObject *parent)
+    : KeyedTableModel<PresenceRow>(parent),
+    onlineIcon(":/icon/shape.png"),
+    offlineIcon(":/icon/circle.png")
+{
+}
+
+void PresenceModel::setEvents(const QJsonArray &events)
+{
+    QList<PresenceRow> incoming;
+    incoming.reserve(events.size());
+    for (const QJsonValue &value : events) {
+        const QJsonObject event = value.toObject();
+        incoming.append({event.value("username").toString(), event.value("time").toString(),
+                         event.value("status").toString()});
+    }
+    setRows(incoming);
+}
+
+int PresenceModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 3;
+}
+
+QVariant PresenceModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size()) {
+        return QVariant();
+    }
+    const PresenceRow &row = rows.at(index.row());
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+        case 0:
+            return row.username;
+        case 1:
+            return row.time;
+        }
+    } else if (role == Qt::DecorationRole && index.column() == 2) {
+        if (row.status == "online") {
+            return onlineIcon;
+        } else if (row.status == "offline") {
+            return offlineIcon;
+        }
+    }
+    return QVariant();
+}
+
+QVariant PresenceModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    static const QStringList headers = {"Username", "Time", "Status"};
+    return headers.value(section);
+}
@@ -0,0 +1,39 @@
+#ifndef PRESENCEMODEL_H
+#define PRESENCEMODEL_H
+
+#include "keyedtablemodel.h"
+#include <QIcon>
+#include <QJsonArray>
+
+struct PresenceRow {
+    QString username;
+    QString time;
+    QString status;
+
+    bool operator==(const PresenceRow &other) const
+    {
+        return username == other.username && time == other.time && status == other.status;
+    }
+};
+
+// Username, time and status of each employee's latest status event, as
+// shown in the admin window's presence table
+class PresenceModel : public KeyedTableModel<PresenceRow>
+{
+public:
+    explicit PresenceModel(QObject *parent = nullptr);
+
+    // Status events as returned by TimesheetStore::latestStatusAt
+    void setEvents(const QJsonArray &events);
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    // Shared by every row instead of one QIcon per row
+    QIcon onlineIcon;
+    QIcon offlineIcon;
+};
+
+#endif // PRESENCEMODEL_H
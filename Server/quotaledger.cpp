@@ -0,0 +1,207 @@
+#include "quotaledger.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QMutexLocker>
+#include <QDebug>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(serverCategory)
+
+QuotaLedger::QuotaLedger(const QString &baseDir, QObject *parent)
+    : QObject(parent),
+    baseDir(baseDir),
+    ledgerPath(baseDir + "/data/quota.json")
+{
+}
+
+void QuotaLedger::setLimits(qint64 userLimit, qint64 totalLimit, qint64 maxUpload)
+{
+    QMutexLocker locker(&mutex);
+    userLimitBytes = userLimit;
+    totalLimitBytes = totalLimit;
+    maxUploadBytes = maxUpload;
+}
+
+void QuotaLedger::load()
+{
+    QFile file(ledgerPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qCInfo(serverCategory) << "QuotaLedger: No ledger found, scanning media directories once";
+        rebuildFromDisk();
+        return;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    file.close();
+    if (parseError.error != QJsonParseError::NoError) {
+        qCWarning(serverCategory) << "QuotaLedger: JSON parse error, rebuilding:" << parseError.errorString();
+        rebuildFromDisk();
+        return;
+    }
+
+    {
+        QMutexLocker locker(&mutex);
+        usageByUser.clear();
+        totalByUser.clear();
+        totalBytes = 0;
+
+        const QJsonObject users = doc.object().value("users").toObject();
+        for (auto it = users.begin(); it != users.end(); ++it) {
+            const QJsonObject kinds = it.value().toObject();
+            for (auto kindIt = kinds.begin(); kindIt != kinds.end(); ++kindIt) {
+                qint64 bytes = kindIt.value().toInteger();
+                usageByUser[it.key()][kindIt.key()] = bytes;
+                totalByUser[it.key()] += bytes;
+                totalBytes += bytes;
+            }
+        }
+    }
+
+    emit usageChanged(totalUsage(), totalLimit());
+}
+
+void QuotaLedger::rebuildFromDisk()
+{
+    {
+        QMutexLocker locker(&mutex);
+        usageByUser.clear();
+        totalByUser.clear();
+        totalBytes = 0;
+
+        // Only uploaded originals count, derived thumbnails and previews do not
+        const QStringList kinds = {"avatar", "intro"};
+        for (const QString &kind : kinds) {
+            const QFileInfoList files = QDir(baseDir + "/" + kind).entryInfoList(QDir::Files);
+            for (const QFileInfo &info : files) {
+                const QString username = info.completeBaseName();
+                usageByUser[username][kind] = info.size();
+                totalByUser[username] += info.size();
+                totalBytes += info.size();
+            }
+        }
+    }
+
+    save();
+    emit usageChanged(totalUsage(), totalLimit());
+}
+
+QuotaLedger::Reservation QuotaLedger::reserve(const QString &username, const QString &kind, qint64 newSize)
+{
+    Reservation reservation{username, kind, newSize, 0, false};
+    QMutexLocker locker(&mutex);
+    if (maxUploadBytes > 0 && newSize > maxUploadBytes) {
+        return reservation;
+    }
+
+    const qint64 previous = usageByUser.value(username).value(kind, 0);
+    const qint64 growth = newSize - previous;
+    const qint64 userReserved = reservedByUser.value(username, 0);
+    if (userLimitBytes > 0 && totalByUser.value(username, 0) + userReserved + growth > userLimitBytes) {
+        return reservation;
+    }
+    if (totalLimitBytes > 0 && totalBytes + reservedBytes + growth > totalLimitBytes) {
+        return reservation;
+    }
+
+    // A smaller file frees nothing until it is written
+    reservation.booked = qMax<qint64>(0, growth);
+    reservation.valid = true;
+    if (reservation.booked > 0) {
+        reservedByUser[username] = userReserved + reservation.booked;
+        reservedBytes += reservation.booked;
+    }
+    return reservation;
+}
+
+void QuotaLedger::commit(const Reservation &reservation)
+{
+    if (!reservation.valid) {
+        return;
+    }
+    {
+        QMutexLocker locker(&mutex);
+        unbook(reservation);
+        const qint64 previous = usageByUser.value(reservation.username).value(reservation.kind, 0);
+        usageByUser[reservation.username][reservation.kind] = reservation.size;
+        totalByUser[reservation.username] += reservation.size - previous;
+        totalBytes += reservation.size - previous;
+    }
+
+    save();
+    emit usageChanged(totalUsage(), totalLimit());
+}
+
+void QuotaLedger::release(const Reservation &reservation)
+{
+    if (!reservation.valid) {
+        return;
+    }
+    QMutexLocker locker(&mutex);
+    unbook(reservation);
+}
+
+void QuotaLedger::unbook(const Reservation &reservation)
+{
+    if (reservation.booked <= 0) {
+        return;
+    }
+    reservedBytes -= reservation.booked;
+    auto it = reservedByUser.find(reservation.username);
+    if (it != reservedByUser.end()) {
+        *it -= reservation.booked;
+        if (*it <= 0) {
+            reservedByUser.erase(it);
+        }
+    }
+}
+
+qint64 QuotaLedger::usage(const QString &username) const
+{
+    QMutexLocker locker(&mutex);
+    return totalByUser.value(username, 0);
+}
+
+qint64 QuotaLedger::totalUsage() const
+{
+    QMutexLocker locker(&mutex);
+    return totalBytes;
+}
+
+void QuotaLedger::save()
+{
+    // Uploads finish on several pool threads; serialize the writes so an
+    // older snapshot can never overwrite a newer one
+    static QMutex saveMutex;
+    QMutexLocker saveLocker(&saveMutex);
+
+    QJsonObject users;
+    {
+        QMutexLocker locker(&mutex);
+        for (auto it = usageByUser.constBegin(); it != usageByUser.constEnd(); ++it) {
+            QJsonObject kinds;
+            for (auto kindIt = it.value().constBegin(); kindIt != it.value().constEnd(); ++kindIt) {
+                kinds[kindIt.key()] = kindIt.value();
+            }
+            users[it.key()] = kinds;
+        }
+    }
+
+    QJsonObject rootObj;
+    rootObj["users"] = users;
+
+    QSaveFile file(ledgerPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qCWarning(serverCategory) << "QuotaLedger: Couldn't open the ledger for writing:" << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(rootObj).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qCWarning(serverCategory) << "QuotaLedger: Couldn't save the ledger:" << file.errorString();
+    }
+}
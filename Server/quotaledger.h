@@ -0,0 +1,72 @@
+#ifndef QUOTALEDGER_H
+#define QUOTALEDGER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+// In-memory ledger of the media bytes each user has stored on the server.
+// Uploads reserve their bytes before anything is written and commit them
+// afterwards, so usage is known without walking the media directories and
+// concurrent uploads cannot together overrun a limit. The ledger is
+// persisted to data/quota.json and rebuilt by a one-time scan when missing.
+class QuotaLedger : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit QuotaLedger(const QString &baseDir, QObject *parent = nullptr);
+
+    void setLimits(qint64 userLimit, qint64 totalLimit, qint64 maxUpload);
+    qint64 userLimit() const { return userLimitBytes; }
+    qint64 totalLimit() const { return totalLimitBytes; }
+    qint64 maxUpload() const { return maxUploadBytes; }
+
+    void load();
+
+    // Bytes booked by an upload that is still being written
+    struct Reservation {
+        QString username;
+        QString kind;
+        qint64 size = 0;
+        qint64 booked = 0;  // Growth over the file it replaces, never negative
+        bool valid = false; // False when the upload would exceed a limit
+    };
+
+    // Checks that replacing the user's current file of this kind with one of
+    // newSize bytes stays within the per-user and total limits, counting
+    // uploads still in flight, and books the growth under the same lock.
+    // A valid reservation must end in exactly one commit() or release().
+    Reservation reserve(const QString &username, const QString &kind, qint64 newSize);
+    // The file was written: its size replaces the previous one in the ledger
+    void commit(const Reservation &reservation);
+    void release(const Reservation &reservation);
+
+    qint64 usage(const QString &username) const;
+    qint64 totalUsage() const;
+
+signals:
+    void usageChanged(qint64 totalBytes, qint64 totalLimit);
+
+private:
+    void rebuildFromDisk();
+    void save();
+    // Called with the mutex held
+    void unbook(const Reservation &reservation);
+
+    QString baseDir;
+    QString ledgerPath;
+    qint64 userLimitBytes = 0;
+    qint64 totalLimitBytes = 0;
+    qint64 maxUploadBytes = 0;
+
+    mutable QMutex mutex;
+    QHash<QString, QHash<QString, qint64>> usageByUser; // username -> kind -> bytes
+    QHash<QString, qint64> totalByUser;
+    qint64 totalBytes = 0;
+    QHash<QString, qint64> reservedByUser;
+    qint64 reservedBytes = 0;
+};
+
+#endif // QUOTALEDGER_H
@@ -0,0 +1,80 @@
+#include "requestlog.h"
+#include "asyncfilesink.h"
+#include "clock.h"
+#include "metrics.h"
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+static thread_local RequestScope *activeScope = nullptr;
+
+RequestLog::RequestLog(const QString &logDir)
+    : sink(new AsyncFileSink(logDir, "requests", "jsonl", 50 * 1024 * 1024, 60))
+{
+    sink->start();
+}
+
+RequestLog::~RequestLog() = default;
+
+void RequestLog::write(const RequestRecord &record)
+{
+    QJsonObject obj;
+    obj["ts"] = Clock::instance().now().toUTC().toString(Qt::ISODateWithMs);
+    obj["transport"] = record.transport;
+    if (record.connectionId) {
+        obj["conn"] = QString::number(record.connectionId);
+    }
+    obj["peer"] = record.peer;
+    obj["user"] = record.user;
+    obj["cmd"] = record.command;
+    obj["in"] = record.bytesIn;
+    obj["out"] = record.bytesOut;
+    obj["queue_us"] = record.queueUs;
+    obj["handler_us"] = record.handlerUs;
+    obj["storage_us"] = record.storageUs;
+    obj["result"] = record.result;
+    sink->append(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+}
+
+RequestScope::RequestScope(RequestLog *log, const QString &transport, const QString &command)
+    : log(log),
+    previous(activeScope)
+{
+    rec.transport = transport;
+    rec.command = command;
+    activeScope = this;
+    timer.start();
+}
+
+RequestScope::~RequestScope()
+{
+    rec.handlerUs = timer.nsecsElapsed() / 1000;
+    activeScope = previous;
+    Metrics::instance().recordRequest(rec.transport, rec.command, rec.handlerUs);
+    if (log) {
+        log->write(rec);
+    }
+}
+
+RequestRecord *RequestScope::current()
+{
+    return activeScope ? &activeScope->rec : nullptr;
+}
+
+StorageTimer::StorageTimer()
+{
+    timer.start();
+}
+
+void StorageTimer::stop()
+{
+    if (!running) {
+        return;
+    }
+    running = false;
+    const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+    Metrics::instance().recordStorage(elapsedUs);
+    if (RequestRecord *record = RequestScope::current()) {
+        record->storageUs += elapsedUs;
+    }
+}
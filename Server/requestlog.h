@@ -0,0 +1,76 @@
+#ifndef REQUESTLOG_H
+#define REQUESTLOG_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <memory>
+
+class AsyncFileSink;
+
+// One line of logs/requests-<date>.jsonl
+struct RequestRecord {
+    QString transport;        // "tcp" or "http"
+    quint64 connectionId = 0; // TCP connection, 0 for HTTP
+    QString peer;
+    QString user;
+    QString command;          // TCP request name or HTTP method and route
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+    qint64 queueUs = 0;       // Wait in the command scheduler before the handler ran
+    qint64 handlerUs = 0;
+    qint64 storageUs = 0;     // Part of handlerUs spent reading and writing data files
+    QString result;           // TCP response name or HTTP status code
+};
+
+// Structured per-request log, written through its own AsyncFileSink so a
+// request never waits on the disk. Safe to use from any thread.
+class RequestLog
+{
+public:
+    explicit RequestLog(const QString &logDir);
+    ~RequestLog();
+
+    void write(const RequestRecord &record);
+
+private:
+    std::unique_ptr<AsyncFileSink> sink;
+};
+
+// Times one request on the current thread and writes its record (and the
+// request metrics) when it goes out of scope. Storage timers, sendResponse()
+// and the HTTP helpers fill in the innermost active record through current().
+class RequestScope
+{
+public:
+    RequestScope(RequestLog *log, const QString &transport, const QString &command);
+    ~RequestScope();
+
+    RequestScope(const RequestScope &) = delete;
+    RequestScope &operator=(const RequestScope &) = delete;
+
+    RequestRecord &record() { return rec; }
+    static RequestRecord *current();
+
+private:
+    RequestLog *log;
+    RequestRecord rec;
+    QElapsedTimer timer;
+    RequestScope *previous;
+};
+
+// Adds the time until it is destroyed (or stop() is called) to the storage
+// time of the active request, if any, and to the storage metrics
+class StorageTimer
+{
+public:
+    StorageTimer();
+    ~StorageTimer() { stop(); }
+
+    void stop();
+
+private:
+    QElapsedTimer timer;
+    bool running = true;
+};
+
+#endif // REQUESTLOG_H
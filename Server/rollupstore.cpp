@@ -0,0 +1,188 @@
+#include "rollupstore.h"
+#include "timesheetstore.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QTime>
+
+Q_DECLARE_LOGGING_CATEGORY(serverCategory)
+
+static constexpr quint32 fileMagic = 0x524f4c4c; // "ROLL"
+static constexpr quint16 fileVersion = 2; // 2 added the rules fingerprint
+
+RollupStore::RollupStore(const QString &baseDir)
+    : base(baseDir)
+{
+}
+
+QString RollupStore::dayFilePath(const QDate &date) const
+{
+    return base + "/aggregates/" + date.toString("yyyy-MM-dd") + ".dat";
+}
+
+QByteArray RollupStore::dayRules(const QDate &date) const
+{
+    QFile file(dayFilePath(date));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_5);
+    quint32 magic = 0;
+    quint16 version = 0;
+    QByteArray fingerprint;
+    in >> magic >> version >> fingerprint;
+    return magic == fileMagic && version == fileVersion ? fingerprint : QByteArray();
+}
+
+RollupStore::UserTotals RollupStore::aggregate(const QJsonArray &events, const ScoringRules &rules)
+{
+    struct OpenSession {
+        QTime start;
+        bool isOnline = false;
+        ScoringRules::Day day;
+    };
+
+    UserTotals totals;
+    QHash<QString, OpenSession> open;
+    for (const QJsonValue &value : events) {
+        const QJsonObject event = value.toObject();
+        const QString username = event.value("username").toString();
+        const QString status = event.value("status").toString();
+        const QTime time = QTime::fromString(event.value("time").toString(), "hh:mm:ss");
+        OpenSession &session = open[username];
+        Totals &userTotals = totals[username];
+
+        if (status == "online") {
+            if (!session.isOnline) {
+                session.start = time;
+                session.isOnline = true;
+                ++userTotals.sessions;
+            }
+        } else if (status == "offline" && session.isOnline) {
+            session.isOnline = false;
+            if (session.start.isValid() && time.isValid()) {
+                rules.addSession(session.day, session.start.msecsSinceStartOfDay() / 1000,
+                                 time.msecsSinceStartOfDay() / 1000);
+            }
+        }
+    }
+
+    // Scored the same way as computeTimesheet, with open sessions closed at midnight
+    for (auto it = open.begin(); it != open.end(); ++it) {
+        if (it->isOnline && it->start.isValid()) {
+            rules.addSession(it->day, it->start.msecsSinceStartOfDay() / 1000, 86400);
+        }
+        Totals &userTotals = totals[it.key()];
+        userTotals.secondsOnline = it->day.onlineSeconds;
+        userTotals.points = rules.score(it->day).points;
+    }
+    return totals;
+}
+
+bool RollupStore::finalizeDay(const TimesheetStore &store, const QDate &date, const ScoringRules &rules) const
+{
+    const UserTotals totals = aggregate(store.loadStatusEvents(date), rules);
+
+    const QString filePath = dayFilePath(date);
+    if (!QDir().mkpath(QFileInfo(filePath).path())) {
+        qCWarning(serverCategory) << "finalizeDay: Couldn't create the directory for" << filePath;
+        return false;
+    }
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(serverCategory) << "finalizeDay: Couldn't open the file for writing:" << file.errorString();
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_5);
+    out << fileMagic << fileVersion << rules.fingerprint() << quint32(totals.size());
+    for (auto it = totals.constBegin(); it != totals.constEnd(); ++it) {
+        out << it.key() << it->secondsOnline << it->sessions << it->points;
+    }
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qCWarning(serverCategory) << "finalizeDay: Failed to write to the file:" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+int RollupStore::catchUp(const TimesheetStore &store, const QDate &before, const ScoringRules &rules) const
+{
+    int finalized = 0;
+    const QStringList days = QDir(store.baseDir() + "/status").entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    for (const QString &day : days) {
+        const QDate date = QDate::fromString(day, "yyyy-MM-dd");
+        if (date.isValid() && date < before && dayRules(date) != rules.fingerprint()
+            && finalizeDay(store, date, rules)) {
+            ++finalized;
+        }
+    }
+    if (finalized > 0) {
+        qCInfo(serverCategory) << "RollupStore: Finalized" << finalized << "days before" << before;
+    }
+    return finalized;
+}
+
+bool RollupStore::loadDay(const QDate &date, const QByteArray &rules, UserTotals &totals) const
+{
+    QFile file(dayFilePath(date));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_5);
+    quint32 magic = 0;
+    quint16 version = 0;
+    QByteArray fingerprint;
+    quint32 count = 0;
+    in >> magic >> version >> fingerprint >> count;
+    if (magic != fileMagic || version != fileVersion) {
+        qCWarning(serverCategory) << "loadDay: Not an aggregate file:" << file.fileName();
+        return false;
+    }
+    if (fingerprint != rules) {
+        return false; // Being finalized again under the new rules
+    }
+
+    totals.reserve(totals.size() + count);
+    QString username;
+    Totals day;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        in >> username >> day.secondsOnline >> day.sessions >> day.points;
+        totals[username] += day;
+    }
+    if (in.status() != QDataStream::Ok) {
+        qCWarning(serverCategory) << "loadDay: Truncated aggregate file:" << file.fileName();
+        return false;
+    }
+    return true;
+}
+
+RollupStore::UserTotals RollupStore::range(const QDate &from, const QDate &to, const QByteArray &rules,
+                                           QList<QDate> *missing) const
+{
+    UserTotals totals;
+    for (QDate date = from; date.isValid() && date <= to; date = date.addDays(1)) {
+        if (!loadDay(date, rules, totals) && missing) {
+            missing->append(date);
+        }
+    }
+    return totals;
+}
+
+QPair<QDate, QDate> RollupStore::weekOf(const QDate &date)
+{
+    const QDate monday = date.addDays(1 - date.dayOfWeek());
+    return {monday, monday.addDays(6)};
+}
+
+QPair<QDate, QDate> RollupStore::monthOf(const QDate &date)
+{
+    const QDate first(date.year(), date.month(), 1);
+    return {first, first.addDays(date.daysInMonth() - 1)};
+}
@@ -0,0 +1,73 @@
+#ifndef ROLLUPSTORE_H
+#define ROLLUPSTORE_H
+
+#include <QDate>
+#include <QHash>
+#include <QJsonArray>
+#include <QList>
+#include <QString>
+#include "scoringrules.h"
+
+class TimesheetStore;
+
+// Daily totals per user, finalized once a day is over, and the week, month
+// and date-range reports summed from them. A report reads one small binary
+// file per day instead of every raw status event of the period:
+//
+//   aggregates/<yyyy-MM-dd>.dat   QDataStream: magic, version, rules fingerprint,
+//                                 count, then {username, secondsOnline, sessions, points}
+//
+// Days are finalized at the first clock tick of the next day, and on start
+// for any earlier day that has status events but no aggregate yet. Today is
+// never finalized, so reports cover closed days only. Points depend on the
+// scoring rules, so a day finalized under other rules is finalized again.
+class RollupStore
+{
+public:
+    struct Totals {
+        qint64 secondsOnline = 0;
+        qint32 sessions = 0;
+        qint64 points = 0;
+
+        Totals &operator+=(const Totals &other)
+        {
+            secondsOnline += other.secondsOnline;
+            sessions += other.sessions;
+            points += other.points;
+            return *this;
+        }
+    };
+    using UserTotals = QHash<QString, Totals>;
+
+    explicit RollupStore(const QString &baseDir);
+
+    QString dayFilePath(const QDate &date) const;
+    // Fingerprint of the rules the day was finalized under; empty when it wasn't
+    QByteArray dayRules(const QDate &date) const;
+
+    // Totals of one day's status events; a session still open at the end of
+    // the day counts until midnight
+    static UserTotals aggregate(const QJsonArray &events, const ScoringRules &rules);
+
+    // Aggregates the day's status events and stores the result
+    bool finalizeDay(const TimesheetStore &store, const QDate &date, const ScoringRules &rules) const;
+    // Finalizes every day before the given one that has status events but
+    // no aggregate under these rules; returns how many
+    int catchUp(const TimesheetStore &store, const QDate &before, const ScoringRules &rules) const;
+
+    // Adds the day's totals if it was finalized under the rules with this fingerprint
+    bool loadDay(const QDate &date, const QByteArray &rules, UserTotals &totals) const;
+    // Sum over from..to inclusive; days without an aggregate under the rules
+    // are skipped and listed in missing
+    UserTotals range(const QDate &from, const QDate &to, const QByteArray &rules,
+                     QList<QDate> *missing = nullptr) const;
+
+    // Monday to Sunday around date, and the calendar month of date
+    static QPair<QDate, QDate> weekOf(const QDate &date);
+    static QPair<QDate, QDate> monthOf(const QDate &date);
+
+private:
+    QString base;
+};
+
+#endif // ROLLUPSTORE_H
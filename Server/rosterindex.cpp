@@ -0,0 +1,197 @@
+#include "rosterindex.h"
+#include <QJsonArray>
+#include <algorithm>
+#include <iterator>
+
+QString RosterIndex::fold(const QString &text)
+{
+    const QString decomposed = text.normalized(QString::NormalizationForm_D);
+    QString folded;
+    folded.reserve(decomposed.size());
+    for (const QChar c : decomposed) {
+        if (c.category() == QChar::Mark_NonSpacing) {
+            continue;
+        }
+        if (c == QChar(0x0110) || c == QChar(0x0111)) {
+            folded.append(QLatin1Char('d')); // Đ and đ have no decomposition
+            continue;
+        }
+        folded.append(c.toCaseFolded());
+    }
+    return folded;
+}
+
+quint64 RosterIndex::trigramAt(QStringView text, qsizetype i)
+{
+    return (quint64(text.at(i).unicode()) << 32) | (quint64(text.at(i + 1).unicode()) << 16)
+           | quint64(text.at(i + 2).unicode());
+}
+
+QList<quint64> RosterIndex::trigramsOf(const QString &a, const QString &b)
+{
+    QList<quint64> trigrams;
+    for (const QString &text : {a, b}) {
+        for (qsizetype i = 0; i + 2 < text.size(); ++i) {
+            trigrams.append(trigramAt(text, i));
+        }
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+QList<RosterIndex::PrefixEntry> RosterIndex::prefixEntriesOf(int id) const
+{
+    QList<PrefixEntry> entries;
+    entries.append({foldedUsernames.at(id), id});
+
+    // The full name from each of its words on, so "an" finds "Nguyen Van An"
+    const QString &fullName = foldedFullNames.at(id);
+    for (qsizetype i = 0; i < fullName.size(); ++i) {
+        if (fullName.at(i) != QLatin1Char(' ') && (i == 0 || fullName.at(i - 1) == QLatin1Char(' '))) {
+            const QString key = fullName.mid(i);
+            if (key != entries.first().key) {
+                entries.append({key, id});
+            }
+        }
+    }
+    return entries;
+}
+
+void RosterIndex::addTrigrams(int id)
+{
+    for (quint64 trigram : trigramsOf(foldedUsernames.at(id), foldedFullNames.at(id))) {
+        QList<int> &ids = postings[trigram];
+        if (ids.isEmpty() || ids.last() < id) {
+            ids.append(id); // Always the case during a rebuild
+        } else {
+            ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+        }
+    }
+}
+
+void RosterIndex::removeTrigrams(int id)
+{
+    for (quint64 trigram : trigramsOf(foldedUsernames.at(id), foldedFullNames.at(id))) {
+        auto it = postings.find(trigram);
+        if (it == postings.end()) {
+            continue;
+        }
+        auto pos = std::lower_bound(it->begin(), it->end(), id);
+        if (pos != it->end() && *pos == id) {
+            it->erase(pos);
+        }
+        if (it->isEmpty()) {
+            postings.erase(it);
+        }
+    }
+}
+
+void RosterIndex::rebuild(const QJsonObject &accounts, const QJsonObject &profiles)
+{
+    usernames.clear();
+    foldedUsernames.clear();
+    foldedFullNames.clear();
+    idOf.clear();
+    prefixes.clear();
+    postings.clear();
+
+    const QJsonArray users = accounts.value("users").toArray();
+    usernames.reserve(users.size());
+    foldedUsernames.reserve(users.size());
+    foldedFullNames.reserve(users.size());
+    idOf.reserve(users.size());
+    for (const QJsonValue &user : users) {
+        const QString username = user.toObject().value("username").toString();
+        if (username.isEmpty() || idOf.contains(username)) {
+            continue; // account.json allows duplicates; the first one is the one that logs in
+        }
+        idOf.insert(username, int(usernames.size()));
+        usernames.append(username);
+        foldedUsernames.append(fold(username));
+        foldedFullNames.append(fold(profiles.value(username).toObject().value("Fullname").toString()));
+    }
+
+    prefixes.reserve(usernames.size() * 3);
+    for (int id = 0; id < usernames.size(); ++id) {
+        prefixes.append(prefixEntriesOf(id));
+        addTrigrams(id);
+    }
+    std::sort(prefixes.begin(), prefixes.end());
+}
+
+void RosterIndex::setFullName(const QString &username, const QString &fullName)
+{
+    const int id = idOf.value(username, -1);
+    if (id < 0) {
+        return;
+    }
+
+    for (const PrefixEntry &entry : prefixEntriesOf(id)) {
+        auto pos = std::lower_bound(prefixes.begin(), prefixes.end(), entry);
+        if (pos != prefixes.end() && pos->key == entry.key && pos->id == id) {
+            prefixes.erase(pos);
+        }
+    }
+    removeTrigrams(id);
+
+    foldedFullNames[id] = fold(fullName);
+
+    for (const PrefixEntry &entry : prefixEntriesOf(id)) {
+        prefixes.insert(std::lower_bound(prefixes.begin(), prefixes.end(), entry), entry);
+    }
+    addTrigrams(id);
+}
+
+QStringList RosterIndex::search(const QString &text) const
+{
+    const QString query = fold(text.trimmed());
+    if (query.isEmpty()) {
+        return QStringList();
+    }
+
+    QList<int> ids;
+    if (query.size() < 3) {
+        auto it = std::lower_bound(prefixes.begin(), prefixes.end(), PrefixEntry{query, -1});
+        for (; it != prefixes.end() && it->key.startsWith(query); ++it) {
+            ids.append(it->id);
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    } else {
+        // Intersect from the shortest list; every match has all the query's trigrams
+        QList<const QList<int> *> lists;
+        for (qsizetype i = 0; i + 2 < query.size(); ++i) {
+            auto it = postings.constFind(trigramAt(query, i));
+            if (it == postings.constEnd()) {
+                return QStringList();
+            }
+            lists.append(&*it);
+        }
+        std::sort(lists.begin(), lists.end(), [](const QList<int> *a, const QList<int> *b) {
+            return a->size() < b->size();
+        });
+
+        QList<int> candidates = *lists.first();
+        for (qsizetype i = 1; i < lists.size() && !candidates.isEmpty(); ++i) {
+            QList<int> narrowed;
+            std::set_intersection(candidates.begin(), candidates.end(), lists.at(i)->begin(),
+                                  lists.at(i)->end(), std::back_inserter(narrowed));
+            candidates.swap(narrowed);
+        }
+
+        // Trigrams do not keep their order, so check the candidates
+        for (int id : std::as_const(candidates)) {
+            if (foldedUsernames.at(id).contains(query) || foldedFullNames.at(id).contains(query)) {
+                ids.append(id);
+            }
+        }
+    }
+
+    QStringList result;
+    result.reserve(ids.size());
+    for (int id : std::as_const(ids)) {
+        result.append(usernames.at(id));
+    }
+    return result;
+}
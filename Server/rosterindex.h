@@ -0,0 +1,68 @@
+#ifndef ROSTERINDEX_H
+#define ROSTERINDEX_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+// Search index over the usernames and full names of all accounts, for the
+// admin window's roster search. Names are folded once when indexed (case and
+// Vietnamese diacritics removed, so "nguyen" finds "Nguyễn"), and kept in:
+//
+//   - a sorted array of the username, the full name and every later word of
+//     the full name, for prefix search by binary search;
+//   - posting lists of account ids per trigram, for substring search by
+//     intersecting the lists of the query's trigrams.
+//
+// Neither walks all accounts, so a query costs roughly the size of its
+// result. Accounts keep their id, their position in account.json.
+class RosterIndex
+{
+public:
+    // accounts is {"users": [{username}]}, profiles {username: info}; the
+    // full name is info["Fullname"]
+    void rebuild(const QJsonObject &accounts, const QJsonObject &profiles);
+    // Reindexes one account after its profile changed
+    void setFullName(const QString &username, const QString &fullName);
+
+    int size() const { return int(usernames.size()); }
+    // Every indexed username, in account order
+    const QStringList &allUsernames() const { return usernames; }
+
+    // Usernames whose username or full name contains text, in account order.
+    // Queries shorter than a trigram match by prefix of the username, the
+    // full name or any word of it instead.
+    QStringList search(const QString &text) const;
+
+    static QString fold(const QString &text);
+
+private:
+    struct PrefixEntry {
+        QString key;
+        int id;
+
+        bool operator<(const PrefixEntry &other) const
+        {
+            return key < other.key || (key == other.key && id < other.id);
+        }
+    };
+
+    static quint64 trigramAt(QStringView text, qsizetype i);
+    static QList<quint64> trigramsOf(const QString &a, const QString &b);
+    QList<PrefixEntry> prefixEntriesOf(int id) const;
+    void addTrigrams(int id);
+    void removeTrigrams(int id);
+
+    QStringList usernames;
+    QStringList foldedUsernames;
+    QStringList foldedFullNames;
+    QHash<QString, int> idOf;
+
+    QList<PrefixEntry> prefixes;             // Sorted
+    QHash<quint64, QList<int>> postings;     // Trigram -> sorted ids
+};
+
+#endif // ROSTERINDEX_H
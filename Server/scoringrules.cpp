@@ -0,0 +1,249 @@
+#include "scoringrules.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QTime>
+#include <algorithm>
+#include <limits>
+
+static constexpr int secondsPerDay = 86400;
+
+// "hh:mm" or "hh:mm:ss"; "24:00" is the end of the day; -1 when malformed
+static int secondOfDay(const QString &text)
+{
+    if (text == "24:00" || text == "24:00:00") {
+        return secondsPerDay;
+    }
+    QTime time = QTime::fromString(text, "hh:mm:ss");
+    if (!time.isValid()) {
+        time = QTime::fromString(text, "hh:mm");
+    }
+    return time.isValid() ? time.msecsSinceStartOfDay() / 1000 : -1;
+}
+
+ScoringRules::ScoringRules()
+{
+    compile(QJsonObject());
+}
+
+const ScoringRules &ScoringRules::standard()
+{
+    static const ScoringRules rules;
+    return rules;
+}
+
+qint64 ScoringRules::RateTable::integral(qint64 x) const
+{
+    const qsizetype i = std::upper_bound(start.cbegin(), start.cend(), x) - start.cbegin() - 1;
+    return cumulative.at(i) + (x - start.at(i)) * rate.at(i);
+}
+
+// Steps are (start, rate) sorted by start, the first starting at 0
+ScoringRules::RateTable ScoringRules::buildTable(const QList<QPair<qint64, qint64>> &steps)
+{
+    RateTable table;
+    table.start.reserve(steps.size());
+    table.rate.reserve(steps.size());
+    table.cumulative.reserve(steps.size());
+    qint64 total = 0;
+    for (qsizetype i = 0; i < steps.size(); ++i) {
+        if (i > 0) {
+            total += (steps.at(i).first - steps.at(i - 1).first) * steps.at(i - 1).second;
+        }
+        table.start.append(steps.at(i).first);
+        table.rate.append(steps.at(i).second);
+        table.cumulative.append(total);
+    }
+    return table;
+}
+
+bool ScoringRules::compile(const QJsonObject &rules, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+
+    const double perSecond = rules.value("pointsPerSecond").toDouble(5);
+    if (perSecond < 0) {
+        return fail("pointsPerSecond is negative");
+    }
+    const qint64 base = qRound64(perSecond * 1000);
+
+    // Time-of-day windows, cut into segments that each have one rate
+    struct Window {
+        int from;
+        int to;
+        double multiplier;
+    };
+    QList<Window> windows;
+    QList<qint64> cuts = {0};
+    for (const QJsonValue &value : rules.value("rates").toArray()) {
+        const QJsonObject windowObj = value.toObject();
+        const int from = secondOfDay(windowObj.value("from").toString());
+        const int to = secondOfDay(windowObj.value("to").toString());
+        const double multiplier = windowObj.value("multiplier").toDouble(-1);
+        if (from < 0 || to < 0 || multiplier < 0) {
+            return fail("rates: every window needs from, to and a multiplier of at least 0");
+        }
+        if (from < to) {
+            windows.append({from, to, multiplier});
+        } else if (from > to) {
+            // Wraps past midnight, e.g. 22:00 to 06:00
+            windows.append({from, secondsPerDay, multiplier});
+            windows.append({0, to, multiplier});
+        }
+    }
+    for (const Window &window : std::as_const(windows)) {
+        cuts.append(window.from);
+        cuts.append(window.to);
+    }
+    std::sort(cuts.begin(), cuts.end());
+    cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+
+    QList<QPair<qint64, qint64>> daySteps;
+    for (qint64 cut : std::as_const(cuts)) {
+        if (cut >= secondsPerDay) {
+            break;
+        }
+        double multiplier = -1;
+        for (const Window &window : std::as_const(windows)) {
+            if (window.from <= cut && cut < window.to) {
+                multiplier = qMax(multiplier, window.multiplier);
+            }
+        }
+        const qint64 rate = qRound64(base * (multiplier < 0 ? 1.0 : multiplier));
+        if (daySteps.isEmpty() || daySteps.last().second != rate) {
+            daySteps.append({cut, rate});
+        }
+    }
+
+    QList<QPair<qint64, double>> overtimeTiers;
+    for (const QJsonValue &value : rules.value("overtime").toArray()) {
+        const QJsonObject tierObj = value.toObject();
+        const double afterHours = tierObj.value("afterHours").toDouble(-1);
+        const double multiplier = tierObj.value("multiplier").toDouble(-1);
+        if (afterHours < 0 || multiplier < 1) {
+            return fail("overtime: every tier needs afterHours and a multiplier of at least 1");
+        }
+        overtimeTiers.append({qRound64(afterHours * 3600), multiplier});
+    }
+    std::sort(overtimeTiers.begin(), overtimeTiers.end());
+    QList<QPair<qint64, qint64>> overtimeSteps = {{0, 0}};
+    for (const auto &tier : std::as_const(overtimeTiers)) {
+        const qint64 extra = qRound64(base * (tier.second - 1));
+        if (overtimeSteps.last().first == tier.first) {
+            overtimeSteps.last().second = extra;
+        } else {
+            overtimeSteps.append({tier.first, extra});
+        }
+    }
+
+    int compiledLateAfter = -1;
+    qint64 compiledLatePerMinute = 0;
+    qint64 compiledLateMax = 0;
+    if (rules.contains("late")) {
+        const QJsonObject lateObj = rules.value("late").toObject();
+        compiledLateAfter = secondOfDay(lateObj.value("after").toString());
+        const double perMinute = lateObj.value("pointsPerMinute").toDouble(-1);
+        if (compiledLateAfter < 0 || perMinute < 0) {
+            return fail("late: needs after and pointsPerMinute");
+        }
+        compiledLatePerMinute = qRound64(perMinute * 1000);
+        compiledLateMax = qRound64(lateObj.value("max").toDouble(0) * 1000);
+    }
+
+    QList<QPair<qint64, qint64>> breakTiers;
+    for (const QJsonValue &value : rules.value("breaks").toArray()) {
+        const QJsonObject tierObj = value.toObject();
+        const double afterHours = tierObj.value("afterHours").toDouble(-1);
+        const double minutes = tierObj.value("minutes").toDouble(-1);
+        if (afterHours < 0 || minutes < 0) {
+            return fail("breaks: every tier needs afterHours and minutes");
+        }
+        breakTiers.append({qRound64(afterHours * 3600), qRound64(minutes * 60) * base / 1000});
+    }
+    std::sort(breakTiers.begin(), breakTiers.end());
+
+    baseMilli = base;
+    dayRates = buildTable(daySteps);
+    overtimeRates = buildTable(overtimeSteps);
+    lateAfter = compiledLateAfter;
+    latePerMinute = compiledLatePerMinute;
+    lateMax = compiledLateMax;
+    breakAfter.clear();
+    breakDeduction.clear();
+    for (const auto &tier : std::as_const(breakTiers)) {
+        breakAfter.append(tier.first);
+        breakDeduction.append(tier.second);
+    }
+    // QJsonObject keeps its keys sorted, so equal rules print the same
+    print = QCryptographicHash::hash(QJsonDocument(rules).toJson(QJsonDocument::Compact),
+                                     QCryptographicHash::Sha1).left(8);
+    return true;
+}
+
+bool ScoringRules::load(const QString &filePath, QString *error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        if (error) {
+            *error = parseError.error != QJsonParseError::NoError ? parseError.errorString()
+                                                                  : QString("not a JSON object");
+        }
+        return false;
+    }
+    return compile(doc.object(), error);
+}
+
+void ScoringRules::addSession(Day &day, int startSec, int endSec) const
+{
+    startSec = qBound(0, startSec, secondsPerDay);
+    endSec = qBound(0, endSec, secondsPerDay);
+    if (endSec < startSec) {
+        return;
+    }
+    if (day.firstOnline < 0 || startSec < day.firstOnline) {
+        day.firstOnline = startSec;
+    }
+    day.onlineSeconds += endSec - startSec;
+    day.milliPoints += dayRates.integral(endSec) - dayRates.integral(startSec);
+}
+
+ScoringRules::Score ScoringRules::score(const Day &day) const
+{
+    const qint64 bonus = overtimeRates.integral(day.onlineSeconds) / 1000;
+
+    qint64 minus = 0;
+    if (lateAfter >= 0 && day.firstOnline > lateAfter) {
+        const qint64 minutesLate = (day.firstOnline - lateAfter + 59) / 60;
+        qint64 penalty = minutesLate * latePerMinute;
+        if (lateMax > 0) {
+            penalty = qMin(penalty, lateMax);
+        }
+        minus += penalty / 1000;
+    }
+    const qsizetype tier = std::upper_bound(breakAfter.cbegin(), breakAfter.cend(), day.onlineSeconds)
+                           - breakAfter.cbegin() - 1;
+    if (tier >= 0 && day.onlineSeconds > 0) {
+        minus += breakDeduction.at(tier);
+    }
+
+    Score result;
+    result.bonus = int(qMin<qint64>(bonus, std::numeric_limits<int>::max()));
+    result.minus = int(qMin<qint64>(minus, std::numeric_limits<int>::max()));
+    result.points = qMax<qint64>(0, day.milliPoints / 1000 + result.bonus - result.minus);
+    return result;
+}
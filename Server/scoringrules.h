@@ -0,0 +1,83 @@
+#ifndef SCORINGRULES_H
+#define SCORINGRULES_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+// How a day online turns into points, read from scoring.json and compiled
+// once into lookup tables, so scoring a session is two binary searches no
+// matter how many rules a site has:
+//
+//   {
+//     "pointsPerSecond": 5,
+//     "rates":    [{"from": "18:00", "to": "22:00", "multiplier": 1.5}],
+//     "overtime": [{"afterHours": 8, "multiplier": 1.5}],
+//     "late":     {"after": "09:00", "pointsPerMinute": 10, "max": 600},
+//     "breaks":   [{"afterHours": 6, "minutes": 30}]
+//   }
+//
+// rates      time-of-day windows paid at a multiple of the base rate; where
+//            windows overlap the highest multiplier applies
+// overtime   seconds online beyond afterHours earn the multiplier, as bonus
+// late       a first login after "after" costs pointsPerMinute per started
+//            minute, at most max, as minus
+// breaks     a day online for at least afterHours is docked minutes at the
+//            base rate, as minus; the highest tier reached applies
+//
+// Every section is optional; without a file the rules are the plain five
+// points per second online the server always used.
+class ScoringRules
+{
+public:
+    // What the rules need to know about one user's day, filled in session by session
+    struct Day {
+        int firstOnline = -1;     // Second of the day of the first login
+        qint64 onlineSeconds = 0;
+        qint64 milliPoints = 0;   // Time-of-day rated points, in thousandths
+    };
+    struct Score {
+        int bonus = 0;
+        int minus = 0;
+        qint64 points = 0;        // Never below zero
+    };
+
+    ScoringRules();
+
+    // Compiles a rules object; returns false and leaves the rules unchanged
+    // when it is invalid
+    bool compile(const QJsonObject &rules, QString *error = nullptr);
+    bool load(const QString &filePath, QString *error = nullptr);
+    // Identifies the compiled rules, so totals scored under other rules can be told apart
+    QByteArray fingerprint() const { return print; }
+
+    // Session from startSec to endSec, seconds of the day (86400 is midnight at the end)
+    void addSession(Day &day, int startSec, int endSec) const;
+    Score score(const Day &day) const;
+
+    // The built-in rules: five points per second, nothing else
+    static const ScoringRules &standard();
+
+private:
+    // Piecewise constant rate over x, with the integral up to each step precomputed
+    struct RateTable {
+        QList<qint64> start;      // Ascending, first is 0
+        QList<qint64> rate;       // Thousandths of a point per unit of x
+        QList<qint64> cumulative; // Integral from 0 to start
+        qint64 integral(qint64 x) const;
+    };
+    static RateTable buildTable(const QList<QPair<qint64, qint64>> &steps);
+
+    qint64 baseMilli = 5000;
+    RateTable dayRates;           // x = second of the day
+    RateTable overtimeRates;      // x = seconds online, rate is the extra on top of the base
+    int lateAfter = -1;
+    qint64 latePerMinute = 0;
+    qint64 lateMax = 0;
+    QList<qint64> breakAfter;     // Ascending seconds online
+    QList<qint64> breakDeduction; // Points docked from that tier on
+    QByteArray print;
+};
+
+#endif // SCORINGRULES_H
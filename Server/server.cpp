@@ -6,7 +6,6 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonParseError>
-#include <QStandardItemModel>
 #include <QJsonArray>
 #include <QDateTime>
 #include <QStandardPaths>
@@ -21,7 +20,6 @@
 #include <QNetworkReply>
 #include <QHttpMultiPart>
 #include <QHttpPart>
-#include <QMessageBox>
 #include <QCryptographicHash>
 #include <QNetworkInterface>
 #include <QDataStream>
@@ -32,29 +30,193 @@
 #include <QImageReader>
 #include <QRegularExpression>
 #include <QRegularExpressionMatch>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QUrlQuery>
+#include <QtConcurrent>
+#include <QImage>
+#include <iterator>
+#include "filerangedevice.h"
+#include "intropreviewworker.h"
+#include "quotaledger.h"
+#include "requestlog.h"
+#include "metrics.h"
+#include "eventloopwatchdog.h"
+#include "tracer.h"
+#include "trafficcapture.h"
+#include "clock.h"
+#include "commandscheduler.h"
+#include "accounttransfer.h"
+#include "accountworker.h"
+#include "presencemodel.h"
+#include "timesheetmodel.h"
+#include <QSettings>
+#include <QFileDialog>
+#include <QLabel>
 
 Q_LOGGING_CATEGORY(serverCategory, "server")
 Q_LOGGING_CATEGORY(serverLog, "server.log")
 
+enum class ByteRangeResult { Full, Partial, Unsatisfiable };
+
+// Parses a single "bytes=first-last" range (RFC 7233). Multi-range requests
+// and malformed headers fall back to serving the whole file.
+static ByteRangeResult parseByteRange(const QByteArray &header, qint64 totalSize, qint64 *first, qint64 *last)
+{
+    *first = 0;
+    *last = totalSize - 1;
+
+    QByteArray spec = header.trimmed();
+    if (!spec.startsWith("bytes=") || spec.contains(',')) {
+        return ByteRangeResult::Full;
+    }
+    spec = spec.mid(6).trimmed();
+
+    int dashIndex = spec.indexOf('-');
+    if (dashIndex < 0) {
+        return ByteRangeResult::Full;
+    }
+
+    const QByteArray startStr = spec.left(dashIndex).trimmed();
+    const QByteArray endStr = spec.mid(dashIndex + 1).trimmed();
+    bool ok = false;
+
+    if (startStr.isEmpty()) {
+        // Suffix range: the last N bytes
+        qint64 suffixLength = endStr.toLongLong(&ok);
+        if (!ok || suffixLength <= 0 || totalSize == 0) {
+            return ByteRangeResult::Unsatisfiable;
+        }
+        *first = qMax<qint64>(0, totalSize - suffixLength);
+        return ByteRangeResult::Partial;
+    }
+
+    qint64 start = startStr.toLongLong(&ok);
+    if (!ok || start < 0) {
+        return ByteRangeResult::Full;
+    }
+    if (start >= totalSize) {
+        return ByteRangeResult::Unsatisfiable;
+    }
+
+    qint64 end = totalSize - 1;
+    if (!endStr.isEmpty()) {
+        end = endStr.toLongLong(&ok);
+        if (!ok || end < start) {
+            return ByteRangeResult::Full;
+        }
+        end = qMin(end, totalSize - 1);
+    }
+
+    *first = start;
+    *last = end;
+    return ByteRangeResult::Partial;
+}
+
+// Avatar thumbnail edge lengths, smallest first
+static const int avatarThumbnailSizes[] = {32, 64, 256};
+
+// If-None-Match carries a comma separated list of entity tags or "*"
+static bool etagMatches(const QByteArray &ifNoneMatch, const QByteArray &etag)
+{
+    if (ifNoneMatch.isEmpty()) {
+        return false;
+    }
+    const QList<QByteArray> candidates = ifNoneMatch.split(',');
+    for (QByteArray candidate : candidates) {
+        candidate = candidate.trimmed();
+        if (candidate.startsWith("W/")) {
+            candidate = candidate.mid(2);
+        }
+        if (candidate == "*" || candidate == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Usernames end up in file paths, so only plain names are accepted
+static bool isValidMediaName(const QString &name)
+{
+    static const QRegularExpression namePattern("^[A-Za-z0-9_][A-Za-z0-9_.-]*$");
+    return !name.contains("..") && namePattern.match(name).hasMatch();
+}
+
+// Fills the request log fields every HTTP route shares
+static void describeHttpRequest(RequestRecord &record, const QHttpServerRequest &request, const QString &user = QString())
+{
+    record.peer = request.remoteAddress().toString();
+    record.bytesIn = request.body().size();
+    record.user = user;
+}
+
+// Streamed bodies are counted when the transfer is handed to the responder,
+// the handler time does not include the transfer itself
+static void recordHttpResult(QHttpServerResponder::StatusCode status, qint64 bytesOut = 0)
+{
+    if (RequestRecord *record = RequestScope::current()) {
+        record->result = QString::number(int(status));
+        record->bytesOut += bytesOut;
+    }
+}
+
+// A response for a route that otherwise completes on a pool thread.
+// makeReadyFuture is deprecated from 6.6 on; CI still builds with 6.5.
+static QFuture<QHttpServerResponse> readyResponse(QHttpServerResponse::StatusCode status)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    return QtFuture::makeReadyValueFuture(QHttpServerResponse(status));
+#else
+    return QtFuture::makeReadyFuture(QHttpServerResponse(status));
+#endif
+}
+
 server::server(QWidget *parent)
     : QMainWindow(parent),
     ui(new Ui::server),
     tcpServer(nullptr),
-    httpServer(nullptr)
+    timesheetStore(QCoreApplication::applicationDirPath()),
+    accountStore(QCoreApplication::applicationDirPath()),
+    sessionTokens(QCoreApplication::applicationDirPath() + "/data/session.key"),
+    httpServer(nullptr),
+    httpThread(nullptr),
+    introThread(nullptr),
+    introWorker(nullptr),
+    accountThread(nullptr),
+    accountWorker(nullptr),
+    quotaLedger(nullptr),
+    lblMediaUsage(nullptr),
+    presenceModel(nullptr),
+    timesheetModel(nullptr),
+    presenceTimer(nullptr),
+    scoringRules(std::make_shared<ScoringRules>()),
+    rollupStore(QCoreApplication::applicationDirPath()),
+    commandScheduler(nullptr),
+    requestLog(nullptr),
+    watchdog(nullptr)
 {
     try {
         qInfo() << "Initializing server UI...";
         ui->setupUi(this);
+        presenceModel = new PresenceModel(this);
+        ui->tableView->setModel(presenceModel);
+        timesheetModel = new TimesheetModel(this);
+        ui->tableTimesheet->setModel(timesheetModel);
+        connect(ui->leSearch, &QLineEdit::textChanged, this, &server::applyRosterFilter);
+        connect(ui->cbStatusFilter, &QComboBox::currentIndexChanged, this, &server::applyRosterFilter);
+        connect(ui->sbPointsMin, &QSpinBox::valueChanged, this, &server::applyRosterFilter);
+        connect(ui->sbPointsMax, &QSpinBox::valueChanged, this, &server::applyRosterFilter);
         
         qInfo() << "Creating TCP server...";
         tcpServer = new QTcpServer(this);
         
         qInfo() << "Creating HTTP server...";
-        httpServer = new QHttpServer(this);
+        // No parent: the HTTP server is moved to its own thread in setupHttpServer()
+        httpServer = new QHttpServer();
         
         qInfo() << "Setting up directories...";
         QDir appDir(QCoreApplication::applicationDirPath());
-        QStringList requiredDirs = {"account", "status", "timesheet", "data", "avatar", "intro", "points"};
+        QStringList requiredDirs = {"account", "status", "timesheet", "data", "avatar", "intro", "points", "aggregates"};
         
         for (const QString &dir : requiredDirs) {
             if (!appDir.exists(dir)) {
@@ -68,8 +230,19 @@ server::server(QWidget *parent)
             }
         }
         
+        requestLog = new RequestLog(appDir.filePath("logs"));
+
         qInfo() << "Creating initial JSON files...";
         createInitialJsonFiles();
+
+        qInfo() << "Loading media quotas...";
+        setupQuotaLedger();
+
+        qInfo() << "Starting media worker...";
+        setupIntroPreviewWorker();
+
+        qInfo() << "Starting account worker...";
+        setupAccountWorker();
         
         qInfo() << "Setting up HTTP server...";
         setupHttpServer();
@@ -83,11 +256,46 @@ server::server(QWidget *parent)
             return;
         }
         
+        qInfo() << "Loading scoring rules...";
+        QString rulesError;
+        if (!loadScoringRules(&rulesError)) {
+            qCWarning(serverCategory) << "Scoring rules not loaded, using five points per second:" << rulesError;
+        }
+
+        qInfo() << "Finalizing daily aggregates...";
+        rollupPool.setMaxThreadCount(1);
+        rollupDay = Clock::instance().today();
+        scheduleRollupCatchUp(rollupDay);
+
         qInfo() << "Setting up timers...";
         QTimer *clockTimer = new QTimer(this);
         connect(clockTimer, &QTimer::timeout, this, &server::updateClock);
         clockTimer->start(1000);
         
+        // Stall threshold in ms from server.ini, lag is measured continuously
+        QSettings settings(appDir.filePath("server.ini"), QSettings::IniFormat);
+        watchdog = new EventLoopWatchdog(settings.value("watchdog/thresholdMs", 200).toInt(), this);
+        watchdog->start();
+
+        // Cost of checking a password, and how long a login stays valid for reconnects
+        accountStore.setHashIterations(settings.value("auth/pbkdf2Iterations", PasswordHash::defaultIterations).toInt());
+        sessionTokens.setLifetime(settings.value("auth/sessionHours", 12).toLongLong() * 3600);
+
+        // Limits and load shedding for TCP commands, see CommandScheduler
+        CommandScheduler::Config schedulerConfig;
+        schedulerConfig.ipRate = settings.value("admission/ipRate", schedulerConfig.ipRate).toDouble();
+        schedulerConfig.ipBurst = settings.value("admission/ipBurst", schedulerConfig.ipBurst).toDouble();
+        schedulerConfig.userRate = settings.value("admission/userRate", schedulerConfig.userRate).toDouble();
+        schedulerConfig.userBurst = settings.value("admission/userBurst", schedulerConfig.userBurst).toDouble();
+        schedulerConfig.stateRate = settings.value("admission/stateRate", schedulerConfig.stateRate).toDouble();
+        schedulerConfig.stateBurst = settings.value("admission/stateBurst", schedulerConfig.stateBurst).toDouble();
+        schedulerConfig.queryShedDepth = settings.value("admission/queryShedDepth", schedulerConfig.queryShedDepth).toInt();
+        schedulerConfig.retryAfterMs = settings.value("admission/retryAfterMs", schedulerConfig.retryAfterMs).toInt();
+        schedulerConfig.sliceMs = settings.value("admission/sliceMs", schedulerConfig.sliceMs).toInt();
+        commandScheduler = new CommandScheduler(schedulerConfig, this);
+        connect(commandScheduler, &CommandScheduler::dispatch, this, &server::handleClientData);
+        connect(commandScheduler, &CommandScheduler::reject, this, &server::sendRetryAfter);
+
         QTimer *timesheetTimer = new QTimer(this);
         connect(timesheetTimer, &QTimer::timeout, this, &server::showTimesheet);
         timesheetTimer->start(1000);
@@ -96,6 +304,8 @@ server::server(QWidget *parent)
         connect(ui->btnCreate, &QPushButton::clicked, this, &server::on_btnCreate_clicked);
         connect(ui->btnDrop, &QPushButton::clicked, this, &server::on_btnDrop_clicked);
         connect(ui->btnChange, &QPushButton::clicked, this, &server::on_btnChange_clicked);
+        connect(ui->btnImport, &QPushButton::clicked, this, &server::importAccounts);
+        connect(ui->btnExport, &QPushButton::clicked, this, &server::exportAccounts);
         
         qInfo() << "Server initialization completed successfully";
         
@@ -112,6 +322,31 @@ server::server(QWidget *parent)
 
 server::~server()
 {
+    Tracer::stop();
+    TrafficCapture::stop();
+    if (watchdog) {
+        watchdog->stop();
+    }
+    // Stop HTTP handling first, its routes call back into this object
+    if (httpThread) {
+        httpThread->quit();
+        httpThread->wait();
+    } else {
+        delete httpServer;
+    }
+    uploadPool.waitForDone();
+    mediaPool.waitForDone();
+    rollupPool.waitForDone();
+    if (introThread) {
+        introThread->quit();
+        introThread->wait();
+    }
+    // Lets a queued account job finish its write before the store goes away
+    if (accountThread) {
+        accountThread->quit();
+        accountThread->wait();
+    }
+    delete requestLog;
     delete ui;
     delete tcpServer;
 }
@@ -120,16 +355,219 @@ void server::setupHttpServer() {
     qInfo() << "Setting up HTTP server...";
     
     // Basic health check route with root path fallback
-    httpServer->route("/", [] {
-        return QHttpServerResponse(QString("Server is running").toUtf8(), "text/plain");
+    httpServer->route("/", [this](const QHttpServerRequest &request) {
+        RequestScope requestScope(requestLog, "http", "GET /");
+        describeHttpRequest(requestScope.record(), request);
+        QHttpServerResponse response = cachedResponse(request, QString("Server is running").toUtf8(), "text/plain");
+        recordHttpResult(response.statusCode(), response.data().size());
+        return response;
     });
     
-    httpServer->route("/health", [] {
+    httpServer->route("/health", [this](const QHttpServerRequest &request) {
+        RequestScope requestScope(requestLog, "http", "GET /health");
+        describeHttpRequest(requestScope.record(), request);
+        recordHttpResult(QHttpServerResponder::StatusCode::Ok, 2);
         return QHttpServerResponse(QString("OK").toUtf8(), "text/plain");
     });
-    
+
+    // Prometheus text exposition of Metrics, rendered from atomics without locking
+    httpServer->route("/metrics", QHttpServerRequest::Method::Get, [this](const QHttpServerRequest &request) {
+        RequestScope requestScope(requestLog, "http", "GET /metrics");
+        describeHttpRequest(requestScope.record(), request);
+        QByteArray body = Metrics::instance().render();
+        recordHttpResult(QHttpServerResponder::StatusCode::Ok, body.size());
+        return QHttpServerResponse("text/plain; version=0.0.4", body);
+    });
+
+    // Media streaming routes, served in chunks with byte-range support
+    httpServer->route("/intro/<arg>", QHttpServerRequest::Method::Get,
+                      [this](const QString &username, const QHttpServerRequest &request, QHttpServerResponder &&responder) {
+        RequestScope requestScope(requestLog, "http", "GET /intro/<user>");
+        describeHttpRequest(requestScope.record(), request, username);
+        if (!isValidMediaName(username)) {
+            recordHttpResult(QHttpServerResponder::StatusCode::BadRequest);
+            responder.write(QHttpServerResponder::StatusCode::BadRequest);
+            return;
+        }
+        QString videoPath = QCoreApplication::applicationDirPath() + "/intro/" + username + ".mp4";
+        serveMediaFile(videoPath, "video/mp4", request, std::move(responder));
+    });
+
+    httpServer->route("/intro/<arg>/poster", QHttpServerRequest::Method::Get,
+                      [this](const QString &username, const QHttpServerRequest &request, QHttpServerResponder &&responder) {
+        RequestScope requestScope(requestLog, "http", "GET /intro/<user>/poster");
+        describeHttpRequest(requestScope.record(), request, username);
+        if (!isValidMediaName(username)) {
+            recordHttpResult(QHttpServerResponder::StatusCode::BadRequest);
+            responder.write(QHttpServerResponder::StatusCode::BadRequest);
+            return;
+        }
+        QString introDir = QCoreApplication::applicationDirPath() + "/intro";
+        serveMediaFile(IntroPreviewWorker::posterPath(introDir, username), "image/jpeg", request, std::move(responder));
+    });
+
+    httpServer->route("/intro/<arg>/preview", QHttpServerRequest::Method::Get,
+                      [this](const QString &username, const QHttpServerRequest &request, QHttpServerResponder &&responder) {
+        RequestScope requestScope(requestLog, "http", "GET /intro/<user>/preview");
+        describeHttpRequest(requestScope.record(), request, username);
+        if (!isValidMediaName(username)) {
+            recordHttpResult(QHttpServerResponder::StatusCode::BadRequest);
+            responder.write(QHttpServerResponder::StatusCode::BadRequest);
+            return;
+        }
+        QString introDir = QCoreApplication::applicationDirPath() + "/intro";
+        serveMediaFile(IntroPreviewWorker::previewPath(introDir, username), "video/mp4", request, std::move(responder));
+    });
+
+    httpServer->route("/avatar/<arg>", QHttpServerRequest::Method::Get,
+                      [this](const QString &username, const QHttpServerRequest &request, QHttpServerResponder &&responder) {
+        RequestScope requestScope(requestLog, "http", "GET /avatar/<user>");
+        describeHttpRequest(requestScope.record(), request, username);
+        if (!isValidMediaName(username)) {
+            recordHttpResult(QHttpServerResponder::StatusCode::BadRequest);
+            responder.write(QHttpServerResponder::StatusCode::BadRequest);
+            return;
+        }
+        int size = request.query().queryItemValue("size").toInt();
+        serveMediaFile(avatarPathForSize(username, size), "image/jpeg", request, std::move(responder));
+    });
+
+    // Upload routes used by statusForm. Decoding and file writes run on the
+    // upload pool and the response completes asynchronously, so the HTTP
+    // thread keeps serving other requests meanwhile.
+    httpServer->route("/avatar", QHttpServerRequest::Method::Post, [this](const QHttpServerRequest &request) {
+        if (exceedsUploadLimit(request)) {
+            RequestScope requestScope(requestLog, "http", "POST /avatar");
+            describeHttpRequest(requestScope.record(), request);
+            recordHttpResult(QHttpServerResponder::StatusCode::PayloadTooLarge);
+            return readyResponse(QHttpServerResponse::StatusCode::PayloadTooLarge);
+        }
+        return QtConcurrent::run(&uploadPool, [this, body = request.body(),
+                                               peer = request.remoteAddress().toString()]() {
+            RequestScope requestScope(requestLog, "http", "POST /avatar");
+            requestScope.record().peer = peer;
+            requestScope.record().bytesIn = body.size();
+            const QHttpServerResponse::StatusCode status = handleImageUpload(body);
+            recordHttpResult(status);
+            return QHttpServerResponse(status);
+        });
+    });
+
+    httpServer->route("/intro", QHttpServerRequest::Method::Post, [this](const QHttpServerRequest &request) {
+        if (exceedsUploadLimit(request)) {
+            RequestScope requestScope(requestLog, "http", "POST /intro");
+            describeHttpRequest(requestScope.record(), request);
+            recordHttpResult(QHttpServerResponder::StatusCode::PayloadTooLarge);
+            return readyResponse(QHttpServerResponse::StatusCode::PayloadTooLarge);
+        }
+        return QtConcurrent::run(&uploadPool, [this, body = request.body(),
+                                               peer = request.remoteAddress().toString()]() {
+            RequestScope requestScope(requestLog, "http", "POST /intro");
+            requestScope.record().peer = peer;
+            requestScope.record().bytesIn = body.size();
+            const QHttpServerResponse::StatusCode status = handleVideoUpload(body);
+            recordHttpResult(status);
+            return QHttpServerResponse(status);
+        });
+    });
+
+    // Runtime switch for trace-event output, local requests only
+    httpServer->route("/trace/<arg>", QHttpServerRequest::Method::Post,
+                      [this](const QString &action, const QHttpServerRequest &request) {
+        if (!request.remoteAddress().isLoopback()) {
+            return QHttpServerResponse(QHttpServerResponse::StatusCode::Forbidden);
+        }
+        if (action == "start") {
+            const QString path = Tracer::start(QCoreApplication::applicationDirPath() + "/logs");
+            qInfo() << "Tracing" << (path.isEmpty() ? QString("already running") : "to " + path);
+            return QHttpServerResponse(QHttpServerResponse::StatusCode::Ok);
+        }
+        if (action == "stop") {
+            Tracer::stop();
+            qInfo() << "Tracing stopped";
+            return QHttpServerResponse(QHttpServerResponse::StatusCode::Ok);
+        }
+        return QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound);
+    });
+
+    // Runtime switch for TCP traffic capture (replayed with trackload --replay)
+    httpServer->route("/capture/<arg>", QHttpServerRequest::Method::Post,
+                      [this](const QString &action, const QHttpServerRequest &request) {
+        if (!request.remoteAddress().isLoopback()) {
+            return QHttpServerResponse(QHttpServerResponse::StatusCode::Forbidden);
+        }
+        if (action == "start") {
+            const QString path = TrafficCapture::start(QCoreApplication::applicationDirPath() + "/logs");
+            qInfo() << "Capturing TCP traffic" << (path.isEmpty() ? QString("already running") : "to " + path);
+            return QHttpServerResponse(QHttpServerResponse::StatusCode::Ok);
+        }
+        if (action == "stop") {
+            TrafficCapture::stop();
+            qInfo() << "TCP capture stopped";
+            return QHttpServerResponse(QHttpServerResponse::StatusCode::Ok);
+        }
+        return QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound);
+    });
+
+    // Virtual clock control for simulations (--virtual-clock), local requests only
+    httpServer->route("/clock", QHttpServerRequest::Method::Get, []() {
+        QJsonObject clockObj;
+        clockObj["now"] = Clock::instance().now().toString(Qt::ISODate);
+        clockObj["virtual"] = dynamic_cast<VirtualClock *>(&Clock::instance()) != nullptr;
+        return QHttpServerResponse(clockObj);
+    });
+    httpServer->route("/clock/advance/<arg>", QHttpServerRequest::Method::Post,
+                      [](qint64 seconds, const QHttpServerRequest &request) {
+        auto *virtualClock = dynamic_cast<VirtualClock *>(&Clock::instance());
+        if (!request.remoteAddress().isLoopback() || !virtualClock) {
+            return QHttpServerResponse(QHttpServerResponse::StatusCode::Forbidden);
+        }
+        virtualClock->advance(seconds * 1000);
+        qInfo() << "Virtual clock advanced by" << seconds << "s to" << virtualClock->now().toString(Qt::ISODate);
+        return QHttpServerResponse(QHttpServerResponse::StatusCode::Ok);
+    });
+
+    // Recompiles scoring.json, local requests only. Today's points follow on the
+    // next timesheet tick; closed days are finalized again in the background.
+    httpServer->route("/scoring/reload", QHttpServerRequest::Method::Post, [this](const QHttpServerRequest &request) {
+        RequestScope requestScope(requestLog, "http", "POST /scoring/reload");
+        describeHttpRequest(requestScope.record(), request);
+        if (!request.remoteAddress().isLoopback()) {
+            recordHttpResult(QHttpServerResponder::StatusCode::Forbidden);
+            return QHttpServerResponse(QHttpServerResponse::StatusCode::Forbidden);
+        }
+        QString error;
+        if (!loadScoringRules(&error)) {
+            qCWarning(serverCategory) << "Scoring rules not reloaded:" << error;
+            QHttpServerResponse response(error.toUtf8(), "text/plain", QHttpServerResponse::StatusCode::BadRequest);
+            recordHttpResult(response.statusCode(), response.data().size());
+            return response;
+        }
+        qInfo() << "Scoring rules reloaded," << currentScoringRules()->fingerprint().toHex();
+        scheduleRollupCatchUp(Clock::instance().today());
+        recordHttpResult(QHttpServerResponder::StatusCode::Ok);
+        return QHttpServerResponse(QHttpServerResponse::StatusCode::Ok);
+    });
+
+    // Week, month and date-range totals from the daily aggregates, local requests only:
+    //   /reports/week?date=2025-03-12   /reports/month?date=2025-03-01
+    //   /reports/range?from=2025-03-01&to=2025-03-31   (&format=csv for a spreadsheet)
+    httpServer->route("/reports/<arg>", QHttpServerRequest::Method::Get,
+                      [this](const QString &period, const QHttpServerRequest &request) {
+        RequestScope requestScope(requestLog, "http", "GET /reports/" + period);
+        describeHttpRequest(requestScope.record(), request);
+        QHttpServerResponse response = request.remoteAddress().isLoopback()
+                                           ? rollupReport(period, request)
+                                           : QHttpServerResponse(QHttpServerResponse::StatusCode::Forbidden);
+        recordHttpResult(response.statusCode(), response.data().size());
+        return response;
+    });
+
     // Add catch-all route for debugging
-    httpServer->route("*", [](const QHttpServerRequest &request) {
+    httpServer->route("*", [this](const QHttpServerRequest &request) {
+        RequestScope requestScope(requestLog, "http", "* " + request.url().path());
+        describeHttpRequest(requestScope.record(), request);
+        recordHttpResult(QHttpServerResponder::StatusCode::NotFound);
         qDebug() << "Received request for:" << request.url().path()
                  << "from:" << request.remoteAddress();
         return QHttpServerResponse(QString("Path: %1").arg(request.url().path()).toUtf8(), 
@@ -137,8 +575,19 @@ void server::setupHttpServer() {
                                  QHttpServerResponse::StatusCode::NotFound);
     });
     
-    // Start server
-    const auto port = httpServer->listen(QHostAddress::AnyIPv4, 8080);
+    // Run the HTTP server on its own thread so uploads and media streaming
+    // never compete with the admin UI and TCP command handling
+    httpThread = new QThread(this);
+    httpThread->setObjectName("http");
+    httpServer->moveToThread(httpThread);
+    connect(httpThread, &QThread::finished, httpServer, &QObject::deleteLater);
+    httpThread->start();
+
+    // listen() creates the QTcpServer as a child, so it has to run on the HTTP thread
+    quint16 port = 0;
+    QMetaObject::invokeMethod(httpServer, [this, &port]() {
+        port = httpServer->listen(QHostAddress::AnyIPv4, 8080);
+    }, Qt::BlockingQueuedConnection);
     if (!port) {
         qCritical() << "Failed to start HTTP server on port 8080";
         emit serverError("Failed to start HTTP server");
@@ -182,8 +631,193 @@ void server::setupHttpServer() {
     });
 }
 
-void server::handleImageUpload(const QHttpServerRequest &request) {
-    QByteArray rawData = request.body();
+void server::serveMediaFile(const QString &filePath, const QByteArray &mimeType,
+                            const QHttpServerRequest &request, QHttpServerResponder &&responder) {
+    TraceSpan span("serveMediaFile", "http");
+    QFileInfo fileInfo(filePath);
+    if (!fileInfo.isFile()) {
+        qCDebug(serverCategory) << "serveMediaFile: File not found:" << filePath;
+        recordHttpResult(QHttpServerResponder::StatusCode::NotFound);
+        responder.write(QHttpServerResponder::StatusCode::NotFound);
+        return;
+    }
+
+    const QByteArray etag = mediaETag(fileInfo);
+    if (!etag.isEmpty() && etagMatches(request.value("If-None-Match"), etag)) {
+        recordHttpResult(QHttpServerResponder::StatusCode::NotModified);
+        responder.write({{"ETag", etag}}, QHttpServerResponder::StatusCode::NotModified);
+        return;
+    }
+
+    const qint64 totalSize = fileInfo.size();
+    const QByteArray totalSizeStr = QByteArray::number(totalSize);
+    qint64 first = 0;
+    qint64 last = totalSize - 1;
+
+    ByteRangeResult rangeResult = parseByteRange(request.value("Range"), totalSize, &first, &last);
+    if (rangeResult == ByteRangeResult::Unsatisfiable) {
+        recordHttpResult(QHttpServerResponder::StatusCode::RequestRangeNotSatisfiable);
+        responder.write({{"Content-Range", "bytes */" + totalSizeStr},
+                         {"Accept-Ranges", "bytes"}},
+                        QHttpServerResponder::StatusCode::RequestRangeNotSatisfiable);
+        return;
+    }
+
+    // The responder takes ownership of the device and deletes it when the transfer ends
+    FileRangeDevice *device = new FileRangeDevice(filePath, first, last - first + 1);
+    if (!device->open(QIODevice::ReadOnly)) {
+        qCWarning(serverCategory) << "serveMediaFile: Couldn't open the file:" << device->errorString();
+        delete device;
+        recordHttpResult(QHttpServerResponder::StatusCode::InternalServerError);
+        responder.write(QHttpServerResponder::StatusCode::InternalServerError);
+        return;
+    }
+
+    recordHttpResult(rangeResult == ByteRangeResult::Partial ? QHttpServerResponder::StatusCode::PartialContent
+                                                             : QHttpServerResponder::StatusCode::Ok,
+                     last - first + 1);
+    if (rangeResult == ByteRangeResult::Partial) {
+        const QByteArray contentRange = "bytes " + QByteArray::number(first) + "-"
+                                        + QByteArray::number(last) + "/" + totalSizeStr;
+        responder.write(device,
+                        {{"Content-Type", mimeType},
+                         {"Accept-Ranges", "bytes"},
+                         {"Content-Range", contentRange},
+                         {"ETag", etag}},
+                        QHttpServerResponder::StatusCode::PartialContent);
+    } else {
+        responder.write(device,
+                        {{"Content-Type", mimeType},
+                         {"Accept-Ranges", "bytes"},
+                         {"ETag", etag}},
+                        QHttpServerResponder::StatusCode::Ok);
+    }
+}
+
+// Strong ETag from the SHA-1 of the file content. The hash is cached per path
+// and only recomputed when the file size or modification time changes.
+QByteArray server::mediaETag(const QFileInfo &fileInfo) {
+    const QString filePath = fileInfo.absoluteFilePath();
+    const qint64 size = fileInfo.size();
+    const QDateTime modified = fileInfo.lastModified();
+
+    {
+        QMutexLocker locker(&mediaETagMutex);
+        auto it = mediaETags.constFind(filePath);
+        if (it != mediaETags.constEnd() && it->size == size && it->modified == modified) {
+            return it->etag;
+        }
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(serverCategory) << "mediaETag: Couldn't open the file:" << file.errorString();
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file)) {
+        qCWarning(serverCategory) << "mediaETag: Couldn't read the file:" << filePath;
+        return QByteArray();
+    }
+
+    MediaETag entry;
+    entry.size = size;
+    entry.modified = modified;
+    entry.etag = '"' + hash.result().toHex() + '"';
+
+    QMutexLocker locker(&mediaETagMutex);
+    mediaETags.insert(filePath, entry);
+    return entry.etag;
+}
+
+// Builds a response for an in-memory body with a strong ETag, answering
+// 304 Not Modified when the client already holds the same content
+QHttpServerResponse server::cachedResponse(const QHttpServerRequest &request, const QByteArray &body,
+                                           const QByteArray &mimeType) {
+    const QByteArray etag = '"' + QCryptographicHash::hash(body, QCryptographicHash::Sha1).toHex() + '"';
+    if (etagMatches(request.value("If-None-Match"), etag)) {
+        QHttpServerResponse response(QHttpServerResponse::StatusCode::NotModified);
+        response.setHeader("ETag", etag);
+        return response;
+    }
+
+    QHttpServerResponse response(mimeType, body);
+    response.setHeader("ETag", etag);
+    return response;
+}
+
+// Runs on the HTTP thread; only reads aggregate files, which are replaced atomically
+QHttpServerResponse server::rollupReport(const QString &period, const QHttpServerRequest &request) {
+    TraceSpan span("rollupReport", "http");
+    const QUrlQuery query(request.url());
+    const QDate date = query.hasQueryItem("date")
+                           ? QDate::fromString(query.queryItemValue("date"), Qt::ISODate)
+                           : Clock::instance().today();
+
+    QPair<QDate, QDate> bounds;
+    if (period == "week") {
+        bounds = RollupStore::weekOf(date);
+    } else if (period == "month") {
+        bounds = RollupStore::monthOf(date);
+    } else if (period == "range") {
+        bounds = {QDate::fromString(query.queryItemValue("from"), Qt::ISODate),
+                  QDate::fromString(query.queryItemValue("to"), Qt::ISODate)};
+    } else {
+        return QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound);
+    }
+    // A year at most, so one request can't walk the calendar for ever
+    if (!bounds.first.isValid() || !bounds.second.isValid() || bounds.first > bounds.second
+        || bounds.first.daysTo(bounds.second) > 366) {
+        return QHttpServerResponse(QHttpServerResponse::StatusCode::BadRequest);
+    }
+
+    QList<QDate> missing;
+    RollupStore::UserTotals totals;
+    {
+        StorageTimer storageTimer;
+        totals = rollupStore.range(bounds.first, bounds.second, currentScoringRules()->fingerprint(), &missing);
+    }
+    QStringList usernames = totals.keys();
+    usernames.sort();
+
+    if (query.queryItemValue("format") == "csv") {
+        QByteArray body = "username,secondsOnline,sessions,points\n";
+        for (const QString &username : std::as_const(usernames)) {
+            const RollupStore::Totals &userTotals = totals[username];
+            body += AccountTransfer::csvCell(username).toUtf8() + ',' + QByteArray::number(userTotals.secondsOnline) + ','
+                    + QByteArray::number(userTotals.sessions) + ',' + QByteArray::number(userTotals.points) + '\n';
+        }
+        return cachedResponse(request, body, "text/csv");
+    }
+
+    QJsonArray users;
+    for (const QString &username : std::as_const(usernames)) {
+        const RollupStore::Totals &userTotals = totals[username];
+        QJsonObject userObj;
+        userObj["username"] = username;
+        userObj["secondsOnline"] = userTotals.secondsOnline;
+        userObj["sessions"] = userTotals.sessions;
+        userObj["points"] = userTotals.points;
+        users.append(userObj);
+    }
+    // Today, days without any status events and days not yet scored under the
+    // current rules have no aggregate
+    QJsonArray missingDays;
+    for (const QDate &day : std::as_const(missing)) {
+        missingDays.append(day.toString(Qt::ISODate));
+    }
+    QJsonObject reportObj;
+    reportObj["from"] = bounds.first.toString(Qt::ISODate);
+    reportObj["to"] = bounds.second.toString(Qt::ISODate);
+    reportObj["missingDays"] = missingDays;
+    reportObj["users"] = users;
+    return cachedResponse(request, QJsonDocument(reportObj).toJson(QJsonDocument::Compact), "application/json");
+}
+
+// Runs on the upload pool
+QHttpServerResponse::StatusCode server::handleImageUpload(const QByteArray &rawData) {
+    TraceSpan span("handleImageUpload", "http");
     
     // Create directories if they don't exist
     QString baseDir = QCoreApplication::applicationDirPath();
@@ -192,7 +826,7 @@ void server::handleImageUpload(const QHttpServerRequest &request) {
     if (!dir.exists(avatarDir)) {
         if (!dir.mkpath(avatarDir)) {
             qCWarning(serverCategory) << "handleImageUpload: Couldn't create avatar directory:" << avatarDir;
-            return;
+            return QHttpServerResponse::StatusCode::InternalServerError;
         }
     }
     
@@ -202,7 +836,7 @@ void server::handleImageUpload(const QHttpServerRequest &request) {
     
     if (startIndex <= 4 || endIndex <= startIndex) {
         qCWarning(serverCategory) << "handleImageUpload: Invalid data format";
-        return;
+        return QHttpServerResponse::StatusCode::BadRequest;
     }
     
     QString base64Data = rawData.mid(startIndex, endIndex - startIndex);
@@ -232,20 +866,46 @@ void server::handleImageUpload(const QHttpServerRequest &request) {
         }
     }
 
-    // Create a file to save the image
+    if (!isValidMediaName(username)) {
+        qCWarning(serverCategory) << "handleImageUpload: Invalid username:" << username;
+        return QHttpServerResponse::StatusCode::BadRequest;
+    }
+
+    if (RequestRecord *record = RequestScope::current()) {
+        record->user = username;
+    }
+
+    const QuotaLedger::Reservation reservation = quotaLedger->reserve(username, "avatar", imageData.size());
+    if (!reservation.valid) {
+        qCWarning(serverCategory) << "handleImageUpload: Quota exceeded for" << username;
+        Metrics::instance().uploadsRejected.fetch_add(1, std::memory_order_relaxed);
+        return QHttpServerResponse::StatusCode::PayloadTooLarge;
+    }
+
+    // Create a file to save the image. QSaveFile swaps it in atomically, so
+    // concurrent downloads and uploads never see a half-written avatar.
     QString imagePath = avatarDir + "/" + username + ".jpg"; // Path and filename to save the image
-    QFile file(imagePath);
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(imageData);
-        file.close();
+    StorageTimer storageTimer;
+    QSaveFile file(imagePath);
+    if (file.open(QIODevice::WriteOnly) && file.write(imageData) == imageData.size() && file.commit()) {
+        storageTimer.stop();
         qDebug() << "Image saved successfully to" << imagePath;
     } else {
         qDebug() << "Failed to save image to" << imagePath;
+        quotaLedger->release(reservation);
+        return QHttpServerResponse::StatusCode::InternalServerError;
     }
+
+    quotaLedger->commit(reservation);
+    Metrics::instance().uploadBytes.fetch_add(imageData.size(), std::memory_order_relaxed);
+    mediaETag(QFileInfo(imagePath)); // Hash now rather than on the first download
+    scheduleAvatarThumbnails(username);
+    return QHttpServerResponse::StatusCode::Ok;
 }
 
-void server::handleVideoUpload(const QHttpServerRequest &request) {
-    QByteArray rawVideo = request.body();
+// Runs on the upload pool
+QHttpServerResponse::StatusCode server::handleVideoUpload(const QByteArray &rawVideo) {
+    TraceSpan span("handleVideoUpload", "http");
     
     // Create directories if they don't exist
     QString baseDir = QCoreApplication::applicationDirPath();
@@ -254,7 +914,7 @@ void server::handleVideoUpload(const QHttpServerRequest &request) {
     if (!dir.exists(introDir)) {
         if (!dir.mkpath(introDir)) {
             qCWarning(serverCategory) << "handleVideoUpload: Couldn't create intro directory:" << introDir;
-            return;
+            return QHttpServerResponse::StatusCode::InternalServerError;
         }
     }
     
@@ -264,7 +924,7 @@ void server::handleVideoUpload(const QHttpServerRequest &request) {
     
     if (startIndex <= 4 || endIndex <= startIndex) {
         qCWarning(serverCategory) << "handleVideoUpload: Invalid data format";
-        return;
+        return QHttpServerResponse::StatusCode::BadRequest;
     }
     
     QByteArray videoData = rawVideo.mid(startIndex, endIndex - startIndex);
@@ -290,16 +950,281 @@ void server::handleVideoUpload(const QHttpServerRequest &request) {
         }
     }
     
+    if (!isValidMediaName(username)) {
+        qCWarning(serverCategory) << "handleVideoUpload: Invalid username:" << username;
+        return QHttpServerResponse::StatusCode::BadRequest;
+    }
+
+    if (RequestRecord *record = RequestScope::current()) {
+        record->user = username;
+    }
+
+    const QuotaLedger::Reservation reservation = quotaLedger->reserve(username, "intro", videoData.size());
+    if (!reservation.valid) {
+        qCWarning(serverCategory) << "handleVideoUpload: Quota exceeded for" << username;
+        Metrics::instance().uploadsRejected.fetch_add(1, std::memory_order_relaxed);
+        return QHttpServerResponse::StatusCode::PayloadTooLarge;
+    }
+
     // Create a file to save the video
     QString videoPath = introDir + "/" + username + ".mp4"; // Path and filename to save the video
-    QFile file(videoPath);
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(videoData);
-        file.close();
+    StorageTimer storageTimer;
+    QSaveFile file(videoPath);
+    if (file.open(QIODevice::WriteOnly) && file.write(videoData) == videoData.size() && file.commit()) {
+        storageTimer.stop();
         qDebug() << "Video saved successfully to" << videoPath;
     } else {
         qDebug() << "Failed to save video to" << videoPath;
+        quotaLedger->release(reservation);
+        return QHttpServerResponse::StatusCode::InternalServerError;
+    }
+
+    quotaLedger->commit(reservation);
+    Metrics::instance().uploadBytes.fetch_add(videoData.size(), std::memory_order_relaxed);
+    mediaETag(QFileInfo(videoPath)); // Hash now rather than on the first download
+
+    QMetaObject::invokeMethod(introWorker, [worker = introWorker, username, videoPath]() {
+        worker->enqueue(username, videoPath);
+    }, Qt::QueuedConnection);
+    return QHttpServerResponse::StatusCode::Ok;
+}
+
+// Loads the quota limits from server.ini (in MB, 0 disables a limit) and the
+// persisted usage ledger. Usage is shown in the status bar and kept current
+// from the ledger, without ever walking the media directories.
+void server::setupQuotaLedger() {
+    QSettings settings(QCoreApplication::applicationDirPath() + "/server.ini", QSettings::IniFormat);
+    const qint64 mb = 1024 * 1024;
+    const qint64 userLimit = settings.value("quota/userLimitMB", 200).toLongLong() * mb;
+    const qint64 totalLimit = settings.value("quota/totalLimitMB", 10240).toLongLong() * mb;
+    const qint64 maxUpload = settings.value("quota/maxUploadMB", 100).toLongLong() * mb;
+
+    quotaLedger = new QuotaLedger(QCoreApplication::applicationDirPath(), this);
+    quotaLedger->setLimits(userLimit, totalLimit, maxUpload);
+
+    lblMediaUsage = new QLabel(this);
+    statusBar()->addPermanentWidget(lblMediaUsage);
+    // Uploads record their usage on pool threads, the label is updated on the GUI thread
+    connect(quotaLedger, &QuotaLedger::usageChanged, this, &server::updateMediaUsage, Qt::QueuedConnection);
+
+    quotaLedger->load();
+    updateMediaUsage(quotaLedger->totalUsage(), quotaLedger->totalLimit());
+}
+
+void server::updateMediaUsage(qint64 totalBytes, qint64 totalLimit) {
+    const double mb = 1024.0 * 1024.0;
+    QString text = QString("Media usage: %1 MB").arg(totalBytes / mb, 0, 'f', 1);
+    if (totalLimit > 0) {
+        text += QString(" / %1 MB").arg(totalLimit / mb, 0, 'f', 0);
+    }
+    lblMediaUsage->setText(text);
+}
+
+// QHttpServer has already buffered the body by the time a route runs, but the
+// declared Content-Length still lets an oversized upload be refused before
+// any decoding or disk write is queued
+bool server::exceedsUploadLimit(const QHttpServerRequest &request) const {
+    const qint64 maxUpload = quotaLedger->maxUpload();
+    if (maxUpload <= 0) {
+        return false;
+    }
+    bool ok = false;
+    const qint64 contentLength = request.value("Content-Length").toLongLong(&ok);
+    if (ok && contentLength > maxUpload) {
+        Metrics::instance().uploadsRejected.fetch_add(1, std::memory_order_relaxed);
+        qCWarning(serverCategory) << "exceedsUploadLimit: Rejected upload of" << contentLength << "bytes from"
+                                  << request.remoteAddress();
+        return true;
+    }
+    return false;
+}
+
+// Poster and preview extraction needs QMediaPlayer, which in turn needs an
+// event loop, so it runs on a dedicated thread instead of the media pool.
+void server::setupIntroPreviewWorker() {
+    introThread = new QThread(this);
+    introWorker = new IntroPreviewWorker();
+    introWorker->moveToThread(introThread);
+    connect(introThread, &QThread::finished, introWorker, &QObject::deleteLater);
+    connect(introWorker, &IntroPreviewWorker::previewFailed, this, [](const QString &username, const QString &error) {
+        qCWarning(serverCategory) << "Intro preview failed for" << username << ":" << error;
+    });
+    introThread->start();
+
+    // Catch up on intros uploaded before previews existed
+    QString introDir = QCoreApplication::applicationDirPath() + "/intro";
+    const QFileInfoList videos = QDir(introDir).entryInfoList({"*.mp4"}, QDir::Files);
+    for (const QFileInfo &video : videos) {
+        const QString username = video.completeBaseName();
+        if (isValidMediaName(username) && !QFile::exists(IntroPreviewWorker::posterPath(introDir, username))) {
+            QMetaObject::invokeMethod(introWorker, [worker = introWorker, username, path = video.absoluteFilePath()]() {
+                worker->enqueue(username, path);
+            }, Qt::QueuedConnection);
+        }
+    }
+}
+
+void server::setupAccountWorker() {
+    accountThread = new QThread(this);
+    accountWorker = new AccountWorker(&accountStore);
+    accountWorker->moveToThread(accountThread);
+    connect(accountThread, &QThread::finished, accountWorker, &QObject::deleteLater);
+
+    connect(accountWorker, &AccountWorker::accountCreated, this, [this](const QString &username, bool ok, const QString &error) {
+        reportAccountJob("Create", username, ok, error);
+    });
+    connect(accountWorker, &AccountWorker::accountDropped, this, [this](const QString &username, bool ok, const QString &error) {
+        reportAccountJob("Drop", username, ok, error);
+    });
+    connect(accountWorker, &AccountWorker::profileChanged, this,
+            [this](const QString &username, const QJsonObject &profile, bool ok, const QString &error) {
+        if (ok) {
+            rosterIndex.setFullName(username, profile.value("Fullname").toString());
+        }
+        reportAccountJob("Change", username, ok, error);
+    });
+    connect(accountWorker, &AccountWorker::accountRegistered, this,
+            [this](quint64 ticket, const QString &username, const QString &response) {
+        if (response == "newUser") {
+            rosterIndexStale = true;
+        } else {
+            qCWarning(serverCategory) << "handleClientRegister:" << username << response;
+        }
+        QPointer<QTcpSocket> socket = pendingRegistrations.take(ticket);
+        if (socket && socket->isOpen()) {
+            QJsonObject responseObj;
+            responseObj["response"] = response;
+            sendResponse(socket, responseObj);
+        }
+    });
+    connect(accountWorker, &AccountWorker::loginVerified, this,
+            [this](quint64 ticket, const QString &username, bool ok) {
+        finishLogin(pendingLogins.take(ticket), username, ok);
+    });
+    connect(accountWorker, &AccountWorker::accountsImported, this,
+            [this](const QString &filePath, bool ok, int added, int updated, int dropped, const QStringList &errors) {
+        for (const QString &error : errors.mid(0, 20)) {
+            qCWarning(serverCategory) << "importAccounts:" << filePath << error;
+        }
+        if (!ok) {
+            statusBar()->showMessage(QString("Import of %1 failed, nothing was changed").arg(filePath), 10000);
+            return;
+        }
+        rosterIndexStale = true;
+        statusBar()->showMessage(QString("Imported %1: %2 added, %3 updated, %4 dropped, %5 skipped")
+                                     .arg(QFileInfo(filePath).fileName()).arg(added).arg(updated).arg(dropped)
+                                     .arg(errors.size()), 10000);
+    });
+    connect(accountWorker, &AccountWorker::accountsExported, this,
+            [this](const QString &filePath, bool ok, int count, const QString &error) {
+        if (!ok) {
+            qCWarning(serverCategory) << "exportAccounts:" << filePath << error;
+            statusBar()->showMessage(QString("Export to %1 failed: %2").arg(filePath, error), 10000);
+            return;
+        }
+        statusBar()->showMessage(QString("Exported %1 accounts to %2").arg(count).arg(QFileInfo(filePath).fileName()), 5000);
+    });
+    accountThread->start();
+
+    // Plaintext passwords from older servers are hashed once, in the background,
+    // before the first login storm rather than one account.json rewrite per login
+    accountWorker->scheduleUpgradePasswords();
+}
+
+// Outcome of an admin account job, in the status bar instead of a modal box
+void server::reportAccountJob(const QString &action, const QString &username, bool ok, const QString &error) {
+    if (ok) {
+        if (action != "Change") {
+            rosterIndexStale = true;
+        }
+        statusBar()->showMessage(QString("%1 %2: done").arg(action, username), 5000);
+    } else {
+        qCWarning(serverCategory) << "reportAccountJob:" << action << username << error;
+        statusBar()->showMessage(QString("%1 %2: %3").arg(action, username, error), 10000);
+    }
+}
+
+// Queue thumbnail generation for a freshly uploaded avatar on the media pool.
+// The full-resolution capture is decoded once, already scaled down by the
+// JPEG decoder, and every smaller size is derived from that image.
+void server::scheduleAvatarThumbnails(const QString &username) {
+    {
+        QMutexLocker locker(&thumbnailMutex);
+        if (pendingThumbnails.contains(username)) {
+            return;
+        }
+        pendingThumbnails.insert(username);
+    }
+
+    mediaPool.start([this, username]() {
+        const QString avatarDir = QCoreApplication::applicationDirPath() + "/avatar";
+        const QString imagePath = avatarDir + "/" + username + ".jpg";
+
+        QDir dir;
+        if (!dir.exists(avatarDir + "/thumbs") && !dir.mkpath(avatarDir + "/thumbs")) {
+            qCWarning(serverCategory) << "scheduleAvatarThumbnails: Couldn't create thumbs directory";
+        } else {
+            QImageReader reader(imagePath);
+            reader.setAutoTransform(true);
+            const int largest = avatarThumbnailSizes[std::size(avatarThumbnailSizes) - 1];
+            QSize sourceSize = reader.size();
+            if (sourceSize.isValid()) {
+                reader.setScaledSize(sourceSize.scaled(largest, largest, Qt::KeepAspectRatio));
+            }
+
+            QImage image = reader.read();
+            if (image.isNull()) {
+                qCWarning(serverCategory) << "scheduleAvatarThumbnails: Couldn't decode" << imagePath << reader.errorString();
+            } else {
+                bool allSaved = true;
+                for (int size : avatarThumbnailSizes) {
+                    QImage thumbnail = image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+                    QSaveFile thumbFile(avatarThumbnailPath(username, size));
+                    if (!thumbFile.open(QIODevice::WriteOnly) || !thumbnail.save(&thumbFile, "JPG", 85)
+                        || !thumbFile.commit()) {
+                        qCWarning(serverCategory) << "scheduleAvatarThumbnails: Couldn't save thumbnail" << size << "for" << username
+                                                  << thumbFile.errorString();
+                        allSaved = false;
+                    }
+                }
+                if (allSaved) {
+                    qCDebug(serverCategory) << "scheduleAvatarThumbnails: Thumbnails generated for" << username;
+                }
+            }
+        }
+
+        QMutexLocker locker(&thumbnailMutex);
+        pendingThumbnails.remove(username);
+    });
+}
+
+QString server::avatarThumbnailPath(const QString &username, int size) const {
+    return QCoreApplication::applicationDirPath() + "/avatar/thumbs/" + username + "_" + QString::number(size) + ".jpg";
+}
+
+// Picks the smallest generated thumbnail that covers the requested size.
+// Falls back to the original while thumbnails are missing or older than it.
+QString server::avatarPathForSize(const QString &username, int requestedSize) {
+    const QString imagePath = QCoreApplication::applicationDirPath() + "/avatar/" + username + ".jpg";
+    if (requestedSize <= 0) {
+        return imagePath;
     }
+
+    for (int size : avatarThumbnailSizes) {
+        if (size < requestedSize) {
+            continue;
+        }
+        QFileInfo thumbInfo(avatarThumbnailPath(username, size));
+        QFileInfo imageInfo(imagePath);
+        if (thumbInfo.exists() && (!imageInfo.exists() || thumbInfo.lastModified() >= imageInfo.lastModified())) {
+            return thumbInfo.absoluteFilePath();
+        }
+        if (imageInfo.exists()) {
+            scheduleAvatarThumbnails(username);
+        }
+        break;
+    }
+    return imagePath;
 }
 
 void server::onNewConnection()
@@ -310,6 +1235,11 @@ void server::onNewConnection()
             qCWarning(serverCategory) << "onNewConnection: Failed to get next pending connection.";
             continue;
         }
+        const quint64 connectionId = ++nextConnectionId;
+        socket->setProperty("connectionId", connectionId);
+        Metrics::instance().connectionsTotal.fetch_add(1, std::memory_order_relaxed);
+        Metrics::instance().connectionsOpen.fetch_add(1, std::memory_order_relaxed);
+        TrafficCapture::record(connectionId, TrafficCapture::Open, socket->peerAddress().toString().toUtf8());
 
         // Connect the readyRead signal to a lambda function to handle client data
         connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
@@ -318,40 +1248,52 @@ void server::onNewConnection()
                 return; // Wait for more data
             }
 
-            // Directly handle all data as JSON request
-            handleClientData(socket);
+            // Queued by priority; the scheduler calls handleClientData
+            const QByteArray data = socket->readAll();
+            TrafficCapture::record(socket->property("connectionId").toULongLong(), TrafficCapture::Data, data);
+            commandScheduler->submit(socket, data);
         });
 
         // Connect the disconnected signal to delete the socket later
         connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+        connect(socket, &QTcpSocket::disconnected, this, [connectionId]() {
+            TrafficCapture::record(connectionId, TrafficCapture::Close);
+        });
+        connect(socket, &QObject::destroyed, this, []() {
+            Metrics::instance().connectionsOpen.fetch_sub(1, std::memory_order_relaxed);
+        });
     }
 }
 
 
-QJsonObject server::loadJsonFile()
-{
-    QString relativePath = QCoreApplication::applicationDirPath() + "/account/account.json";
-
-    QFile file(relativePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qCWarning(serverCategory) << "loadJsonData: Couldn't open the file:" << file.errorString();
-        return QJsonObject();
+// Writes a compact JSON response and accounts it to the active request
+qint64 server::sendResponse(QTcpSocket *socket, const QJsonObject &response) {
+    QByteArray data;
+    {
+        TraceSpan span("buildResponse", "tcp");
+        data = QJsonDocument(response).toJson(QJsonDocument::Compact);
     }
-
-    QByteArray fileData = file.readAll();
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(fileData, &parseError);
-    if (parseError.error != QJsonParseError::NoError) {
-        qCWarning(serverCategory) << "loadJsonData: JSON parse error:" << parseError.errorString();
-        return QJsonObject();
+    TraceSpan span("socketWrite", "tcp");
+    const qint64 written = socket->write(data);
+    if (RequestRecord *record = RequestScope::current()) {
+        if (written > 0) {
+            record->bytesOut += written;
+        }
+        if (record->result.isEmpty()) {
+            record->result = response.value("response").toString();
+        }
     }
+    return written;
+}
 
-    QJsonObject jsonObj = doc.object();
-
-    return jsonObj;
+QJsonObject server::loadJsonFile()
+{
+    TraceSpan span("loadJsonFile", "storage");
+    StorageTimer storageTimer;
+    return accountStore.accounts();
 }
 
-void server::handleClientData(QTcpSocket* socket) {
+void server::handleClientData(QTcpSocket* socket, const QByteArray &payload, qint64 queuedUs) {
     if (!socket) {
         qCWarning(serverCategory) << "handleClientData: Socket is null.";
         return;
@@ -362,13 +1304,19 @@ void server::handleClientData(QTcpSocket* socket) {
         return;
     }
 
-    // Read and log the raw data from the socket
-    QByteArray data = socket->readAll();
-    qCDebug(serverCategory) << "handleClientData: Received raw data:" << data;
+    StallScope stallScope("handleClientData");
+    TraceSpan requestSpan("handleClientData", "tcp");
+    RequestScope requestScope(requestLog, "tcp", "invalid");
+    RequestRecord &record = requestScope.record();
+    record.connectionId = socket->property("connectionId").toULongLong();
+    record.peer = socket->peerAddress().toString();
+    record.user = socket->property("username").toString();
+    record.queueUs = queuedUs;
 
-    // Trim the data and log it
-    data = data.trimmed();
-    qCDebug(serverCategory) << "handleClientData: Trimmed data:" << data;
+    // Payloads are not logged, they may carry passwords and logging them used
+    // to cost more than handling the request
+    record.bytesIn = payload.size();
+    const QByteArray data = payload.trimmed();
 
     // Validate the JSON data before parsing
     if (!data.startsWith('{') || !data.endsWith('}')) {
@@ -376,17 +1324,18 @@ void server::handleClientData(QTcpSocket* socket) {
         if (socket->isOpen()) {
             QJsonObject responseObj;
             responseObj["response"] = "Invalid JSON format (missing curly braces)";
-            QByteArray responseData = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
-            if (!responseData.isEmpty()) {
-                socket->write(responseData);
-            }
+            sendResponse(socket, responseObj);
         }
         return;
     }
 
     // Parse the JSON data
     QJsonParseError parseError;
-    const QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    QJsonDocument doc;
+    {
+        TraceSpan span("parseJson", "tcp");
+        doc = QJsonDocument::fromJson(data, &parseError);
+    }
 
     if (parseError.error != QJsonParseError::NoError) {
         qCWarning(serverCategory) << "handleClientData: JSON parse error:" << parseError.errorString();
@@ -395,76 +1344,80 @@ void server::handleClientData(QTcpSocket* socket) {
             QJsonObject responseObj;
             responseObj["response"] = "Invalid JSON format";
             responseObj["error"] = parseError.errorString();
-            QByteArray responseData = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
-            if (!responseData.isEmpty()) {
-                socket->write(responseData);
-            }
+            sendResponse(socket, responseObj);
         }
         return;
     }
 
-    // Log the parsed JSON object
     const QJsonObject obj = doc.object();
-    qCDebug(serverCategory) << "handleClientData: Parsed JSON object:" << QJsonDocument(obj).toJson(QJsonDocument::Indented);
+    record.command = obj.value("request").toString();
+    if (obj.contains("username")) {
+        record.user = obj.value("username").toString();
+    }
+    qCDebug(serverCategory) << "handleClientData:" << record.command << data.size() << "bytes";
+
+    // A token from an earlier login identifies the connection with one HMAC
+    // instead of a password hash; clients send it with their requests
+    QString sessionUser;
+    if (obj.contains("token")) {
+        QByteArray accountTag;
+        sessionUser = sessionTokens.verify(obj.value("token").toString(), &accountTag);
+        // A dropped account or a changed password revokes the tokens issued before
+        if (!sessionUser.isEmpty() && (accountTag.isEmpty() || accountStore.credentialTag(sessionUser) != accountTag)) {
+            sessionUser.clear();
+        }
+        if (sessionUser.isEmpty()) {
+            Metrics::instance().sessionTokensRejected.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            Metrics::instance().sessionTokensAccepted.fetch_add(1, std::memory_order_relaxed);
+            socket->setProperty("username", sessionUser);
+            record.user = sessionUser;
+        }
+    }
 
     // Handle different types of client requests
     if (obj.contains("request") && obj.value("request").toString() == "loginRequest") {
         const QJsonObject loginData = obj.value("data").toObject();
         const QString username = loginData.value("username").toString();
         const QString password = loginData.value("password").toString();
+        record.user = username;
 
-        if (checkCredentials(username, password)) {
-            if (socket->isOpen()) {
-                QJsonObject responseObj;
-                responseObj["response"] = "Login successful";
-                socket->write(QJsonDocument(responseObj).toJson(QJsonDocument::Compact));
-            }
-            const QString time = QDateTime::currentDateTime().toString("hh:mm:ss");
-            saveUserStatus(username, "online", time);
-        } else {
-            if (socket->isOpen()) {
-                QJsonObject responseObj;
-                responseObj["response"] = "Incorrect username or password";
-                QByteArray responseData = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
-                if (!responseData.isEmpty()) {
-                    socket->write(responseData);
-                }
-            }
-        }
+        // The password hash runs on the account worker, as Register does; the
+        // answer goes out when it is done, if the client is still there
+        const quint64 ticket = ++nextAccountTicket;
+        pendingLogins.insert(ticket, socket);
+        accountWorker->verifyLogin(ticket, username, password);
     } else if (obj.contains("request") && obj.value("request").toString() == "currentLoginUser"){
         getUserWithClosestTime(socket);
+    } else if (obj.contains("request") && obj.value("request").toString() == "resumeSession") {
+        QJsonObject responseObj;
+        if (sessionUser.isEmpty()) {
+            responseObj["response"] = "Session expired";
+        } else {
+            responseObj["response"] = "Session resumed";
+            responseObj["username"] = sessionUser;
+        }
+        sendResponse(socket, responseObj);
     } else if (obj.contains("request") && obj.value("request").toString() == "Exit") {
-        const QString time = QDateTime::currentDateTime().toString("hh:mm:ss");
+        const QString time = Clock::instance().timeOfDay().toString("hh:mm:ss");
+        // The connection's own user when it logged in or sent a token
+        const QString socketUser = socket->property("username").toString();
+        const QString exitUser = socketUser.isEmpty() ? currentUsername : socketUser;
 
-        qCDebug(serverCategory) << "handleClientData: User" << currentUsername << "requested exit at" << time;
+        qCDebug(serverCategory) << "handleClientData: User" << exitUser << "requested exit at" << time;
 
-        saveUserStatus(currentUsername, "offline", time);
+        saveUserStatus(exitUser, "offline", time);
         if (socket->isOpen()) {
             QJsonObject responseObj;
             responseObj["response"] = "Exit successful";
-            QByteArray responseData = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
-            if (!responseData.isEmpty()) {
-                socket->write(responseData);
-            }
+            sendResponse(socket, responseObj);
         }
     } else if (obj.contains("request") && obj.value("request").toString() == "showInfo") {
         const QString username = obj.value("username").toString();
-        QJsonObject loadedData = loadJsonFile();
-        QJsonArray usersArray = loadedData.value("users").toArray();
-
-        bool infoFound = false;
-        QJsonObject userInfo;
-
-        for (const QJsonValue &value : usersArray) {
-            QJsonObject userObj = value.toObject();
-            if (userObj.value("username").toString() == username) {
-                if (userObj.contains("info")) {
-                    userInfo = userObj.value("info").toObject();
-                    infoFound = true;
-                }
-                break;
-            }
-        }
+        StorageTimer storageTimer;
+        const bool infoFound = accountStore.hasProfile(username);
+        const QJsonObject userInfo = accountStore.profile(username);
+        storageTimer.stop();
 
         QJsonObject responseObj;
         if (infoFound) {
@@ -475,9 +1428,7 @@ void server::handleClientData(QTcpSocket* socket) {
         }
 
         if (socket->isOpen()) {
-            QByteArray responseData = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
-            qCDebug(serverCategory) << "Sending response:" << responseData;
-            qint64 bytesWritten = socket->write(responseData);
+            qint64 bytesWritten = sendResponse(socket, responseObj);
             if (bytesWritten == -1) {
                 qCWarning(serverCategory) << "Failed to write to socket:" << socket->errorString();
             } else {
@@ -489,17 +1440,9 @@ void server::handleClientData(QTcpSocket* socket) {
         }
     } else if (obj.contains("request") && obj.value("request").toString() == "addInfo") {
         const QString username = obj.value("username").toString();
-        QJsonObject loadedData = loadJsonFile();
-        QJsonArray usersArray = loadedData.value("users").toArray();
-
-        bool infoFound = false;
-        for (const QJsonValue &value : usersArray) {
-            QJsonObject userObj = value.toObject();
-            if (userObj.value("username").toString() == username && userObj.contains("info")) {
-                infoFound = true;
-                break;
-            }
-        }
+        StorageTimer storageTimer;
+        const bool infoFound = accountStore.hasProfile(username);
+        storageTimer.stop();
 
         if (socket->isOpen()) {
             QJsonObject responseObj;
@@ -508,10 +1451,7 @@ void server::handleClientData(QTcpSocket* socket) {
             } else {
                 responseObj["response"] = "addInfo";
             }
-            QByteArray responseData = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
-            if (!responseData.isEmpty()) {
-                socket->write(responseData);
-            }
+            sendResponse(socket, responseObj);
         }
     } else if (obj.contains("request") && obj.value("request").toString() == "saveInfo") {
         const QString username = obj.value("username").toString();
@@ -519,17 +1459,9 @@ void server::handleClientData(QTcpSocket* socket) {
         saveInfoData(username, infoData, socket);
     } else if (obj.contains("request") && obj.value("request").toString() == "updateInfo") {
         const QString username = obj.value("username").toString();
-        QJsonObject loadedData = loadJsonFile();
-        QJsonArray usersArray = loadedData.value("users").toArray();
-
-        bool infoFound = false;
-        for (const QJsonValue &value : usersArray) {
-            QJsonObject userObj = value.toObject();
-            if (userObj.value("username").toString() == username && userObj.contains("info")) {
-                infoFound = true;
-                break;
-            }
-        }
+        StorageTimer storageTimer;
+        const bool infoFound = accountStore.hasProfile(username);
+        storageTimer.stop();
 
         if (socket->isOpen()) {
             QJsonObject responseObj;
@@ -538,10 +1470,7 @@ void server::handleClientData(QTcpSocket* socket) {
             } else {
                 responseObj["response"] = "noInfo";
             }
-            QByteArray responseData = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
-            if (!responseData.isEmpty()) {
-                socket->write(responseData);
-            }
+            sendResponse(socket, responseObj);
         }
     } else if (obj.contains("request") && obj.value("request").toString() == "showPoints") {
         const QString username = obj.value("username").toString();
@@ -550,138 +1479,94 @@ void server::handleClientData(QTcpSocket* socket) {
         const QJsonObject requestData = obj.value("Data").toObject(); // Corrected from "Data" to obj.value("Data").toObject()
         handleClientRegister(socket, requestData);
     } else {
-        qCWarning(serverCategory) << "handleClientData: Missing required fields in JSON object:" << QJsonDocument(obj).toJson(QJsonDocument::Indented);
+        qCWarning(serverCategory) << "handleClientData: Missing required fields in JSON object, keys:" << obj.keys();
         if (socket->isOpen()) {
             QJsonObject responseObj;
             responseObj["response"] = "Invalid Client's data format (missing required fields)";
-            socket->write(QJsonDocument(responseObj).toJson(QJsonDocument::Compact));
+            sendResponse(socket, responseObj);
         }
     }
 }
 
 void server::handleClientRegister(QTcpSocket* socket, const QJsonObject &requestObj) {
-    QString username = requestObj.value("username").toString();
-    QString password = requestObj.value("password").toString(); // Correctly extracting password
-
-    QJsonObject loadedData = loadJsonFile();
-    QJsonArray usersArray = loadedData.value("users").toArray();
-
-    // Check if username already exists
-    bool userExists = false;
-    for (const QJsonValue &value : usersArray) {
-        QJsonObject userObj = value.toObject();
-        if (userObj.value("username").toString() == username) {
-            userExists = true;
-            break;
-        }
-    }
-
-    if (userExists) {
-        QJsonObject responseObj;
-        responseObj["response"] = "userExist";
-        socket->write(QJsonDocument(responseObj).toJson(QJsonDocument::Compact));
-        return;
-    }
-
-    // Create new user object
-    QJsonObject newUser;
-    newUser["username"] = username;
-    newUser["password"] = password; // Store password, consider hashing in a real application
+    TraceSpan span("handleClientRegister");
+    const QString username = requestObj.value("username").toString();
+    const QString password = requestObj.value("password").toString();
+
+    // Hashing and rewriting account.json happen on the account worker; the
+    // answer goes out when it is done, if the client is still there
+    const quint64 ticket = ++nextAccountTicket;
+    pendingRegistrations.insert(ticket, socket);
+    QMetaObject::invokeMethod(accountWorker, [worker = accountWorker, ticket, username, password]() {
+        worker->registerAccount(ticket, username, password);
+    }, Qt::QueuedConnection);
+}
 
-    // Add new user to array and save
-    usersArray.append(newUser);
-    loadedData["users"] = usersArray;
-    saveJsonFile(loadedData); // Assuming you have a function to save the JSON file
+// Cheap answer for a command the scheduler refused; the client may send it
+// again after retryAfterMs
+void server::sendRetryAfter(QTcpSocket* socket, const QString &command, int retryAfterMs) {
+    RequestScope requestScope(requestLog, "tcp", command.isEmpty() ? QString("other") : command);
+    RequestRecord &record = requestScope.record();
+    record.connectionId = socket->property("connectionId").toULongLong();
+    record.peer = socket->peerAddress().toString();
+    record.user = socket->property("username").toString();
 
-    // Send response back to client
     QJsonObject responseObj;
-    responseObj["response"] = "newUser";
-    socket->write(QJsonDocument(responseObj).toJson(QJsonDocument::Compact));
+    responseObj["response"] = "retryAfter";
+    responseObj["request"] = command;
+    responseObj["retryAfterMs"] = retryAfterMs;
+    sendResponse(socket, responseObj);
 }
 
-// Assuming you have a function to save the JSON file
-void server::saveJsonFile(const QJsonObject &data) {
-    QString filePath = QCoreApplication::applicationDirPath() + "/account/account.json";
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        qCWarning(serverCategory) << "Failed to open file for writing:" << file.errorString();
+void server::finishLogin(QTcpSocket* socket, const QString &username, bool ok) {
+    TraceSpan span("finishLogin");
+    if (!ok) {
+        qCWarning(serverCategory) << "finishLogin: Username or password incorrect.";
+        if (socket && socket->isOpen()) {
+            QJsonObject responseObj;
+            responseObj["response"] = "Incorrect username or password";
+            sendResponse(socket, responseObj);
+        }
         return;
     }
-    file.write(QJsonDocument(data).toJson(QJsonDocument::Indented));
-    file.close();
-    QMessageBox::information(this, "Infomation", "Saved successfull");
-}
-
-bool server::checkCredentials(const QString &username, const QString &password) {
-    QJsonObject loadedData = loadJsonFile();
-
-    if (loadedData.isEmpty()) {
-        qCWarning(serverCategory) << "checkCredentials: Failed to load or parse JSON data.";
-        return false;
-    }
-
-    qCDebug(serverCategory) << "checkCredentials: Loaded JSON data:" << QJsonDocument(loadedData).toJson(QJsonDocument::Indented);
 
-    const QJsonArray accountsArray = loadedData.value("users").toArray();
-    for (const QJsonValue &value : accountsArray) {
-        const QJsonObject accountObj = value.toObject();
-        if (accountObj.value("username").toString() == username && accountObj.value("password").toString() == password) {
-            currentUsername = username;
-            return true;
-        }
+    currentUsername = username;
+    // A client that left while its password was checked never comes online
+    if (!socket || !socket->isOpen()) {
+        return;
     }
+    socket->setProperty("username", username);
+    QJsonObject responseObj;
+    responseObj["response"] = "Login successful";
+    responseObj["token"] = sessionTokens.issue(username, accountStore.credentialTag(username));
+    responseObj["expiresIn"] = sessionTokens.lifetime();
+    sendResponse(socket, responseObj);
 
-    qCWarning(serverCategory) << "checkCredentials: Username or password incorrect.";
-    return false;
+    const QString time = Clock::instance().timeOfDay().toString("hh:mm:ss");
+    saveUserStatus(username, "online", time);
 }
 
 QJsonArray server::handleUserStatusRequest() {
     QJsonObject jsonData = loadJsonFile();
     QJsonArray accountsArray = jsonData["users"].toArray();
 
-    QString date = QDateTime::currentDateTime().toString("yyyy-MM-dd");
-    QString baseDir = QCoreApplication::applicationDirPath();
-    QString dirPath = baseDir + "/status/" + date;
-    QString filePath = dirPath + "/status.json";
-
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qCWarning(serverCategory) << "handleUserStatusRequest: Couldn't open the file:" << file.errorString();
+    const QDate date = Clock::instance().today();
+    if (!QFile::exists(timesheetStore.statusFilePath(date))) {
+        qCWarning(serverCategory) << "handleUserStatusRequest: No status file for" << date;
         return QJsonArray();
     }
+    const QJsonArray users = timesheetStore.loadStatusEvents(date);
 
-    QByteArray fileData = file.readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(fileData);
-    QJsonObject rootObj = doc.object();
-    QJsonArray users = rootObj.value("users").toArray();
+    // Latest event of each account strictly before now, to the second
+    const QTime now = Clock::instance().timeOfDay();
+    const QMap<QString, QJsonObject> latest = TimesheetStore::latestStatusAt(users, now, false);
 
     QJsonArray responseArray;
     for (const QJsonValue &accountValue : accountsArray) {
-        QJsonObject accountObj = accountValue.toObject();
-        QString username = accountObj["username"].toString();
-
-        QJsonObject closestUserObj;
-        qint64 closestTimeDiff = std::numeric_limits<qint64>::max();
-        QDateTime currentTime = QDateTime::currentDateTime();
-        QString currentTimeStr = currentTime.toString("hh:mm:ss");
-        currentTime = QDateTime::fromString(currentTimeStr, "hh:mm:ss");
-        for (const QJsonValue &userValue : users) {
-            QJsonObject userObj = userValue.toObject();
-            if (userObj["username"].toString() == username) {
-                QString userTimeStr = userObj["time"].toString("hh:mm:ss");
-                QDateTime userTime = QDateTime::fromString(userTimeStr, "hh:mm:ss");
-                if (userTime < currentTime) {
-                    qint64 timeDiff = qAbs(userTime.msecsTo(currentTime));
-                    if (timeDiff < closestTimeDiff) {
-                        closestTimeDiff = timeDiff;
-                        closestUserObj = userObj;
-                    }
-                }
-            }
-        }
-
-        if (!closestUserObj.isEmpty()) {
-            responseArray.append(closestUserObj);
+        const QString username = accountValue.toObject().value("username").toString();
+        auto it = latest.constFind(username);
+        if (it != latest.constEnd()) {
+            responseArray.append(*it);
         }
     }
 
@@ -689,35 +1574,38 @@ QJsonArray server::handleUserStatusRequest() {
 }
 
 void server::getUserWithClosestTime(QTcpSocket* socket) {
-    QString date = QDateTime::currentDateTime().toString("yyyy-MM-dd");
+    TraceSpan span("getUserWithClosestTime");
+    QString date = Clock::instance().today().toString("yyyy-MM-dd");
     QString baseDir = QCoreApplication::applicationDirPath();
     QString dirPath = baseDir + "/status/" + date;
     QString filePath = dirPath + "/status.json";
 
+    StorageTimer storageTimer;
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         qCWarning(serverCategory) << "getUserWithClosestTime: Couldn't open the file:" << file.errorString();
         if (socket->isOpen()) {
             QJsonObject responseObj;
             responseObj["response"] = "Error: Couldn't open the status file.";
-            socket->write(QJsonDocument(responseObj).toJson(QJsonDocument::Compact));
+            sendResponse(socket, responseObj);
         }
         return;
     }
 
     QByteArray fileData = file.readAll();
+    storageTimer.stop();
     QJsonDocument doc = QJsonDocument::fromJson(fileData);
     QJsonObject rootObj = doc.object();
     QJsonArray users = rootObj.value("users").toArray();
 
     QJsonObject closestUserObj;
     qint64 closestTimeDiff = std::numeric_limits<qint64>::max();
-    QDateTime currentTime = QDateTime::currentDateTime();
+    const QTime currentTime = Clock::instance().timeOfDay();
 
     for (const QJsonValue &userValue : users) {
         QJsonObject userObj = userValue.toObject();
         QString userTimeStr = userObj["time"].toString();
-        QDateTime userTime = QDateTime::fromString(userTimeStr, "hh:mm:ss");
+        QTime userTime = QTime::fromString(userTimeStr, "hh:mm:ss");
         if (userTime.isValid()) {
             qint64 timeDiff = qAbs(currentTime.msecsTo(userTime));
             if (timeDiff < closestTimeDiff) {
@@ -732,389 +1620,261 @@ void server::getUserWithClosestTime(QTcpSocket* socket) {
     QJsonArray usersArray;
     usersArray.append(closestUserObj);
     responseObj["users"] = usersArray;
-    QByteArray responseMessage = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
 
-    socket->write(responseMessage);
+    sendResponse(socket, responseObj);
     if (!socket->waitForBytesWritten()) {
         qCWarning(serverCategory) << "getUserWithClosestTime: Failed to send user status.";
     }
 }
 
 void server::on_btnView_clicked() {
-    QJsonArray responseArray = handleUserStatusRequest();
-
-    QStandardItemModel *model = new QStandardItemModel(responseArray.size(), 3, this);
-    model->setHorizontalHeaderLabels({"Username", "Time", "Status"});
-
-    for (int row = 0; row < responseArray.size(); ++row) {
-        QJsonObject userObj = responseArray[row].toObject();
-        model->setItem(row, 0, new QStandardItem(userObj["username"].toString()));
-        model->setItem(row, 1, new QStandardItem(userObj["time"].toString()));
-
-        QStandardItem *statusItem = new QStandardItem();
-        QString status = userObj["status"].toString();
-        if (status == "online") {
-            statusItem->setIcon(QIcon(":/icon/shape.png"));
-        } else if (status == "offline") {
-            statusItem->setIcon(QIcon(":/icon/circle.png"));
-        }
-        model->setItem(row, 2, statusItem);
+    StallScope stallScope("on_btnView_clicked");
+    presenceModel->setEvents(handleUserStatusRequest());
+    refreshRosterFilter();
+
+    // Back to today: the timesheet goes live again
+    if (showingPastPoints) {
+        showingPastPoints = false;
+        showTimesheet();
     }
 
-    ui->tableView->setModel(model);
-    QTimer *viewTimer = new QTimer(this);
-    connect(viewTimer, &QTimer::timeout, this, &server::on_btnView_clicked);
-    viewTimer->start(10000);
-}
-
-void server::saveUserStatus(const QString &username, const QString &status, const QString &time) {
-    QString date = QDateTime::currentDateTime().toString("yyyy-MM-dd");
-    QString baseDir = QCoreApplication::applicationDirPath();
-    QString dirPath = baseDir + "/status/" + date;
-    qCDebug(serverCategory) << "saveUserStatus: Directory path:" << dirPath;
-
-    QDir dir;
-    if (!dir.exists(dirPath)) {
-        if (!dir.mkpath(dirPath)) {
-            qCWarning(serverCategory) << "saveUserStatus: Couldn't create the directory:" << dirPath;
-            return;
-        }
+    // Keep the live view fresh; one timer, however often the button is pressed
+    if (!presenceTimer) {
+        presenceTimer = new QTimer(this);
+        connect(presenceTimer, &QTimer::timeout, this, &server::on_btnView_clicked);
     }
+    presenceTimer->start(10000);
+}
 
-    QString filePath = dirPath + "/status.json";
-    qCDebug(serverCategory) << "saveUserStatus: File path:" << filePath;
-
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadWrite | QIODevice::Text)) {
-        qCWarning(serverCategory) << "saveUserStatus: Couldn't open the file:" << file.errorString();
+// Narrows both tables to the accounts matching the search box and filters.
+// The name search goes through the index; the status and points filters only
+// check the accounts it returned, or every account when no name is given.
+void server::applyRosterFilter() {
+    StallScope stallScope("applyRosterFilter");
+    const QString text = ui->leSearch->text().trimmed();
+    const int status = ui->cbStatusFilter->currentIndex(); // All, Online, Offline
+    const qint64 minPoints = ui->sbPointsMin->value();
+    const qint64 maxPoints = ui->sbPointsMax->value(); // 0 is "Any"
+
+    if (text.isEmpty() && status == 0 && minPoints == 0 && maxPoints == 0) {
+        presenceModel->clearFilter();
+        timesheetModel->clearFilter();
         return;
     }
 
-    QJsonDocument doc;
-    QJsonObject rootObj;
-    QJsonArray users;
-
-    if (file.size() > 0) {
-        const QByteArray jsonData = file.readAll();
-        QJsonParseError parseError;
-        doc = QJsonDocument::fromJson(jsonData, &parseError);
-        if (parseError.error != QJsonParseError::NoError) {
-            qCWarning(serverCategory) << "saveUserStatus: JSON parse error:" << parseError.errorString();
-            file.close();
-            return;
+    if (rosterIndexStale) {
+        TraceSpan span("rosterIndexRebuild", "ui");
+        rosterIndex.rebuild(accountStore.accounts(), accountStore.allProfiles());
+        rosterIndexStale = false;
+    }
+    const QStringList candidates = text.isEmpty() ? rosterIndex.allUsernames() : rosterIndex.search(text);
+
+    QStringList keys;
+    for (const QString &username : candidates) {
+        if (status != 0) {
+            const PresenceRow *presence = presenceModel->find(username);
+            const bool online = presence && presence->status == "online";
+            if (online != (status == 1)) {
+                continue;
+            }
+        }
+        if (minPoints > 0 || maxPoints > 0) {
+            const TimesheetStore::TimesheetRow *row = timesheetModel->find(username);
+            const qint64 points = row ? row->points : 0;
+            if (points < minPoints || (maxPoints > 0 && points > maxPoints)) {
+                continue;
+            }
         }
-        rootObj = doc.object();
-        users = rootObj.value("users").toArray();
+        keys.append(username);
     }
+    presenceModel->setFilter(keys);
+    timesheetModel->setFilter(keys);
+}
 
-    QJsonObject userObj;
-    userObj["username"] = username;
-    userObj["status"] = status;
-    userObj["time"] = time;
-    users.append(userObj);
+// Status and points move with every refresh; a name search does not
+void server::refreshRosterFilter() {
+    if (ui->cbStatusFilter->currentIndex() != 0 || ui->sbPointsMin->value() != 0 || ui->sbPointsMax->value() != 0) {
+        applyRosterFilter();
+    }
+}
 
-    rootObj["users"] = users;
-    doc.setObject(rootObj);
-    file.resize(0);
-    if (file.write(doc.toJson(QJsonDocument::Indented)) == -1) {
-        qCWarning(serverCategory) << "saveUserStatus: Failed to write to the file:" << file.errorString();
-    } else {
+void server::saveUserStatus(const QString &username, const QString &status, const QString &time) {
+    StallScope stallScope("saveUserStatus");
+    TraceSpan span("saveUserStatus", "storage");
+    StorageTimer storageTimer;
+    if (timesheetStore.appendStatusEvent(Clock::instance().today(), username, status, time)) {
+        Metrics::instance().statusEventsWritten.fetch_add(1, std::memory_order_relaxed);
         qCDebug(serverCategory) << "saveUserStatus: User status recorded:" << username << status << time;
     }
-
-    file.close();
 }
 
 void server::on_btnSubmit_clicked()
 {
-    QString date = ui->dateEdit->date().toString("yyyy-MM-dd");
-    QString baseDir = QCoreApplication::applicationDirPath();
-    QString statusFilePath = baseDir + "/status/" + date + "/status.json";
-    QString pointsFilePath = baseDir + "/points/" + date + "_points.json";
+    StallScope stallScope("on_btnSubmit_clicked");
+    const QDate date = ui->dateEdit->date();
 
     // Handle status file
-    QFile statusFile(statusFilePath);
-    if (!statusFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qCWarning(serverCategory) << "on_btnSubmit_clicked: Couldn't open the status file:" << statusFile.errorString();
+    if (!QFile::exists(timesheetStore.statusFilePath(date))) {
+        qCWarning(serverCategory) << "on_btnSubmit_clicked: No status file for" << date;
         return;
     }
-
-    QByteArray statusData = statusFile.readAll();
-    QJsonDocument statusDoc = QJsonDocument::fromJson(statusData);
-    QJsonObject statusRootObj = statusDoc.object();
-    QJsonArray users = statusRootObj.value("users").toArray();
-    statusFile.close();
+    const QJsonArray users = timesheetStore.loadStatusEvents(date);
 
     QJsonArray responseArray;
-    QDateTime requestTime = QDateTime::fromString(ui->timeEdit->time().toString("hh:mm:ss"), "hh:mm:ss");
-
-    QMap<QString, QJsonObject> closestUsers;
-
-    for (const QJsonValue &userValue : users) {
-        QJsonObject userObj = userValue.toObject();
-        QString username = userObj["username"].toString();
-        QDateTime userTime = QDateTime::fromString(userObj["time"].toString(), "hh:mm:ss");
-
-        if (userTime <= requestTime) {
-            if (!closestUsers.contains(username) ||
-                QDateTime::fromString(closestUsers[username]["time"].toString(), "hh:mm:ss") < userTime) {
-                closestUsers[username] = userObj;
-            }
-        }
-    }
+    // Drop milliseconds, the status file stores whole seconds
+    const QTime requestTime = QTime::fromString(ui->timeEdit->time().toString("hh:mm:ss"), "hh:mm:ss");
+    const QMap<QString, QJsonObject> closestUsers = TimesheetStore::latestStatusAt(users, requestTime, true);
 
     for (const QJsonObject &userObj : closestUsers) {
         responseArray.append(userObj);
     }
 
-    QStandardItemModel *statusModel = new QStandardItemModel(responseArray.size(), 3, this);
-    statusModel->setHorizontalHeaderLabels({"Username", "Time", "Status"});
-
-    for (int row = 0; row < responseArray.size(); ++row) {
-        QJsonObject userObj = responseArray[row].toObject();
-        statusModel->setItem(row, 0, new QStandardItem(userObj["username"].toString()));
-        statusModel->setItem(row, 1, new QStandardItem(userObj["time"].toString()));
-
-        QStandardItem *statusItem = new QStandardItem();
-        QString status = userObj["status"].toString();
-        if (status == "online") {
-            statusItem->setIcon(QIcon(":/icon/icon/shape.png"));
-        } else if (status == "offline") {
-            statusItem->setIcon(QIcon(":/icon/icon/circle.png"));
+    // A past moment does not change, stop refreshing the live view over it
+    if (presenceTimer) {
+        presenceTimer->stop();
+    }
+    presenceModel->setEvents(responseArray);
+    refreshRosterFilter();
+
+    // Today's timesheet stays live; a past day shows its saved points until View is pressed
+    if (date == Clock::instance().today()) {
+        if (showingPastPoints) {
+            showingPastPoints = false;
+            showTimesheet();
         }
-        statusModel->setItem(row, 2, statusItem);
+        return;
     }
 
-    ui->tableView->setModel(statusModel);
-
     // Handle points file
-    QFile pointsFile(pointsFilePath);
-    if (!pointsFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qCWarning(serverCategory) << "on_btnSubmit_clicked: Couldn't open the points file:" << pointsFile.errorString();
+    if (!QFile::exists(timesheetStore.pointsFilePath(date))) {
+        qCWarning(serverCategory) << "on_btnSubmit_clicked: No points file for" << date;
         return;
     }
+    const QJsonObject pointsObj = timesheetStore.loadPoints(date);
 
-    QByteArray pointsData = pointsFile.readAll();
-    QJsonDocument pointsDoc = QJsonDocument::fromJson(pointsData);
-    QJsonObject pointsObj = pointsDoc.object();
-    pointsFile.close();
-
-    QStandardItemModel *pointsModel = new QStandardItemModel(pointsObj.size(), 2, this);
-    pointsModel->setHorizontalHeaderLabels({"Username", "Points"});
-
-    int row = 0;
-    for (auto it = pointsObj.begin(); it != pointsObj.end(); ++it, ++row) {
-        pointsModel->setItem(row, 0, new QStandardItem(it.key()));
-        pointsModel->setItem(row, 1, new QStandardItem(QString::number(it.value().toInt())));
-    }
-
-    ui->tableTimesheet->setModel(pointsModel);
+    showingPastPoints = true;
+    timesheetModel->setPoints(pointsObj);
+    refreshRosterFilter();
 }
 
 void server::saveInfoData(const QString &username, const QJsonObject &infoData, QTcpSocket* socket) {
-    QJsonObject loadedData = loadJsonFile();
-    QJsonArray usersArray = loadedData.value("users").toArray();
-
-    bool userFound = false;
-    for (int i = 0; i < usersArray.size(); ++i) {
-        QJsonObject userObj = usersArray[i].toObject();
-        if (userObj.value("username").toString() == username) {
-            userObj["info"] = infoData;
-            usersArray[i] = userObj;
-            userFound = true;
-            break;
-        }
-    }
-
-    if (!userFound) {
+    TraceSpan span("saveInfoData");
+    if (!accountStore.contains(username)) {
         qCWarning(serverCategory) << "saveInfoData: Username not found in JSON data.";
         if (socket->isOpen()) {
             QJsonObject responseObj;
             responseObj["response"] = "Username not found";
-            QByteArray responseData = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
-            if (!responseData.isEmpty()) {
-                socket->write(responseData);
-            }
+            sendResponse(socket, responseObj);
         }
         return;
     }
 
-    loadedData["users"] = usersArray;
-
-    QString relativePath = QCoreApplication::applicationDirPath() + "/account/account.json";
-    QFile file(relativePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qCWarning(serverCategory) << "saveInfoData: Couldn't open the file for writing:" << file.errorString();
+    StorageTimer storageTimer;
+    if (!accountStore.setProfile(username, infoData)) {
+        qCWarning(serverCategory) << "saveInfoData: Couldn't save the profile of" << username;
         if (socket->isOpen()) {
             QJsonObject responseObj;
             responseObj["response"] = "Failed to save data";
-            QByteArray responseData = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
-            if (!responseData.isEmpty()) {
-                socket->write(responseData);
-            }
+            sendResponse(socket, responseObj);
         }
         return;
     }
-
-    file.write(QJsonDocument(loadedData).toJson(QJsonDocument::Indented));
-    file.close();
+    storageTimer.stop();
+    rosterIndex.setFullName(username, infoData.value("Fullname").toString());
 
     if (socket->isOpen()) {
         QJsonObject responseObj;
         responseObj["response"] = "Info saved successfully";
-        QByteArray responseData = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
-        if (!responseData.isEmpty()) {
-            socket->write(responseData);
-        }
+        sendResponse(socket, responseObj);
     }
 }
 
 
 void server::updateClock()
 {
-    QString currentTime = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
+    StallScope stallScope("updateClock");
+    QString currentTime = Clock::instance().now().toString("yyyy-MM-dd hh:mm:ss");
     ui->lblClock->setText(currentTime);
-}
-
-
-void server::showTimesheet() {
-    QJsonObject jsonData = loadJsonFile();
-    QJsonArray accountsArray = jsonData["users"].toArray();
-
-    QString date = QDateTime::currentDateTime().toString("yyyy-MM-dd");
-    QString baseDir = QCoreApplication::applicationDirPath();
-    QString dirPath = baseDir + "/status/" + date;
-    QString filePath = dirPath + "/status.json";
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qCWarning(serverCategory) << "showTimesheet: Couldn't open the file:" << file.errorString();
-        return;
+    // First tick of a new day closes the previous one
+    const QDate today = Clock::instance().today();
+    if (today != rollupDay) {
+        rollupDay = today;
+        scheduleRollupCatchUp(today);
     }
+}
 
-    QByteArray fileData = file.readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(fileData);
-    QJsonObject rootObj = doc.object();
-    QJsonArray users = rootObj.value("users").toArray();
-
-    QStandardItemModel *model = new QStandardItemModel(accountsArray.size(), 6, this);
-    model->setHorizontalHeaderLabels({"Username", "Start", "End", "Bonus", "Minus", "Points"});
-
-    for (int row = 0; row < accountsArray.size(); ++row) {
-        QJsonObject accountObj = accountsArray[row].toObject();
-        QString username = accountObj["username"].toString();
-
-        QDateTime startTime, endTime;
-        int bonus = 0, minus = 0, points = 0;
-        bool isOnline = false;
-        bool firstOnlineFound = false;
-
-        for (const QJsonValue &userValue : users) {
-            QJsonObject userObj = userValue.toObject();
-            if (userObj["username"].toString() == username) {
-                QString status = userObj["status"].toString();
-                QDateTime time = QDateTime::fromString(userObj["time"].toString(), "hh:mm:ss");
-
-                if (status == "online") {
-                    if (!firstOnlineFound) {
-                        startTime = time;
-                        firstOnlineFound = true;
-                    }
-                    if (!isOnline) {
-                        startTime = time;
-                        isOnline = true;
-                    }
-                } else if (status == "offline" && isOnline) {
-                    endTime = time;
-                    isOnline = false;
-
-                    if (startTime.isValid() && endTime.isValid()) {
-                        qint64 duration = startTime.secsTo(endTime);
-                        points += (duration * 5) + bonus - minus;
-                    }
-                }
-            }
-        }
-
-        if (isOnline) {
-            endTime = QDateTime::fromString(QDateTime::currentDateTime().toString("hh:mm:ss"), "hh:mm:ss");
-            if (startTime.isValid() && endTime.isValid()) {
-                qint64 duration = startTime.secsTo(endTime);
-                points += (duration * 5) + bonus - minus;
-            }
-        }
-
-
-        // Ensure startTime and endTime are valid before displaying
-        QString startTimeStr = startTime.isValid() ? startTime.toString("hh:mm:ss") : "N/A";
-        QString endTimeStr = endTime.isValid() ? endTime.toString("hh:mm:ss") : "N/A";
-
-        model->setItem(row, 0, new QStandardItem(username));
-        model->setItem(row, 1, new QStandardItem(startTimeStr));
-        model->setItem(row, 2, new QStandardItem(endTimeStr));
-        model->setItem(row, 3, new QStandardItem(QString::number(bonus)));
-        model->setItem(row, 4, new QStandardItem(QString::number(minus)));
-        model->setItem(row, 5, new QStandardItem(QString::number(points)));
-
-
+void server::scheduleRollupCatchUp(const QDate &today)
+{
+    // Catches up on every missing day, not just yesterday, so a server that
+    // was down over midnight or a virtual clock jumping ahead lose nothing
+    rollupPool.start([this, today, rules = currentScoringRules()]() {
+        TraceSpan span("rollupCatchUp", "storage");
+        rollupStore.catchUp(timesheetStore, today, *rules);
+    });
+}
 
+// Without scoring.json the standard rules apply; a broken file keeps the rules in use
+bool server::loadScoringRules(QString *error)
+{
+    auto rules = std::make_shared<ScoringRules>();
+    const QString filePath = QCoreApplication::applicationDirPath() + "/scoring.json";
+    if (QFile::exists(filePath) && !rules->load(filePath, error)) {
+        return false;
     }
+    std::atomic_store(&scoringRules, std::shared_ptr<const ScoringRules>(std::move(rules)));
+    return true;
+}
 
-    ui->tableTimesheet->setModel(model);
-
-    QJsonObject pointsObj;
-
-    for (int row = 0; row < accountsArray.size(); ++row) {
-
-        QJsonObject accountObj = accountsArray[row].toObject();
+std::shared_ptr<const ScoringRules> server::currentScoringRules() const
+{
+    return std::atomic_load(&scoringRules);
+}
 
-        QString username = accountObj["username"].toString();
 
-        pointsObj[username] = model->item(row, 5)->text().toInt();
+void server::showTimesheet() {
+    StallScope stallScope("showTimesheet");
+    TraceSpan span("showTimesheet", "ui");
+    QJsonObject jsonData = loadJsonFile();
+    QJsonArray accountsArray = jsonData["users"].toArray();
 
+    const QDate date = Clock::instance().today();
+    if (!QFile::exists(timesheetStore.statusFilePath(date))) {
+        qCWarning(serverCategory) << "showTimesheet: No status file for" << date;
+        return;
     }
+    const QJsonArray users = timesheetStore.loadStatusEvents(date);
 
+    const QTime now = Clock::instance().timeOfDay();
+    const QList<TimesheetStore::TimesheetRow> rows = TimesheetStore::computeTimesheet(accountsArray, users, now,
+                                                                                      *currentScoringRules());
 
-    QString pointsFilePath = baseDir + "/points/" + date + "_points.json";
-    QDir pointsDir(baseDir + "/points");
-
-    if (!pointsDir.exists()) {
-
-        pointsDir.mkpath(".");
-
+    // Points are saved either way, showCurrentPoints reads them
+    if (!showingPastPoints) {
+        timesheetModel->setTimesheet(rows);
+        refreshRosterFilter();
     }
 
-
-    QFile pointsFile(pointsFilePath);
-
-    if (!pointsFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-
-        qCWarning(serverCategory) << "showTimesheet: Couldn't open the points file for writing:" << pointsFile.errorString();
-
-        return;
-
+    QJsonObject pointsObj;
+    for (const TimesheetStore::TimesheetRow &entry : rows) {
+        pointsObj[entry.username] = int(entry.points);
     }
 
-    QJsonDocument pointsDoc(pointsObj);
-
-
-    pointsFile.write(pointsDoc.toJson(QJsonDocument::Indented));
-
-    pointsFile.close();
+    timesheetStore.savePoints(date, pointsObj);
 }
 
 void server::showCurrentPoints(const QString &username, QTcpSocket* socket) {
-    QString date = QDateTime::currentDateTime().toString("yyyy-MM-dd");
-    QString baseDir = QCoreApplication::applicationDirPath();
-    QString pointsFilePath = baseDir + "/points/" + date + "_points.json";
+    TraceSpan span("showCurrentPoints");
+    QString pointsFilePath = timesheetStore.pointsFilePath(Clock::instance().today());
 
+    StorageTimer storageTimer;
     QFile pointsFile(pointsFilePath);
     if (!pointsFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
         qCWarning(serverCategory) << "showCurrentPoints: Couldn't open the points file:" << pointsFile.errorString();
         if (socket->isOpen()) {
             QJsonObject responseObj;
             responseObj["response"] = "Error: Couldn't open the points file.";
-            socket->write(QJsonDocument(responseObj).toJson(QJsonDocument::Compact));
+            sendResponse(socket, responseObj);
         }
         return;
     }
@@ -1123,6 +1883,7 @@ void server::showCurrentPoints(const QString &username, QTcpSocket* socket) {
     QJsonDocument pointsDoc = QJsonDocument::fromJson(pointsData);
     QJsonObject pointsObj = pointsDoc.object();
     pointsFile.close();
+    storageTimer.stop();
 
     int points = pointsObj.value(username).toInt();
 
@@ -1132,123 +1893,71 @@ void server::showCurrentPoints(const QString &username, QTcpSocket* socket) {
     responseObj["points"] = points;
 
     if (socket->isOpen()) {
-        QByteArray responseData = QJsonDocument(responseObj).toJson(QJsonDocument::Compact);
-        socket->write(responseData);
+        sendResponse(socket, responseObj);
     }
 }
 
 void server::on_btnCreate_clicked() {
+    StallScope stallScope("on_btnCreate_clicked");
     disconnect(ui->btnCreate, &QPushButton::clicked, this, &server::on_btnCreate_clicked);
-    QString username = ui->leUsername->text(); // Lấy username từ QLineEdit
-    QString password = "admin"; // Password mặc định
-
-    // Đọc dữ liệu hiện tại từ file
-    QJsonObject loadedData = loadJsonFile();
-    QJsonArray usersArray = loadedData.value("users").toArray();
-
-    // Tạo đối tượng người dùng mới
-    QJsonObject newUser;
-    newUser["username"] = username;
-    newUser["password"] = password;
-
-    // Thêm người dùng mới vào mảng
-    usersArray.append(newUser);
-    loadedData["users"] = usersArray;
-
-    // Ghi lại vào file
-    QString relativePath = QCoreApplication::applicationDirPath() + "/account/account.json";
-    QFile file(relativePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qCWarning(serverCategory) << "on_btnCreate_clicked: Couldn't open the file for writing:" << file.errorString();
-        return;
-    }
+    const QString username = ui->leUsername->text(); // Lấy username từ QLineEdit
+    const QString password = "admin"; // Password mặc định
 
-    QJsonDocument doc(loadedData);
-    file.write(doc.toJson(QJsonDocument::Indented));
-    file.close();
+    QMetaObject::invokeMethod(accountWorker, [worker = accountWorker, username, password]() {
+        worker->createAccount(username, password);
+    }, Qt::QueuedConnection);
 }
 
 
 void server::on_btnDrop_clicked() {
+    StallScope stallScope("on_btnDrop_clicked");
     disconnect(ui->btnDrop, &QPushButton::clicked, this, &server::on_btnDrop_clicked);
-    QString username = ui->leUsername->text(); // Lấy username từ QLabel
-
-    // Đọc dữ liệu hiện tại từ file
-    QJsonObject loadedData = loadJsonFile();
-    QJsonArray usersArray = loadedData.value("users").toArray();
+    const QString username = ui->leUsername->text(); // Lấy username từ QLabel
 
-    // Tạo một QJsonArray mới để lưu trữ các người dùng không bị xóa
-    QJsonArray updatedUsersArray;
-
-    // Duyệt qua mảng người dùng hiện tại và xóa người dùng có username tương ứng
-    for (int i = 0; i < usersArray.size(); ++i) {
-        QJsonObject user = usersArray[i].toObject();
-        if (user["username"].toString() != username) {
-            updatedUsersArray.append(user);
-        }
-    }
-
-    // Cập nhật mảng người dùng trong dữ liệu JSON
-    loadedData["users"] = updatedUsersArray;
-
-    // Ghi lại vào file
-    QString relativePath = QCoreApplication::applicationDirPath() + "/account/account.json";
-    QFile file(relativePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qCWarning(serverCategory) << "on_btnDrop_clicked: Couldn't open the file for writing:" << file.errorString();
-        return;
-    }
-
-    QJsonDocument doc(loadedData);
-    file.write(doc.toJson(QJsonDocument::Indented));
-    file.close();
+    QMetaObject::invokeMethod(accountWorker, [worker = accountWorker, username]() {
+        worker->dropAccount(username);
+    }, Qt::QueuedConnection);
 }
 
 void server::on_btnChange_clicked() {
+    StallScope stallScope("on_btnChange_clicked");
     disconnect(ui->btnChange, &QPushButton::clicked, this, &server::on_btnChange_clicked);
-    QString username = ui->leUsernameChange->text(); // Get the username from QLineEdit
-
-    // Read the current data from the file
-    QJsonObject loadedData = loadJsonFile();
-    QJsonArray usersArray = loadedData.value("users").toArray();
-    bool userExists = false;
-
-    // Iterate over the users array to find the user and update their info
-    for (int i = 0; i < usersArray.size(); ++i) {
-        QJsonObject userObj = usersArray[i].toObject();
-        if (userObj["username"].toString() == username) {
-            userExists = true;
-            QJsonObject infoObj = userObj["info"].toObject(); // Assuming each user has an "info" object
-
-            // Update user information if fields are not empty
-            QString fullname = ui->leFullnameChange->text();
-            if (!fullname.isEmpty()) infoObj["Fullname"] = fullname;
-
-            QString birthday = ui->leBirthdayChange->text();
-            if (!birthday.isEmpty()) infoObj["Birthday"] = birthday;
-
-            QString sex = ui->leSexChange->text();
-            if (!sex.isEmpty()) infoObj["Sex"] = sex;
-
-            QString email = ui->leEmailChange->text();
-            if (!email.isEmpty()) infoObj["Email"] = email;
-
-            QString tel = ui->leTelChange->text();
-            if (!tel.isEmpty()) infoObj["Tel"] = tel;
+    const QString username = ui->leUsernameChange->text(); // Get the username from QLineEdit
+
+    // Only the fields that are not empty are changed
+    QJsonObject fields;
+    fields["Fullname"] = ui->leFullnameChange->text();
+    fields["Birthday"] = ui->leBirthdayChange->text();
+    fields["Sex"] = ui->leSexChange->text();
+    fields["Email"] = ui->leEmailChange->text();
+    fields["Tel"] = ui->leTelChange->text();
+
+    QMetaObject::invokeMethod(accountWorker, [worker = accountWorker, username, fields]() {
+        worker->changeProfile(username, fields);
+    }, Qt::QueuedConnection);
+}
 
-            userObj["info"] = infoObj; // Update the user object with the modified info object
-            usersArray[i] = userObj; // Update the array with the modified user object
-            break;
-        }
+void server::importAccounts() {
+    const QString filePath = QFileDialog::getOpenFileName(this, "Import accounts", QString(),
+                                                          "Accounts (*.csv *.jsonl);;All files (*)");
+    if (filePath.isEmpty()) {
+        return;
     }
+    QMetaObject::invokeMethod(accountWorker, [worker = accountWorker, filePath]() {
+        worker->importAccounts(filePath);
+    }, Qt::QueuedConnection);
+    statusBar()->showMessage(QString("Importing %1...").arg(QFileInfo(filePath).fileName()));
+}
 
-    if (!userExists) {
-        QMessageBox::information(this, "Infomation", "Username not exist");
-    } else {
-        // Write the updated data back to the file
-        loadedData["users"] = usersArray;
-        saveJsonFile(loadedData); // Assuming you have a function to save the JSON file
+void server::exportAccounts() {
+    const QString filePath = QFileDialog::getSaveFileName(this, "Export accounts", "accounts.csv",
+                                                          "CSV (*.csv);;JSON lines (*.jsonl)");
+    if (filePath.isEmpty()) {
+        return;
     }
+    QMetaObject::invokeMethod(accountWorker, [worker = accountWorker, filePath]() {
+        worker->exportAccounts(filePath);
+    }, Qt::QueuedConnection);
 }
 
 void server::createInitialJsonFiles() {
@@ -1271,7 +1980,7 @@ void server::createInitialJsonFiles() {
     }
     
     // Create initial status.json
-    QString date = QDateTime::currentDateTime().toString("yyyy-MM-dd");
+    QString date = Clock::instance().today().toString("yyyy-MM-dd");
     QString statusDir = baseDir + "/status/" + date;
     QDir dir;
     if (!dir.exists(statusDir)) {
@@ -7,12 +7,40 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QHttpServer>
+#include <QHttpServerResponder>
+#include <QHttpServerResponse>
 #include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSet>
+#include <QThreadPool>
+#include <QThread>
+#include <QPointer>
+#include <memory>
+#include "timesheetstore.h"
+#include "accountstore.h"
+#include "rosterindex.h"
+#include "rollupstore.h"
+#include "scoringrules.h"
+#include "sessiontokens.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class server; }
 QT_END_NAMESPACE
 
+class IntroPreviewWorker;
+class AccountWorker;
+class QuotaLedger;
+class QLabel;
+class QTimer;
+class RequestLog;
+class EventLoopWatchdog;
+class CommandScheduler;
+class PresenceModel;
+class TimesheetModel;
+
 class server : public QMainWindow
 {
     Q_OBJECT
@@ -29,8 +57,9 @@ signals:
 private slots:
     void onNewConnection();
     void on_btnView_clicked();
-    void handleClientData(QTcpSocket* socket);
-    bool checkCredentials(const QString &username, const QString &password);
+    void applyRosterFilter();
+    void handleClientData(QTcpSocket* socket, const QByteArray &payload, qint64 queuedUs);
+    void sendRetryAfter(QTcpSocket* socket, const QString &command, int retryAfterMs);
     void getUserWithClosestTime(QTcpSocket* socket);
     void saveUserStatus(const QString &username, const QString &status, const QString &time);
     void on_btnSubmit_clicked();
@@ -39,22 +68,95 @@ private slots:
     void showTimesheet();
     void showCurrentPoints(const QString &username, QTcpSocket* socket);
     void setupHttpServer();
-    void handleImageUpload(const QHttpServerRequest &request);
-    void handleVideoUpload(const QHttpServerRequest &request);
+    QHttpServerResponse::StatusCode handleImageUpload(const QByteArray &rawData);
+    QHttpServerResponse::StatusCode handleVideoUpload(const QByteArray &rawVideo);
     void on_btnCreate_clicked();
     void on_btnDrop_clicked();
     void handleClientRegister(QTcpSocket* socket, const QJsonObject &obj);
-    void saveJsonFile(const QJsonObject &data);
     void on_btnChange_clicked();
+    void importAccounts();
+    void exportAccounts();
     void createInitialJsonFiles();
+    void updateMediaUsage(qint64 totalBytes, qint64 totalLimit);
 
 private:
     Ui::server *ui;
     QTcpServer *tcpServer;
+    TimesheetStore timesheetStore;
+    AccountStore accountStore;
+    SessionTokens sessionTokens;
     QJsonObject loadJsonFile();
     QJsonArray handleUserStatusRequest();
     QString currentUsername;
     QHttpServer *httpServer;
+    QThread *httpThread;
+    QThreadPool uploadPool; // Upload decoding and writes
+    void serveMediaFile(const QString &filePath, const QByteArray &mimeType,
+                        const QHttpServerRequest &request, QHttpServerResponder &&responder);
+    QByteArray mediaETag(const QFileInfo &fileInfo);
+    QHttpServerResponse cachedResponse(const QHttpServerRequest &request, const QByteArray &body,
+                                       const QByteArray &mimeType);
+
+    struct MediaETag {
+        qint64 size = -1;
+        QDateTime modified;
+        QByteArray etag;
+    };
+    QHash<QString, MediaETag> mediaETags;
+    QMutex mediaETagMutex;
+
+    void scheduleAvatarThumbnails(const QString &username);
+    QString avatarThumbnailPath(const QString &username, int size) const;
+    QString avatarPathForSize(const QString &username, int requestedSize);
+    QSet<QString> pendingThumbnails;
+    QMutex thumbnailMutex;
+    QThreadPool mediaPool; // Background media jobs (thumbnails)
+
+    void setupIntroPreviewWorker();
+    QThread *introThread;
+    IntroPreviewWorker *introWorker;
+
+    void setupAccountWorker();
+    void reportAccountJob(const QString &action, const QString &username, bool ok, const QString &error);
+    QThread *accountThread;
+    AccountWorker *accountWorker;
+    QHash<quint64, QPointer<QTcpSocket>> pendingRegistrations; // Register requests waiting for the worker
+    QHash<quint64, QPointer<QTcpSocket>> pendingLogins;
+    quint64 nextAccountTicket = 0;
+    void finishLogin(QTcpSocket *socket, const QString &username, bool ok);
+
+    void setupQuotaLedger();
+    bool exceedsUploadLimit(const QHttpServerRequest &request) const;
+    QuotaLedger *quotaLedger;
+    QLabel *lblMediaUsage;
+
+    // Set on the tables once and updated in place, see KeyedTableModel
+    PresenceModel *presenceModel;
+    TimesheetModel *timesheetModel;
+    QTimer *presenceTimer;
+    bool showingPastPoints = false; // The live timesheet refresh leaves the table alone
+    void refreshRosterFilter();
+    RosterIndex rosterIndex;
+    bool rosterIndexStale = true; // Rebuilt on the next search after accounts change
+
+    // Compiled from scoring.json; swapped whole on reload, read without locking
+    bool loadScoringRules(QString *error);
+    std::shared_ptr<const ScoringRules> currentScoringRules() const;
+    std::shared_ptr<const ScoringRules> scoringRules;
+
+    // Daily aggregates behind the /reports routes, finalized off the GUI thread
+    void scheduleRollupCatchUp(const QDate &today);
+    QHttpServerResponse rollupReport(const QString &period, const QHttpServerRequest &request);
+    RollupStore rollupStore;
+    QThreadPool rollupPool; // One thread, so days are finalized one at a time
+    QDate rollupDay;
+
+    qint64 sendResponse(QTcpSocket *socket, const QJsonObject &response);
+    CommandScheduler *commandScheduler;
+    RequestLog *requestLog;
+    quint64 nextConnectionId = 0;
+
+    EventLoopWatchdog *watchdog;
 
 private slots:
     void handleServerError(const QString &error) {
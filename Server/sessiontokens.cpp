@@ -0,0 +1,77 @@
+#include "sessiontokens.h"
+#include "clock.h"
+#include "passwordhash.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QMessageAuthenticationCode>
+#include <QRandomGenerator>
+
+Q_DECLARE_LOGGING_CATEGORY(serverCategory)
+
+static constexpr int keyBytes = 32;
+static const auto base64Url = QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals;
+
+SessionTokens::SessionTokens(const QString &keyPath)
+{
+    QFile file(keyPath);
+    if (file.open(QIODevice::ReadOnly)) {
+        key = file.readAll();
+        file.close();
+    }
+    if (key.size() >= keyBytes) {
+        return;
+    }
+
+    key = QByteArray(keyBytes, Qt::Uninitialized);
+    QRandomGenerator::system()->fillRange(reinterpret_cast<quint32 *>(key.data()), keyBytes / 4);
+    QDir().mkpath(QFileInfo(keyPath).path());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(serverCategory) << "SessionTokens: Couldn't save the key, tokens will not survive a restart:"
+                                  << file.errorString();
+        return;
+    }
+    file.write(key);
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+}
+
+QByteArray SessionTokens::signature(const QByteArray &payload) const
+{
+    return QMessageAuthenticationCode::hash(payload, key, QCryptographicHash::Sha256);
+}
+
+QString SessionTokens::issue(const QString &username, const QByteArray &accountTag) const
+{
+    const qint64 expiry = Clock::instance().now().toSecsSinceEpoch() + lifetimeSec;
+    const QByteArray payload = username.toUtf8().toBase64(base64Url) + '.' + QByteArray::number(expiry) + '.'
+                               + accountTag.toBase64(base64Url);
+    return QString::fromLatin1(payload + '.' + signature(payload).toBase64(base64Url));
+}
+
+QString SessionTokens::verify(const QString &token, QByteArray *accountTag) const
+{
+    const QByteArray bytes = token.toLatin1();
+    const qsizetype signatureStart = bytes.lastIndexOf('.');
+    const qsizetype tagStart = bytes.lastIndexOf('.', signatureStart - 1);
+    const qsizetype expiryStart = bytes.lastIndexOf('.', tagStart - 1);
+    if (signatureStart <= 0 || tagStart <= 0 || expiryStart <= 0) {
+        return QString();
+    }
+
+    const QByteArray payload = bytes.left(signatureStart);
+    const auto decoded = QByteArray::fromBase64Encoding(bytes.mid(signatureStart + 1), base64Url);
+    if (!decoded || !PasswordHash::constantTimeEquals(*decoded, signature(payload))) {
+        return QString();
+    }
+
+    bool ok = false;
+    const qint64 expiry = bytes.mid(expiryStart + 1, tagStart - expiryStart - 1).toLongLong(&ok);
+    if (!ok || expiry < Clock::instance().now().toSecsSinceEpoch()) {
+        return QString();
+    }
+    if (accountTag) {
+        *accountTag = QByteArray::fromBase64(bytes.mid(tagStart + 1, signatureStart - tagStart - 1), base64Url);
+    }
+    return QString::fromUtf8(QByteArray::fromBase64(payload.left(expiryStart), base64Url));
+}
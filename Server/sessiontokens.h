@@ -0,0 +1,38 @@
+#ifndef SESSIONTOKENS_H
+#define SESSIONTOKENS_H
+
+#include <QByteArray>
+#include <QString>
+
+// Signed session tokens handed out after a successful login:
+//
+//   <base64url username>.<expiry, seconds since epoch>.<base64url account tag>.<base64url HMAC-SHA256>
+//
+// A token carries everything needed to check it, so verifying one is a
+// single HMAC with no password hash; that keeps a reconnect storm as cheap
+// as the reconnects themselves. The account tag is AccountStore's
+// credentialTag at login: once the account is dropped or its password
+// changes, the caller's tag no longer matches and the token is dead. The key
+// is kept in the given file so tokens survive a restart; deleting the file
+// revokes all of them.
+class SessionTokens
+{
+public:
+    explicit SessionTokens(const QString &keyPath);
+
+    void setLifetime(qint64 seconds) { lifetimeSec = seconds; }
+    qint64 lifetime() const { return lifetimeSec; }
+
+    QString issue(const QString &username, const QByteArray &accountTag) const;
+    // The username the token was issued to, with the account tag it carries;
+    // empty when it is malformed, forged or expired
+    QString verify(const QString &token, QByteArray *accountTag = nullptr) const;
+
+private:
+    QByteArray signature(const QByteArray &payload) const;
+
+    QByteArray key;
+    qint64 lifetimeSec = 12 * 3600; // A working day
+};
+
+#endif // SESSIONTOKENS_H
@@ -0,0 +1,75 @@
+#include "timesheetmodel.h"
+
+TimesheetModel::TimesheetModel(QObject *parent)
+    : KeyedTableModel<TimesheetStore::TimesheetRow>(parent)
+{
+}
+
+void TimesheetModel::setTimesheet(const QList<TimesheetStore::TimesheetRow> &rows)
+{
+    if (pointsOnly) {
+        // The columns change as well
+        pointsOnly = false;
+        resetRows(rows);
+        return;
+    }
+    setRows(rows);
+}
+
+void TimesheetModel::setPoints(const QJsonObject &points)
+{
+    QList<TimesheetStore::TimesheetRow> rows;
+    rows.reserve(points.size());
+    for (auto it = points.begin(); it != points.end(); ++it) {
+        TimesheetStore::TimesheetRow row;
+        row.username = it.key();
+        row.points = it.value().toInt();
+        rows.append(row);
+    }
+    pointsOnly = true;
+    resetRows(rows);
+}
+
+int TimesheetModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return pointsOnly ? 2 : 6;
+}
+
+QVariant TimesheetModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size() || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    const TimesheetStore::TimesheetRow &row = rows.at(index.row());
+    if (pointsOnly) {
+        return index.column() == 0 ? QVariant(row.username) : QVariant(QString::number(row.points));
+    }
+    switch (index.column()) {
+    case 0:
+        return row.username;
+    case 1:
+        return row.start.isValid() ? row.start.toString("hh:mm:ss") : QString("N/A");
+    case 2:
+        return row.end.isValid() ? row.end.toString("hh:mm:ss") : QString("N/A");
+    case 3:
+        return QString::number(row.bonus);
+    case 4:
+        return QString::number(row.minus);
+    case 5:
+        return QString::number(row.points);
+    }
+    return QVariant();
+}
+
+QVariant TimesheetModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    static const QStringList liveHeaders = {"Username", "Start", "End", "Bonus", "Minus", "Points"};
+    static const QStringList pointsHeaders = {"Username", "Points"};
+    return (pointsOnly ? pointsHeaders : liveHeaders).value(section);
+}
@@ -0,0 +1,28 @@
+#ifndef TIMESHEETMODEL_H
+#define TIMESHEETMODEL_H
+
+#include "keyedtablemodel.h"
+#include "timesheetstore.h"
+
+// The admin window's timesheet table. Today it shows the live sessions and
+// points from computeTimesheet, refreshed every second; for an earlier day
+// only the saved points are known.
+class TimesheetModel : public KeyedTableModel<TimesheetStore::TimesheetRow>
+{
+public:
+    explicit TimesheetModel(QObject *parent = nullptr);
+
+    // Live rows; only rows that changed since the last call are repainted
+    void setTimesheet(const QList<TimesheetStore::TimesheetRow> &rows);
+    // Saved points of a past day, {username: points}
+    void setPoints(const QJsonObject &points);
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    bool pointsOnly = false;
+};
+
+#endif // TIMESHEETMODEL_H
@@ -0,0 +1,259 @@
+#include "timesheetstore.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QLoggingCategory>
+#include <QSaveFile>
+
+Q_DECLARE_LOGGING_CATEGORY(serverCategory)
+
+static bool writeJsonObject(const QString &filePath, const QJsonObject &root, const char *caller,
+                            bool durable = false)
+{
+    if (!QDir().mkpath(QFileInfo(filePath).path())) {
+        qCWarning(serverCategory).nospace() << caller << ": Couldn't create the directory for " << filePath;
+        return false;
+    }
+
+    if (durable) {
+        // Written beside the old file and renamed over it once synced, so a
+        // crash mid-write leaves the previous file instead of a truncated one
+        QSaveFile file(filePath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qCWarning(serverCategory).nospace() << caller << ": Couldn't open the file for writing: " << file.errorString();
+            return false;
+        }
+        if (file.write(QJsonDocument(root).toJson(QJsonDocument::Indented)) == -1 || !file.commit()) {
+            qCWarning(serverCategory).nospace() << caller << ": Failed to write to the file: " << file.errorString();
+            return false;
+        }
+        return true;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qCWarning(serverCategory).nospace() << caller << ": Couldn't open the file for writing: " << file.errorString();
+        return false;
+    }
+    if (file.write(QJsonDocument(root).toJson(QJsonDocument::Indented)) == -1) {
+        qCWarning(serverCategory).nospace() << caller << ": Failed to write to the file: " << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+// Parses a whole JSON file into its root object; empty on any error
+static QJsonObject readJsonObject(const QString &filePath, const char *caller)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qCWarning(serverCategory).nospace() << caller << ": Couldn't open the file: " << file.errorString();
+        return QJsonObject();
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        qCWarning(serverCategory).nospace() << caller << ": JSON parse error: " << parseError.errorString();
+        return QJsonObject();
+    }
+    return doc.object();
+}
+
+TimesheetStore::TimesheetStore(const QString &baseDir)
+    : base(baseDir)
+{
+}
+
+QString TimesheetStore::accountFilePath() const
+{
+    return base + "/account/account.json";
+}
+
+QString TimesheetStore::profilesFilePath() const
+{
+    return base + "/account/profiles.json";
+}
+
+QString TimesheetStore::statusFilePath(const QDate &date) const
+{
+    return base + "/status/" + date.toString("yyyy-MM-dd") + "/status.json";
+}
+
+QString TimesheetStore::pointsFilePath(const QDate &date) const
+{
+    return base + "/points/" + date.toString("yyyy-MM-dd") + "_points.json";
+}
+
+QJsonObject TimesheetStore::loadAccounts() const
+{
+    return readJsonObject(accountFilePath(), "loadAccounts");
+}
+
+bool TimesheetStore::saveAccounts(const QJsonObject &accounts) const
+{
+    return writeJsonObject(accountFilePath(), accounts, "saveAccounts", true);
+}
+
+QJsonObject TimesheetStore::loadProfiles() const
+{
+    return readJsonObject(profilesFilePath(), "loadProfiles");
+}
+
+bool TimesheetStore::saveProfiles(const QJsonObject &profiles) const
+{
+    return writeJsonObject(profilesFilePath(), profiles, "saveProfiles", true);
+}
+
+QJsonArray TimesheetStore::loadStatusEvents(const QDate &date) const
+{
+    return readJsonObject(statusFilePath(date), "loadStatusEvents").value("users").toArray();
+}
+
+bool TimesheetStore::saveStatusEvents(const QDate &date, const QJsonArray &events) const
+{
+    QJsonObject rootObj;
+    rootObj["users"] = events;
+    return writeJsonObject(statusFilePath(date), rootObj, "saveStatusEvents");
+}
+
+bool TimesheetStore::appendStatusEvent(const QDate &date, const QString &username,
+                                       const QString &status, const QString &time) const
+{
+    const QString filePath = statusFilePath(date);
+    const QString dirPath = QFileInfo(filePath).path();
+    if (!QDir().mkpath(dirPath)) {
+        qCWarning(serverCategory) << "appendStatusEvent: Couldn't create the directory:" << dirPath;
+        return false;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Text)) {
+        qCWarning(serverCategory) << "appendStatusEvent: Couldn't open the file:" << file.errorString();
+        return false;
+    }
+
+    QJsonObject rootObj;
+    QJsonArray users;
+    if (file.size() > 0) {
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+        if (parseError.error != QJsonParseError::NoError) {
+            qCWarning(serverCategory) << "appendStatusEvent: JSON parse error:" << parseError.errorString();
+            return false;
+        }
+        rootObj = doc.object();
+        users = rootObj.value("users").toArray();
+    }
+
+    QJsonObject userObj;
+    userObj["username"] = username;
+    userObj["status"] = status;
+    userObj["time"] = time;
+    users.append(userObj);
+    rootObj["users"] = users;
+
+    file.resize(0);
+    if (file.write(QJsonDocument(rootObj).toJson(QJsonDocument::Indented)) == -1) {
+        qCWarning(serverCategory) << "appendStatusEvent: Failed to write to the file:" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QJsonObject TimesheetStore::loadPoints(const QDate &date) const
+{
+    return readJsonObject(pointsFilePath(date), "loadPoints");
+}
+
+bool TimesheetStore::savePoints(const QDate &date, const QJsonObject &points) const
+{
+    return writeJsonObject(pointsFilePath(date), points, "savePoints");
+}
+
+QMap<QString, QJsonObject> TimesheetStore::latestStatusAt(const QJsonArray &events, const QTime &time,
+                                                          bool inclusive)
+{
+    QMap<QString, QJsonObject> latest;
+    QHash<QString, QTime> latestTimes;
+
+    for (const QJsonValue &userValue : events) {
+        const QJsonObject userObj = userValue.toObject();
+        const QTime userTime = QTime::fromString(userObj.value("time").toString(), "hh:mm:ss");
+        if (!userTime.isValid() || userTime > time || (!inclusive && userTime == time)) {
+            continue;
+        }
+
+        // On equal times the first event in the file wins
+        const QString username = userObj.value("username").toString();
+        auto it = latestTimes.find(username);
+        if (it == latestTimes.end() || *it < userTime) {
+            latestTimes.insert(username, userTime);
+            latest.insert(username, userObj);
+        }
+    }
+    return latest;
+}
+
+QList<TimesheetStore::TimesheetRow> TimesheetStore::computeTimesheet(const QJsonArray &accounts,
+                                                                     const QJsonArray &events,
+                                                                     const QTime &now,
+                                                                     const ScoringRules &rules)
+{
+    struct Session {
+        QTime start;
+        QTime end;
+        bool isOnline = false;
+        ScoringRules::Day day;
+    };
+    auto secondOf = [](const QTime &time) { return time.msecsSinceStartOfDay() / 1000; };
+
+    // One pass over the events instead of one pass per account
+    QHash<QString, Session> sessions;
+    sessions.reserve(accounts.size());
+    for (const QJsonValue &userValue : events) {
+        const QJsonObject userObj = userValue.toObject();
+        const QString status = userObj.value("status").toString();
+        const QTime time = QTime::fromString(userObj.value("time").toString(), "hh:mm:ss");
+        Session &session = sessions[userObj.value("username").toString()];
+
+        if (status == "online") {
+            if (!session.isOnline) {
+                session.start = time;
+                session.isOnline = true;
+            }
+        } else if (status == "offline" && session.isOnline) {
+            session.end = time;
+            session.isOnline = false;
+            if (session.start.isValid() && session.end.isValid()) {
+                rules.addSession(session.day, secondOf(session.start), secondOf(session.end));
+            }
+        }
+    }
+
+    QList<TimesheetRow> rows;
+    rows.reserve(accounts.size());
+    for (const QJsonValue &accountValue : accounts) {
+        TimesheetRow row;
+        row.username = accountValue.toObject().value("username").toString();
+
+        Session session = sessions.value(row.username);
+        if (session.isOnline) {
+            session.end = now;
+            if (session.start.isValid() && session.end.isValid()) {
+                rules.addSession(session.day, secondOf(session.start), secondOf(session.end));
+            }
+        }
+        row.start = session.start;
+        row.end = session.end;
+        const ScoringRules::Score score = rules.score(session.day);
+        row.bonus = score.bonus;
+        row.minus = score.minus;
+        row.points = score.points;
+        rows.append(row);
+    }
+    return rows;
+}
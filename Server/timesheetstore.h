@@ -0,0 +1,75 @@
+#ifndef TIMESHEETSTORE_H
+#define TIMESHEETSTORE_H
+
+#include <QDate>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QTime>
+#include "scoringrules.h"
+
+// The account, status and points files under the server's base directory,
+// and the queries the server runs over them. No widgets or sockets are
+// involved, so the bench tool links this directly and measures exactly the
+// code the server executes.
+//
+//   account/account.json          {"users": [{username, password}]}
+//   account/profiles.json         {"profiles": {username: info}}
+//   status/<date>/status.json     {"users": [{username, status, time}]}
+//   points/<date>_points.json     {username: points}
+class TimesheetStore
+{
+public:
+    struct TimesheetRow {
+        QString username;
+        QTime start;   // Start of the last session
+        QTime end;     // End of the last closed session, or now when still online
+        int bonus = 0;
+        int minus = 0;
+        qint64 points = 0;
+
+        bool operator==(const TimesheetRow &other) const
+        {
+            return username == other.username && start == other.start && end == other.end
+                   && bonus == other.bonus && minus == other.minus && points == other.points;
+        }
+    };
+
+    explicit TimesheetStore(const QString &baseDir);
+
+    QString baseDir() const { return base; }
+    QString accountFilePath() const;
+    QString profilesFilePath() const;
+    QString statusFilePath(const QDate &date) const;
+    QString pointsFilePath(const QDate &date) const;
+
+    QJsonObject loadAccounts() const;
+    bool saveAccounts(const QJsonObject &accounts) const;
+    QJsonObject loadProfiles() const;
+    bool saveProfiles(const QJsonObject &profiles) const;
+    QJsonArray loadStatusEvents(const QDate &date) const;
+    // Replaces the whole day; events are expected in time order
+    bool saveStatusEvents(const QDate &date, const QJsonArray &events) const;
+    bool appendStatusEvent(const QDate &date, const QString &username,
+                           const QString &status, const QString &time) const;
+    QJsonObject loadPoints(const QDate &date) const;
+    bool savePoints(const QDate &date, const QJsonObject &points) const;
+
+    // Latest event of each user at or before time (strictly before unless
+    // inclusive), keyed by username
+    static QMap<QString, QJsonObject> latestStatusAt(const QJsonArray &events, const QTime &time,
+                                                     bool inclusive);
+
+    // Sessions and points of every account from the day's events, scored by
+    // the rules; sessions still open are closed at now
+    static QList<TimesheetRow> computeTimesheet(const QJsonArray &accounts, const QJsonArray &events,
+                                                const QTime &now,
+                                                const ScoringRules &rules = ScoringRules::standard());
+
+private:
+    QString base;
+};
+
+#endif // TIMESHEETSTORE_H
@@ -0,0 +1,99 @@
+#include "tracer.h"
+#include "asyncfilesink.h"
+#include "clock.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <memory>
+
+std::atomic<bool> Tracer::enabled{false};
+
+static QMutex controlMutex;
+static std::shared_ptr<AsyncFileSink> activeSink;
+static std::atomic<quint64> session{0};
+static thread_local quint64 namedInSession = 0;
+
+static const QElapsedTimer &epoch()
+{
+    static QElapsedTimer timer = []() {
+        QElapsedTimer started;
+        started.start();
+        return started;
+    }();
+    return timer;
+}
+
+QString Tracer::start(const QString &logDir)
+{
+    QMutexLocker locker(&controlMutex);
+    if (enabled.load()) {
+        return QString();
+    }
+
+    const QString baseName = "trace-" + Clock::instance().now().toString("hhmmss");
+    // Large events files are fine for the viewers, keep one session in one file
+    auto sink = std::make_shared<AsyncFileSink>(logDir, baseName, "json", 0, 0, 65536);
+    sink->setFileHeader("[");
+    sink->start();
+
+    std::atomic_store(&activeSink, sink);
+    session.fetch_add(1);
+    enabled.store(true);
+    return logDir + "/" + baseName;
+}
+
+void Tracer::stop()
+{
+    QMutexLocker locker(&controlMutex);
+    enabled.store(false);
+    // Spans still in flight hold their own reference, the sink drains and
+    // closes its file when the last one is released
+    std::atomic_store(&activeSink, std::shared_ptr<AsyncFileSink>());
+}
+
+qint64 Tracer::nowUs()
+{
+    return epoch().nsecsElapsed() / 1000;
+}
+
+void Tracer::writeComplete(const char *name, const char *category, qint64 startUs, qint64 durationUs)
+{
+    const std::shared_ptr<AsyncFileSink> sink = std::atomic_load(&activeSink);
+    if (!sink) {
+        return;
+    }
+
+    const QByteArray tid = QByteArray::number(quintptr(QThread::currentThreadId()));
+
+    // Name each thread once per session so the viewer shows "http", "watchdog", ...
+    const quint64 currentSession = session.load(std::memory_order_relaxed);
+    if (namedInSession != currentSession) {
+        namedInSession = currentSession;
+        QString threadName = QThread::currentThread()->objectName();
+        if (threadName.isEmpty()) {
+            const bool isMain = QCoreApplication::instance()
+                                && QThread::currentThread() == QCoreApplication::instance()->thread();
+            threadName = isMain ? QString("main") : "thread-" + QString::fromLatin1(tid);
+        }
+        sink->append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid
+                     + ",\"args\":{\"name\":\"" + threadName.toUtf8() + "\"}},");
+    }
+
+    QByteArray event;
+    event.reserve(128);
+    event += "{\"name\":\"";
+    event += name;
+    event += "\",\"cat\":\"";
+    event += category;
+    event += "\",\"ph\":\"X\",\"ts\":";
+    event += QByteArray::number(startUs);
+    event += ",\"dur\":";
+    event += QByteArray::number(durationUs);
+    event += ",\"pid\":1,\"tid\":";
+    event += tid;
+    event += "},";
+    sink->append(std::move(event));
+}
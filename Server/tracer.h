@@ -0,0 +1,50 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <atomic>
+
+// Chrome/Perfetto trace-event output (JSON array format, open it in
+// chrome://tracing or ui.perfetto.dev). Tracing is switched on at runtime
+// with --trace or POST /trace/start and writes logs/trace-<time>-<date>.json
+// through an AsyncFileSink. While it is off a TraceSpan costs one relaxed
+// atomic load, so spans stay compiled into release builds.
+class Tracer
+{
+public:
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Returns the path prefix of the new trace file, empty if already tracing
+    static QString start(const QString &logDir);
+    static void stop();
+
+    static qint64 nowUs();
+    static void writeComplete(const char *name, const char *category, qint64 startUs, qint64 durationUs);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Records one complete ("X") event covering its own lifetime
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name, const char *category = "server")
+        : name(name), category(category), startUs(Tracer::isEnabled() ? Tracer::nowUs() : -1) {}
+    ~TraceSpan()
+    {
+        if (startUs >= 0) {
+            Tracer::writeComplete(name, category, startUs, Tracer::nowUs() - startUs);
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *name;
+    const char *category;
+    qint64 startUs;
+};
+
+#endif // TRACER_H
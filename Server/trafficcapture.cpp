@@ -0,0 +1,134 @@
+#include "trafficcapture.h"
+#include "asyncfilesink.h"
+#include "clock.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <cctype>
+#include <memory>
+
+std::atomic<bool> TrafficCapture::enabled{false};
+
+static QMutex controlMutex;
+static std::shared_ptr<AsyncFileSink> activeSink;
+static std::atomic<qint64> sessionStartNs{0};
+
+static const QElapsedTimer &epoch()
+{
+    static QElapsedTimer timer = []() {
+        QElapsedTimer started;
+        started.start();
+        return started;
+    }();
+    return timer;
+}
+
+// loginRequest carries data.password, Register carries Data.password, and
+// requests after a login carry a session token that is as good as a password.
+// A read can hold several frames, half of one or trailing garbage, so this is
+// a byte scan rather than a JSON parse: every "password" or "token" string
+// value is cut to "" wherever it appears, and a string still open at the end
+// of the read is cut to the end.
+static QByteArray redactSecrets(const QByteArray &payload)
+{
+    // A read that does not start a frame continues one split across reads;
+    // it may be the rest of a secret, so only its length is kept
+    const QByteArray trimmed = payload.trimmed();
+    if (!trimmed.isEmpty() && trimmed.front() != '{') {
+        return QByteArray(payload.size(), ' ');
+    }
+    if (!payload.contains("\"password\"") && !payload.contains("\"token\"")) {
+        return payload;
+    }
+
+    QByteArray redacted;
+    redacted.reserve(payload.size());
+    qsizetype copied = 0;
+    for (qsizetype pos = 0; pos < payload.size(); ++pos) {
+        if (payload.at(pos) != '"') {
+            continue;
+        }
+        qsizetype i = -1;
+        for (const char *key : {"\"password\"", "\"token\""}) {
+            const qsizetype keyLength = qsizetype(qstrlen(key));
+            if (payload.mid(pos, keyLength) == key) {
+                i = pos + keyLength;
+                break;
+            }
+        }
+        if (i < 0) {
+            continue;
+        }
+        while (i < payload.size() && std::isspace(static_cast<unsigned char>(payload.at(i)))) {
+            ++i;
+        }
+        if (i >= payload.size() || payload.at(i) != ':') {
+            continue;
+        }
+        ++i;
+        while (i < payload.size() && std::isspace(static_cast<unsigned char>(payload.at(i)))) {
+            ++i;
+        }
+        if (i >= payload.size() || payload.at(i) != '"') {
+            continue;
+        }
+
+        // Skip to the closing quote, past escaped ones
+        qsizetype end = i + 1;
+        while (end < payload.size() && payload.at(end) != '"') {
+            end += payload.at(end) == '\\' ? 2 : 1;
+        }
+        redacted += payload.mid(copied, i + 1 - copied);
+        redacted += '"';
+        copied = qMin(end + 1, payload.size());
+        pos = copied - 1;
+    }
+    redacted += payload.mid(copied);
+    return redacted;
+}
+
+QString TrafficCapture::start(const QString &logDir)
+{
+    QMutexLocker locker(&controlMutex);
+    if (enabled.load()) {
+        return QString();
+    }
+
+    const QString baseName = "capture-" + Clock::instance().now().toString("hhmmss");
+    // One session per file like traces; a new file only starts at midnight
+    auto sink = std::make_shared<AsyncFileSink>(logDir, baseName, "tcap", 0, 0, 65536);
+    sink->setFileHeader("# tcap 1 started " + Clock::instance().now().toString(Qt::ISODateWithMs).toUtf8());
+    sink->start();
+
+    sessionStartNs.store(epoch().nsecsElapsed());
+    std::atomic_store(&activeSink, sink);
+    enabled.store(true);
+    return logDir + "/" + baseName;
+}
+
+void TrafficCapture::stop()
+{
+    QMutexLocker locker(&controlMutex);
+    enabled.store(false);
+    std::atomic_store(&activeSink, std::shared_ptr<AsyncFileSink>());
+}
+
+void TrafficCapture::write(quint64 connectionId, Event event, const QByteArray &payload)
+{
+    const std::shared_ptr<AsyncFileSink> sink = std::atomic_load(&activeSink);
+    if (!sink) {
+        return;
+    }
+
+    QByteArray line;
+    line.reserve(48 + payload.size() * 4 / 3);
+    line += QByteArray::number((epoch().nsecsElapsed() - sessionStartNs.load(std::memory_order_relaxed)) / 1000);
+    line += '\t';
+    line += QByteArray::number(connectionId);
+    line += '\t';
+    line += char(event);
+    line += '\t';
+    line += (event == Data ? redactSecrets(payload) : payload).toBase64();
+    sink->append(std::move(line));
+}
@@ -0,0 +1,42 @@
+#ifndef TRAFFICCAPTURE_H
+#define TRAFFICCAPTURE_H
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+
+// Records inbound TCP traffic for replay with trackload --replay. Switched on
+// with --capture or POST /capture/start and written to
+// logs/capture-<time>-<date>.tcap through an AsyncFileSink, one line per event:
+//
+//   <microseconds since start> TAB <connection id> TAB <O|D|C> TAB <base64 payload>
+//
+// O opens a connection (payload: peer address), D is one socket read as the
+// server saw it, C closes the connection. Passwords and session tokens are
+// blanked before a read is recorded, and a read that continues a split frame
+// is kept only as blanks of the same length. While capture is off record()
+// is one relaxed atomic load.
+class TrafficCapture
+{
+public:
+    enum Event : char { Open = 'O', Data = 'D', Close = 'C' };
+
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Returns the path prefix of the new capture file, empty if already capturing
+    static QString start(const QString &logDir);
+    static void stop();
+
+    static void record(quint64 connectionId, Event event, const QByteArray &payload = QByteArray())
+    {
+        if (isEnabled()) {
+            write(connectionId, event, payload);
+        }
+    }
+
+private:
+    static void write(quint64 connectionId, Event event, const QByteArray &payload);
+    static std::atomic<bool> enabled;
+};
+
+#endif // TRAFFICCAPTURE_H
@@ -0,0 +1,22 @@
+QT += core gui network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Points are computed with the server's own timesheet code
+INCLUDEPATH += ../../Server
+
+SOURCES += \
+    main.cpp \
+    workforce.cpp \
+    ../../Server/accountstore.cpp \
+    ../../Server/passwordhash.cpp \
+    ../../Server/scoringrules.cpp \
+    ../../Server/timesheetstore.cpp
+
+HEADERS += \
+    workforce.h \
+    ../../Server/accountstore.h \
+    ../../Server/passwordhash.h \
+    ../../Server/scoringrules.h \
+    ../../Server/timesheetstore.h
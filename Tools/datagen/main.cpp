@@ -0,0 +1,178 @@
+#include "accountstore.h"
+#include "passwordhash.h"
+#include "timesheetstore.h"
+#include "workforce.h"
+#include <QColor>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QRandomGenerator>
+#include <QTextStream>
+
+// TimesheetStore logs through the server's category
+Q_LOGGING_CATEGORY(serverCategory, "server")
+
+// A flat coloured JPEG per user, enough for the avatar, thumbnail and quota paths
+static bool writeAvatar(QRandomGenerator &rng, const QString &path, int size)
+{
+    QImage image(size, size, QImage::Format_RGB32);
+    image.fill(QColor::fromHsv(rng.bounded(360), 120, 220));
+    return image.save(path, "JPG", 85);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("datagen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates a server data directory: accounts with profiles, "
+                                     "status histories, points files and placeholder media.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"out", "Directory to generate into (the server's application directory).", "dir"},
+        {"users", "Number of accounts.", "n", "100"},
+        {"days", "Number of days of status history.", "n", "5"},
+        {"end-date", "Last generated day, yyyy-MM-dd; pass today's date for a directory the server "
+                     "shows as current.", "date", "2024-01-31"},
+        {"weekends", "Also generate Saturdays and Sundays."},
+        {"absence-rate", "Chance an employee does not come in on a day.", "rate", "0.05"},
+        {"storm-probability", "Chance of a reconnect storm on a day.", "p", "0.3"},
+        {"storm-share", "Share of online clients that drop in a storm.", "p", "0.6"},
+        {"user-prefix", "Usernames are <prefix>1..<prefix>N.", "prefix", "loaduser"},
+        {"password", "Password of every generated account.", "password", "loadtest"},
+        {"hash-passwords", "Store salted hashes as the server does instead of plaintext "
+                           "(the server hashes plaintext in the background at startup; hashing takes time per user)."},
+        {"avatars", "Write a placeholder avatar of this size in pixels for every user.", "px"},
+        {"intro-template", "Copy this video as every user's intro.", "file"},
+        {"intro-bytes", "Without a template, write filler intros of this size.", "bytes"},
+        {"seed", "Random seed; the same seed gives the same files.", "seed", "1"},
+    });
+    parser.process(app);
+
+    if (!parser.isSet("out")) {
+        QTextStream(stderr) << "datagen: --out is required\n";
+        return 2;
+    }
+
+    WorkforceGenerator::Options options;
+    options.users = parser.value("users").toInt();
+    const int days = parser.value("days").toInt();
+    // A fixed default, so the same options and seed give the same files on any day
+    const QDate endDate = QDate::fromString(parser.value("end-date"), "yyyy-MM-dd");
+    const bool weekends = parser.isSet("weekends");
+    options.absenceRate = parser.value("absence-rate").toDouble();
+    options.stormProbability = parser.value("storm-probability").toDouble();
+    options.stormShare = parser.value("storm-share").toDouble();
+    options.userPrefix = parser.value("user-prefix");
+    options.password = parser.value("password");
+    if (options.users <= 0 || days <= 0 || !endDate.isValid()) {
+        QTextStream(stderr) << "datagen: --users and --days must be positive and --end-date valid\n";
+        return 2;
+    }
+
+    WorkforceGenerator generator(options, parser.value("seed").toUInt());
+    QRandomGenerator &rng = generator.random();
+    TimesheetStore store(parser.value("out"));
+    QTextStream out(stdout);
+
+    // Credentials and profiles go to separate files, as the server keeps them
+    QJsonObject accounts = generator.accounts();
+    if (parser.isSet("hash-passwords")) {
+        QJsonArray users = accounts.value("users").toArray();
+        for (int i = 0; i < users.size(); ++i) {
+            QJsonObject account = users.at(i).toObject();
+            account["password"] = PasswordHash::create(account.value("password").toString());
+            users[i] = account;
+        }
+        accounts["users"] = users;
+    }
+    QFile::remove(store.profilesFilePath());
+    if (!AccountStore(store.baseDir()).saveAccounts(accounts)) {
+        return 1;
+    }
+    out << "accounts: " << options.users << " -> " << store.accountFilePath() << ", "
+        << store.profilesFilePath() << "\n";
+
+    // Oldest day first so the random stream, and with it the output, only
+    // depends on the options
+    QList<QDate> dates;
+    for (QDate date = endDate; dates.size() < days; date = date.addDays(-1)) {
+        if (weekends || date.dayOfWeek() <= 5) {
+            dates.prepend(date);
+        }
+    }
+
+    const QJsonArray accountsArray = accounts.value("users").toArray();
+    qint64 totalEvents = 0;
+    for (const QDate &date : dates) {
+        const QJsonArray events = generator.day();
+        if (!store.saveStatusEvents(date, events)) {
+            return 1;
+        }
+
+        // Points as showTimesheet computes them; every session is closed by day end
+        QJsonObject points;
+        const auto rows = TimesheetStore::computeTimesheet(accountsArray, events, QTime(23, 59, 59));
+        for (const auto &row : rows) {
+            points[row.username] = int(row.points);
+        }
+        if (!store.savePoints(date, points)) {
+            return 1;
+        }
+
+        totalEvents += events.size();
+        out << date.toString("yyyy-MM-dd") << ": " << events.size() << " status events\n";
+    }
+
+    const bool writeMedia = parser.isSet("avatars") || parser.isSet("intro-template") || parser.isSet("intro-bytes");
+    if (writeMedia) {
+        QDir base(store.baseDir());
+        base.mkpath("avatar");
+        base.mkpath("intro");
+
+        QByteArray introFiller;
+        if (!parser.isSet("intro-template") && parser.isSet("intro-bytes")) {
+            introFiller.resize(parser.value("intro-bytes").toLongLong());
+            for (char &byte : introFiller) {
+                byte = char(rng.bounded(256));
+            }
+        }
+
+        for (int i = 1; i <= options.users; ++i) {
+            const QString username = options.userPrefix + QString::number(i);
+            if (parser.isSet("avatars")
+                && !writeAvatar(rng, base.filePath("avatar/" + username + ".jpg"), parser.value("avatars").toInt())) {
+                QTextStream(stderr) << "datagen: cannot write avatar for " << username << "\n";
+                return 1;
+            }
+
+            const QString introPath = base.filePath("intro/" + username + ".mp4");
+            QFile::remove(introPath);
+            if (parser.isSet("intro-template")) {
+                if (!QFile::copy(parser.value("intro-template"), introPath)) {
+                    QTextStream(stderr) << "datagen: cannot copy intro for " << username << "\n";
+                    return 1;
+                }
+            } else if (!introFiller.isEmpty()) {
+                QFile intro(introPath);
+                if (!intro.open(QIODevice::WriteOnly) || intro.write(introFiller) != introFiller.size()) {
+                    QTextStream(stderr) << "datagen: cannot write intro for " << username << "\n";
+                    return 1;
+                }
+            }
+        }
+
+        // The server rebuilds its quota ledger from disk when the file is missing
+        QFile::remove(base.filePath("data/quota.json"));
+        out << "media: " << options.users << " users\n";
+    }
+
+    out << "total: " << dates.size() << " days, " << totalEvents << " status events\n";
+    return 0;
+}
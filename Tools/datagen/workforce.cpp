@@ -0,0 +1,149 @@
+#include "workforce.h"
+#include <QDate>
+#include <QTime>
+#include <QtMath>
+#include <algorithm>
+#include <iterator>
+
+static const char *firstNames[] = {"An", "Binh", "Chi", "Dung", "Giang", "Ha", "Hoa", "Khanh",
+                                   "Lan", "Linh", "Minh", "Nam", "Ngoc", "Phuong", "Quang", "Son",
+                                   "Thao", "Trang", "Tuan", "Vy"};
+static const char *lastNames[] = {"Nguyen", "Tran", "Le", "Pham", "Hoang", "Huynh", "Phan", "Vu",
+                                  "Vo", "Dang", "Bui", "Do", "Ho", "Ngo", "Duong", "Ly"};
+
+// Working patterns, in seconds since midnight
+struct Shift {
+    int start;
+    int end;
+    bool lunchBreak;
+};
+static const Shift shifts[] = {
+    {7 * 3600, 15 * 3600, false},               // Morning
+    {9 * 3600, 17 * 3600 + 1800, true},         // Office hours
+    {13 * 3600, 21 * 3600 + 1800, false},       // Late
+};
+
+struct Event {
+    int second;
+    int user;
+    bool online;
+};
+
+static double gaussian(QRandomGenerator &rng, double mean, double stddev)
+{
+    // Box-Muller
+    const double u1 = 1.0 - rng.generateDouble();
+    const double u2 = rng.generateDouble();
+    return mean + stddev * qSqrt(-2.0 * qLn(u1)) * qCos(2.0 * M_PI * u2);
+}
+
+static int clampSecond(double second)
+{
+    return qBound(0, int(second), 24 * 3600 - 1);
+}
+
+WorkforceGenerator::WorkforceGenerator(const Options &options, quint32 seed)
+    : options(options),
+    rng(seed)
+{
+}
+
+QJsonObject WorkforceGenerator::accounts()
+{
+    QJsonArray users;
+    for (int i = 1; i <= options.users; ++i) {
+        const QString username = options.userPrefix + QString::number(i);
+        const QString first = firstNames[rng.bounded(int(std::size(firstNames)))];
+        const QString last = lastNames[rng.bounded(int(std::size(lastNames)))];
+        const QDate birthday = QDate(1965, 1, 1).addDays(rng.bounded(365 * 40));
+
+        QJsonObject info;
+        info["Fullname"] = last + " " + first;
+        info["Birthday"] = birthday.toString("dd/MM/yyyy");
+        info["Sex"] = rng.bounded(2) ? "Male" : "Female";
+        info["Email"] = username + "@example.com";
+        info["Tel"] = QString("09%1").arg(rng.bounded(100000000), 8, 10, QChar('0'));
+
+        QJsonObject account;
+        account["username"] = username;
+        account["password"] = options.password;
+        account["info"] = info;
+        users.append(account);
+
+        // A quarter morning, half office hours, a quarter late
+        const int draw = rng.bounded(4);
+        userShifts.append(draw == 0 ? 0 : draw == 3 ? 2 : 1);
+    }
+
+    QJsonObject root;
+    root["users"] = users;
+    return root;
+}
+
+// One day of presence: a session per shift with jittered arrival and
+// departure, an optional lunch break, and sometimes a reconnect storm where
+// many clients drop and come back within seconds (a network blip at the site)
+QJsonArray WorkforceGenerator::day()
+{
+    QList<Event> events;
+    QList<QList<QPair<int, int>>> sessions(options.users);
+
+    for (int user = 0; user < options.users; ++user) {
+        if (rng.generateDouble() < options.absenceRate) {
+            continue;
+        }
+        const Shift &shift = shifts[userShifts.at(user)];
+        const int arrive = clampSecond(gaussian(rng, shift.start - 300, 600));
+        const int leave = clampSecond(gaussian(rng, shift.end + 300, 900));
+        if (leave <= arrive) {
+            continue;
+        }
+
+        if (shift.lunchBreak && rng.generateDouble() < 0.7) {
+            const int lunchOut = clampSecond(12 * 3600 + rng.bounded(1800));
+            const int lunchIn = clampSecond(lunchOut + 1800 + rng.bounded(1800));
+            if (arrive < lunchOut && lunchIn < leave) {
+                sessions[user] = {{arrive, lunchOut}, {lunchIn, leave}};
+                continue;
+            }
+        }
+        sessions[user] = {{arrive, leave}};
+    }
+
+    if (rng.generateDouble() < options.stormProbability) {
+        const int stormAt = 8 * 3600 + rng.bounded(9 * 3600);
+        for (auto &userSessions : sessions) {
+            for (int i = 0; i < userSessions.size(); ++i) {
+                const QPair<int, int> session = userSessions.at(i);
+                if (session.first + 120 < stormAt && stormAt + 120 < session.second
+                    && rng.generateDouble() < options.stormShare) {
+                    const int dropAt = stormAt + rng.bounded(5);
+                    const int backAt = dropAt + 5 + rng.bounded(85);
+                    userSessions[i] = {session.first, dropAt};
+                    userSessions.insert(i + 1, {backAt, session.second});
+                    break;
+                }
+            }
+        }
+    }
+
+    for (int user = 0; user < options.users; ++user) {
+        for (const auto &session : sessions.at(user)) {
+            events.append({session.first, user, true});
+            events.append({session.second, user, false});
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const Event &a, const Event &b) {
+        return a.second < b.second;
+    });
+
+    QJsonArray day;
+    for (const Event &event : events) {
+        QJsonObject entry;
+        entry["username"] = options.userPrefix + QString::number(event.user + 1);
+        entry["status"] = event.online ? "online" : "offline";
+        entry["time"] = QTime(0, 0).addSecs(event.second).toString("hh:mm:ss");
+        day.append(entry);
+    }
+    return day;
+}
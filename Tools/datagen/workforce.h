@@ -0,0 +1,41 @@
+#ifndef WORKFORCE_H
+#define WORKFORCE_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QRandomGenerator>
+#include <QString>
+
+// Synthetic employees and their daily presence. Everything comes from one
+// seeded random stream, so the same options and seed give the same accounts
+// and days. Used by datagen to write data directories and by serverbench to
+// drive its day simulation.
+class WorkforceGenerator
+{
+public:
+    struct Options {
+        int users = 100;
+        double absenceRate = 0.05;
+        double stormProbability = 0.3;
+        double stormShare = 0.6;
+        QString userPrefix = "loaduser";
+        QString password = "loadtest";
+    };
+
+    WorkforceGenerator(const Options &options, quint32 seed);
+
+    // account.json content; call once, before the first day()
+    QJsonObject accounts();
+    // The next day's status events in time order
+    QJsonArray day();
+
+    QRandomGenerator &random() { return rng; }
+
+private:
+    Options options;
+    QRandomGenerator rng;
+    QList<int> userShifts;
+};
+
+#endif // WORKFORCE_H
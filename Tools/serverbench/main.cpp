@@ -0,0 +1,417 @@
+#include "accountstore.h"
+#include "accounttransfer.h"
+#include "asyncfilesink.h"
+#include "clock.h"
+#include "passwordhash.h"
+#include "rollupstore.h"
+#include "scoringrules.h"
+#include "timesheetstore.h"
+#include "workforce.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <algorithm>
+
+// TimesheetStore logs through the server's category
+Q_LOGGING_CATEGORY(serverCategory, "server")
+
+struct BenchResult {
+    QString name;
+    int users = 0;
+    int events = 0;
+    int iterations = 0;
+    double meanUs = 0;
+    double medianUs = 0;
+    double minUs = 0;
+};
+
+static BenchResult summarize(const QString &name, QList<double> samples)
+{
+    BenchResult result;
+    result.name = name;
+    result.iterations = samples.size();
+    if (samples.isEmpty()) {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    result.minUs = samples.first();
+    result.medianUs = samples.at(samples.size() / 2);
+    double sum = 0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    result.meanUs = sum / samples.size();
+    return result;
+}
+
+struct SimulationOptions {
+    int days = 30;
+    int users = 200;
+    int timesheetIntervalSec = 60;
+    QDate startDate;
+    quint32 seed = 1;
+    ScoringRules rules;
+};
+
+// A site with every kind of rule, scored after the simulation to time a
+// rules change over the whole simulated period
+static ScoringRules changedRules()
+{
+    ScoringRules rules;
+    rules.compile(QJsonDocument::fromJson(R"({
+        "pointsPerSecond": 5,
+        "rates": [{"from": "18:00", "to": "22:00", "multiplier": 1.5},
+                  {"from": "22:00", "to": "06:00", "multiplier": 2}],
+        "overtime": [{"afterHours": 8, "multiplier": 1.5}, {"afterHours": 10, "multiplier": 2}],
+        "late": {"after": "09:00", "pointsPerMinute": 10, "max": 600},
+        "breaks": [{"afterHours": 6, "minutes": 30}, {"afterHours": 9, "minutes": 45}]
+    })").object());
+    return rules;
+}
+
+// Replays generated days against the store on a stopped virtual clock that
+// jumps from one event to the next: every status event is appended the way
+// saveUserStatus does it, the timesheet and points are recomputed every
+// timesheet interval the way the server's timer does, and an event log goes
+// through an AsyncFileSink so its files roll over at each virtual midnight.
+// A month of activity takes seconds instead of a month.
+static QList<BenchResult> simulate(const TimesheetStore &store, const SimulationOptions &options)
+{
+    VirtualClock clock(QDateTime(options.startDate, QTime(0, 0)), 0.0);
+    Clock::setInstance(&clock);
+
+    WorkforceGenerator::Options workforce;
+    workforce.users = options.users;
+    WorkforceGenerator generator(workforce, options.seed);
+    AccountStore accountStore(store.baseDir());
+    accountStore.saveAccounts(generator.accounts());
+
+    AsyncFileSink eventLog(store.baseDir() + "/logs", "simulation", "log");
+    eventLog.start();
+
+    QList<double> appendSamples;
+    QList<double> timesheetSamples;
+    QList<double> rolloverSamples;
+    QList<double> finalizeSamples;
+    RollupStore rollupStore(store.baseDir());
+    QElapsedTimer wall;
+    wall.start();
+
+    auto runTimesheet = [&]() {
+        // Like showTimesheet, nothing to do before the day's first event
+        const QDate date = Clock::instance().today();
+        if (!QFile::exists(store.statusFilePath(date))) {
+            return;
+        }
+        QElapsedTimer timer;
+        timer.start();
+        const QJsonArray accounts = accountStore.accounts().value("users").toArray();
+        const auto rows = TimesheetStore::computeTimesheet(accounts, store.loadStatusEvents(date),
+                                                           Clock::instance().timeOfDay(), options.rules);
+        QJsonObject points;
+        for (const auto &row : rows) {
+            points[row.username] = int(row.points);
+        }
+        store.savePoints(date, points);
+        timesheetSamples.append(timer.nsecsElapsed() / 1000.0);
+    };
+
+    qint64 eventCount = 0;
+    for (int day = 0; day < options.days; ++day) {
+        const QDateTime midnight(options.startDate.addDays(day), QTime(0, 0));
+        const QDateTime nextMidnight = midnight.addDays(1);
+        QDateTime nextTimesheet = midnight;
+
+        // Crossing midnight rolls the log over; the day's first event creates its status file
+        QElapsedTimer rollover;
+        rollover.start();
+        clock.set(midnight);
+        eventLog.append("day " + midnight.date().toString("yyyy-MM-dd").toUtf8());
+        eventLog.flush();
+        rolloverSamples.append(rollover.nsecsElapsed() / 1000.0);
+
+        const QJsonArray events = generator.day();
+        for (const QJsonValue &value : events) {
+            const QJsonObject event = value.toObject();
+            const QDateTime at(midnight.date(), QTime::fromString(event.value("time").toString(), "hh:mm:ss"));
+            for (; nextTimesheet <= at; nextTimesheet = nextTimesheet.addSecs(options.timesheetIntervalSec)) {
+                clock.set(nextTimesheet);
+                runTimesheet();
+            }
+
+            clock.set(at);
+            const QString username = event.value("username").toString();
+            const QString status = event.value("status").toString();
+            QElapsedTimer timer;
+            timer.start();
+            store.appendStatusEvent(Clock::instance().today(), username, status,
+                                    Clock::instance().timeOfDay().toString("hh:mm:ss"));
+            appendSamples.append(timer.nsecsElapsed() / 1000.0);
+            eventLog.append(Clock::instance().now().toString(Qt::ISODate).toUtf8() + ' '
+                            + username.toUtf8() + ' ' + status.toUtf8());
+            ++eventCount;
+        }
+        for (; nextTimesheet < nextMidnight; nextTimesheet = nextTimesheet.addSecs(options.timesheetIntervalSec)) {
+            clock.set(nextTimesheet);
+            runTimesheet();
+        }
+        // Everything of this day goes to this day's file before the clock moves on
+        eventLog.flush();
+
+        // The server closes the day on its first clock tick after midnight
+        QElapsedTimer finalize;
+        finalize.start();
+        rollupStore.finalizeDay(store, midnight.date(), options.rules);
+        finalizeSamples.append(finalize.nsecsElapsed() / 1000.0);
+    }
+
+    eventLog.stop();
+    const double seconds = wall.elapsed() / 1000.0;
+    Clock::setInstance(nullptr);
+
+    // One report over every simulated day, read from the aggregates alone
+    QList<double> reportSamples;
+    QElapsedTimer report;
+    report.start();
+    const QDate endDate = options.startDate.addDays(options.days - 1);
+    const RollupStore::UserTotals totals = rollupStore.range(options.startDate, endDate,
+                                                             options.rules.fingerprint());
+    reportSamples.append(report.nsecsElapsed() / 1000.0);
+
+    // What the server does after a scoring.json reload: every closed day scored again
+    QList<double> rescoreSamples;
+    QElapsedTimer rescore;
+    rescore.start();
+    const int rescored = rollupStore.catchUp(store, endDate.addDays(1), changedRules());
+    rescoreSamples.append(rescore.nsecsElapsed() / 1000.0);
+
+    const QStringList statusDays = QDir(store.baseDir() + "/status").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    const QStringList logFiles = QDir(store.baseDir() + "/logs").entryList(QDir::Files);
+    QTextStream(stdout) << "simulated " << options.days << " days of " << options.users << " users from "
+                        << options.startDate.toString("yyyy-MM-dd") << ": " << eventCount << " status events, "
+                        << timesheetSamples.size() << " timesheet runs in " << QString::number(seconds, 'f', 2)
+                        << "s (" << QString::number(eventCount / qMax(seconds, 0.001), 'f', 0)
+                        << " events/s); " << statusDays.size() << " status days, " << logFiles.size()
+                        << " log files, " << totals.size() << " users in the range report, " << rescored
+                        << " days rescored\n";
+
+    QList<BenchResult> results = {summarize("simulate/appendStatusEvent", appendSamples),
+                                  summarize("simulate/timesheet", timesheetSamples),
+                                  summarize("simulate/rollover", rolloverSamples),
+                                  summarize("simulate/finalizeDay", finalizeSamples),
+                                  summarize("simulate/rangeReport", reportSamples),
+                                  summarize("simulate/rescore", rescoreSamples)};
+    for (BenchResult &result : results) {
+        result.users = options.users;
+        result.events = int(eventCount);
+    }
+    return results;
+}
+
+// Plaintext passwords hashed on every core, as AccountWorker::importAccounts
+// does before applyBatch; hashes from an export are kept as they are
+static void hashImportedPasswords(AccountStore &store, QList<AccountStore::Change> &changes)
+{
+    QtConcurrent::blockingMap(changes, [&store](AccountStore::Change &change) {
+        if (!change.password.isEmpty() && !PasswordHash::isHash(change.password)) {
+            change.password = store.hashPassword(change.password);
+        }
+    });
+}
+
+// Times an import into an empty server; false when it did not add every row
+static bool timeImport(const QString &baseDir, const QString &filePath, int users, QList<double> &samples)
+{
+    AccountStore store(baseDir);
+    QElapsedTimer timer;
+    timer.start();
+    AccountTransfer::ReadResult read = AccountTransfer::read(filePath);
+    hashImportedPasswords(store, read.changes);
+    const AccountStore::BatchResult result = store.applyBatch(read.changes);
+    samples.append(timer.nsecsElapsed() / 1000.0);
+    return result.ok && result.added == users;
+}
+
+// A bulk account transfer the way the admin window runs it: an export, that
+// export imported into an empty server (its hashes are kept, so nothing is
+// hashed), and the same accounts imported with plaintext passwords, which
+// costs one PBKDF2 run per row at the server's iteration count
+static QList<BenchResult> transfer(const QString &baseDir, int users, quint32 seed)
+{
+    WorkforceGenerator::Options workforce;
+    workforce.users = users;
+    const QJsonObject generated = WorkforceGenerator(workforce, seed).accounts();
+
+    // Stored hashes at one iteration stand in for real ones; an import keeps
+    // them as given, so their cost does not matter and setup stays fast
+    QJsonObject hashed = generated;
+    QJsonArray hashedUsers = hashed.value("users").toArray();
+    for (int i = 0; i < hashedUsers.size(); ++i) {
+        QJsonObject account = hashedUsers.at(i).toObject();
+        account["password"] = PasswordHash::create(account.value("password").toString(), 1);
+        hashedUsers[i] = account;
+    }
+    hashed["users"] = hashedUsers;
+    AccountStore source(baseDir + "/source");
+    AccountStore plainSource(baseDir + "/plain");
+    const QString exportPath = baseDir + "/export.csv";
+    const QString plainPath = baseDir + "/plain.csv";
+    if (!source.saveAccounts(hashed) || !plainSource.saveAccounts(generated)
+        || !AccountTransfer::write(plainPath, plainSource.accounts(), plainSource.allProfiles())) {
+        QTextStream(stderr) << "serverbench: cannot write the accounts to transfer\n";
+        return {};
+    }
+
+    QList<double> exportSamples;
+    QElapsedTimer timer;
+    timer.start();
+    const bool exported = AccountTransfer::write(exportPath, source.accounts(), source.allProfiles());
+    exportSamples.append(timer.nsecsElapsed() / 1000.0);
+
+    QList<double> reimportSamples;
+    QList<double> plaintextSamples;
+    if (!exported || !timeImport(baseDir + "/reimport", exportPath, users, reimportSamples)
+        || !timeImport(baseDir + "/plaintext", plainPath, users, plaintextSamples)) {
+        QTextStream(stderr) << "serverbench: the transfer did not round-trip every account\n";
+        return {};
+    }
+
+    QList<BenchResult> results = {summarize("transfer/export", exportSamples),
+                                  summarize("transfer/reimport", reimportSamples),
+                                  summarize("transfer/plaintextImport", plaintextSamples)};
+    for (BenchResult &result : results) {
+        result.users = users;
+    }
+    return results;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("serverbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Fast-forwards generated days of server activity on a virtual clock, "
+                                     "or times a bulk account transfer. The per-call benchmarks are in "
+                                     "storagebench.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"seed", "Random seed for the generated data.", "seed", "1"},
+        {"csv", "Write the results as CSV to this file.", "file"},
+        {"json", "Write the results as JSON to this file.", "file"},
+        {"simulate-days", "Days to fast-forward.", "n", "30"},
+        {"simulate-users", "Employees in the simulation.", "n", "200"},
+        {"simulate-start", "First simulated day, yyyy-MM-dd.", "date", "2024-01-01"},
+        {"timesheet-interval", "Virtual seconds between timesheet runs in the simulation "
+                               "(the server runs it every second).", "s", "60"},
+        {"rules", "Score points with this scoring.json instead of five points per second.", "file"},
+        {"transfer-users", "Instead of the simulation, time a CSV export of this many accounts, its "
+                           "re-import and an import of the same accounts with plaintext passwords.", "n"},
+    });
+    parser.process(app);
+
+    const quint32 seed = parser.value("seed").toUInt();
+
+    ScoringRules rules;
+    QString rulesError;
+    if (parser.isSet("rules") && !rules.load(parser.value("rules"), &rulesError)) {
+        QTextStream(stderr) << "serverbench: --rules: " << rulesError << "\n";
+        return 2;
+    }
+
+    QLoggingCategory::setFilterRules("server.warning=false");
+    QTextStream out(stdout);
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        QTextStream(stderr) << "serverbench: cannot create a temporary directory\n";
+        return 1;
+    }
+
+    QList<BenchResult> results;
+    if (parser.isSet("transfer-users")) {
+        const int users = parser.value("transfer-users").toInt();
+        if (users <= 0) {
+            QTextStream(stderr) << "serverbench: --transfer-users must be positive\n";
+            return 2;
+        }
+        results = transfer(dir.path(), users, seed);
+        if (results.isEmpty()) {
+            return 1;
+        }
+    } else {
+        SimulationOptions options;
+        options.days = parser.value("simulate-days").toInt();
+        options.users = parser.value("simulate-users").toInt();
+        options.startDate = QDate::fromString(parser.value("simulate-start"), "yyyy-MM-dd");
+        options.timesheetIntervalSec = parser.value("timesheet-interval").toInt();
+        options.seed = seed;
+        options.rules = rules;
+        if (options.days <= 0 || options.users <= 0 || options.timesheetIntervalSec <= 0
+            || !options.startDate.isValid()) {
+            QTextStream(stderr) << "serverbench: --simulate-days, --simulate-users and --timesheet-interval "
+                                   "must be positive and --simulate-start valid\n";
+            return 2;
+        }
+        results = simulate(TimesheetStore(dir.path()), options);
+    }
+    for (const BenchResult &result : results) {
+        out << QString("%1 iterations=%2 mean=%3us median=%4us min=%5us\n")
+                   .arg(result.name, -28)
+                   .arg(result.iterations, -7)
+                   .arg(result.meanUs, 0, 'f', 1)
+                   .arg(result.medianUs, 0, 'f', 1)
+                   .arg(result.minUs, 0, 'f', 1);
+    }
+
+    if (parser.isSet("csv")) {
+        QFile file(parser.value("csv"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            QTextStream(stderr) << "serverbench: cannot write " << file.fileName() << "\n";
+            return 1;
+        }
+        QTextStream csv(&file);
+        csv << "benchmark,users,events,iterations,mean_us,median_us,min_us\n";
+        for (const BenchResult &result : results) {
+            csv << result.name << ',' << result.users << ',' << result.events << ','
+                << result.iterations << ',' << QString::number(result.meanUs, 'f', 1) << ','
+                << QString::number(result.medianUs, 'f', 1) << ','
+                << QString::number(result.minUs, 'f', 1) << '\n';
+        }
+    }
+
+    if (parser.isSet("json")) {
+        QJsonArray rows;
+        for (const BenchResult &result : results) {
+            QJsonObject row;
+            row["benchmark"] = result.name;
+            row["users"] = result.users;
+            row["events"] = result.events;
+            row["iterations"] = result.iterations;
+            row["mean_us"] = result.meanUs;
+            row["median_us"] = result.medianUs;
+            row["min_us"] = result.minUs;
+            rows.append(row);
+        }
+        QJsonObject root;
+        root["seed"] = qint64(seed);
+        root["results"] = rows;
+
+        QFile file(parser.value("json"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "serverbench: cannot write " << file.fileName() << "\n";
+            return 1;
+        }
+        file.write(QJsonDocument(root).toJson());
+    }
+
+    return 0;
+}
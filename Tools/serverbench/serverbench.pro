@@ -0,0 +1,32 @@
+QT += core network concurrent
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Runs the server's own storage code, not a copy of it, over days generated
+# with datagen's workforce model
+INCLUDEPATH += ../../Server ../datagen
+
+SOURCES += \
+    main.cpp \
+    ../datagen/workforce.cpp \
+    ../../Server/accountstore.cpp \
+    ../../Server/accounttransfer.cpp \
+    ../../Server/asyncfilesink.cpp \
+    ../../Server/clock.cpp \
+    ../../Server/passwordhash.cpp \
+    ../../Server/rollupstore.cpp \
+    ../../Server/scoringrules.cpp \
+    ../../Server/timesheetstore.cpp
+
+HEADERS += \
+    ../datagen/workforce.h \
+    ../../Server/accountstore.h \
+    ../../Server/accounttransfer.h \
+    ../../Server/asyncfilesink.h \
+    ../../Server/clock.h \
+    ../../Server/passwordhash.h \
+    ../../Server/rollupstore.h \
+    ../../Server/scoringrules.h \
+    ../../Server/timesheetstore.h
@@ -0,0 +1,32 @@
+QT += core testlib
+QT -= gui
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = storagebench
+
+# Benchmarks the server's own storage code, not a copy of it
+INCLUDEPATH += ../../Server
+
+SOURCES += \
+    tst_storagebench.cpp \
+    ../../Server/accountstore.cpp \
+    ../../Server/clock.cpp \
+    ../../Server/passwordhash.cpp \
+    ../../Server/rosterindex.cpp \
+    ../../Server/scoringrules.cpp \
+    ../../Server/sessiontokens.cpp \
+    ../../Server/timesheetmodel.cpp \
+    ../../Server/timesheetstore.cpp
+
+HEADERS += \
+    ../../Server/accountstore.h \
+    ../../Server/clock.h \
+    ../../Server/keyedtablemodel.h \
+    ../../Server/passwordhash.h \
+    ../../Server/rosterindex.h \
+    ../../Server/scoringrules.h \
+    ../../Server/sessiontokens.h \
+    ../../Server/timesheetmodel.h \
+    ../../Server/timesheetstore.h
@@ -0,0 +1,366 @@
+#include "accountstore.h"
+#include "rosterindex.h"
+#include "sessiontokens.h"
+#include "timesheetmodel.h"
+#include "timesheetstore.h"
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QMap>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+
+// TimesheetStore logs through the server's category
+Q_LOGGING_CATEGORY(serverCategory, "server")
+
+// Day every generated status file belongs to, fixed so runs are comparable
+static const QDate benchDate(2024, 1, 15);
+static const quint32 benchSeed = 1;
+
+// QBENCHMARK cases for the server's account, status and timesheet paths,
+// run over generated data directories of every size in the matrix below.
+// Each case runs exactly the code the server runs, through the same store
+// classes. For machine-readable results use QtTest's own output formats:
+//
+//   storagebench -o results.csv,csv -o -,txt
+//   storagebench -o results.xml,xml showTimesheet
+//
+// The largest directories take minutes and gigabytes of disk to generate.
+// STORAGEBENCH_MAX_USERS and STORAGEBENCH_MAX_EVENTS leave out the rows
+// above them; a single row runs with "<case>:<row>" as usual.
+class StorageBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void loadJsonFile_data();
+    void loadJsonFile();
+    void checkCredentials_data();
+    void checkCredentials();
+    void verifySessionToken_data();
+    void verifySessionToken();
+    void showInfo_data();
+    void showInfo();
+    void rosterSearch_data();
+    void rosterSearch();
+    void handleUserStatusRequest_data();
+    void handleUserStatusRequest();
+    void statusAsOf_data();
+    void statusAsOf();
+    void showTimesheet_data();
+    void showTimesheet();
+    // Grows the status file, so it runs last
+    void saveUserStatus_data();
+    void saveUserStatus();
+
+private:
+    void addUserRows();
+    void addUserEventRows();
+    // The data directory of this size, generated on first use and kept for
+    // the other cases
+    QString dataset(int users, int events);
+
+    QTemporaryDir root;
+    QMap<QPair<int, int>, QString> datasets;
+};
+
+static const QList<int> userSizes = {10, 1000, 100000};
+static const QList<int> eventSizes = {1000, 100000, 1000000, 10000000};
+
+static QString benchUser(int index)
+{
+    return QString("bench%1").arg(index);
+}
+
+// Accounts with profiles like saveInfoData writes them, and a day of
+// online/offline events spread over working hours in time order
+static void generateDataset(const TimesheetStore &store, int users, int events, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+
+    QJsonArray accounts;
+    for (int i = 0; i < users; ++i) {
+        QJsonObject info;
+        info["Fullname"] = QString("Bench User %1").arg(i);
+        info["Birthday"] = "01/01/1990";
+        info["Sex"] = i % 2 ? "Male" : "Female";
+        info["Email"] = QString("bench%1@example.com").arg(i);
+        info["Tel"] = QString("09%1").arg(i, 8, 10, QChar('0'));
+
+        QJsonObject account;
+        account["username"] = benchUser(i);
+        account["password"] = QString("pw%1").arg(i);
+        account["info"] = info;
+        accounts.append(account);
+    }
+    QJsonObject accountRoot;
+    accountRoot["users"] = accounts;
+    AccountStore(store.baseDir()).saveAccounts(accountRoot);
+
+    QList<int> seconds(events);
+    for (int &second : seconds) {
+        second = 7 * 3600 + int(rng.bounded(11 * 3600));
+    }
+    std::sort(seconds.begin(), seconds.end());
+
+    QList<bool> online(users, false);
+    QJsonArray statusEvents;
+    for (int second : seconds) {
+        const int user = int(rng.bounded(users));
+        online[user] = !online[user];
+
+        QJsonObject event;
+        event["username"] = benchUser(user);
+        event["status"] = online[user] ? "online" : "offline";
+        event["time"] = QTime(0, 0).addSecs(second).toString("hh:mm:ss");
+        statusEvents.append(event);
+    }
+    store.saveStatusEvents(benchDate, statusEvents);
+}
+
+static bool withinLimit(const char *variable, int size)
+{
+    const int limit = qEnvironmentVariableIntValue(variable);
+    return limit <= 0 || size <= limit;
+}
+
+void StorageBench::initTestCase()
+{
+    QVERIFY2(root.isValid(), qPrintable(root.errorString()));
+    QLoggingCategory::setFilterRules("server.warning=false");
+}
+
+void StorageBench::addUserRows()
+{
+    QTest::addColumn<int>("users");
+    QTest::addColumn<int>("events");
+    for (int users : userSizes) {
+        if (withinLimit("STORAGEBENCH_MAX_USERS", users)) {
+            QTest::addRow("%d users", users) << users << eventSizes.first();
+        }
+    }
+}
+
+void StorageBench::addUserEventRows()
+{
+    QTest::addColumn<int>("users");
+    QTest::addColumn<int>("events");
+    for (int users : userSizes) {
+        for (int events : eventSizes) {
+            if (withinLimit("STORAGEBENCH_MAX_USERS", users) && withinLimit("STORAGEBENCH_MAX_EVENTS", events)) {
+                QTest::addRow("%d users, %d events", users, events) << users << events;
+            }
+        }
+    }
+}
+
+QString StorageBench::dataset(int users, int events)
+{
+    const QPair<int, int> key(users, events);
+    auto it = datasets.constFind(key);
+    if (it != datasets.constEnd()) {
+        return *it;
+    }
+
+    const QString dir = root.filePath(QString("%1-%2").arg(users).arg(events));
+    QDir().mkpath(dir);
+    generateDataset(TimesheetStore(dir), users, events, benchSeed);
+    datasets.insert(key, dir);
+    return dir;
+}
+
+void StorageBench::loadJsonFile_data()
+{
+    addUserRows();
+}
+
+void StorageBench::loadJsonFile()
+{
+    QFETCH(int, users);
+    QFETCH(int, events);
+    AccountStore accountStore(dataset(users, events));
+
+    QBENCHMARK {
+        accountStore.accounts();
+    }
+}
+
+void StorageBench::checkCredentials_data()
+{
+    addUserRows();
+}
+
+void StorageBench::checkCredentials()
+{
+    QFETCH(int, users);
+    QFETCH(int, events);
+    AccountStore accountStore(dataset(users, events));
+    const QString username = benchUser(users - 1);
+    const QString password = QString("pw%1").arg(users - 1);
+    // Hashed the way the server upgrades generated plaintext, so each login runs PBKDF2
+    const QList<AccountStore::PasswordUpgrade> upgrade = {{username, password, accountStore.hashPassword(password)}};
+    QVERIFY(accountStore.applyPasswordUpgrades(upgrade) >= 0);
+    QVERIFY(accountStore.checkCredentials(username, password));
+
+    // A login: a stat of account.json, a hash lookup and one PBKDF2 run
+    QBENCHMARK {
+        accountStore.checkCredentials(username, password);
+    }
+}
+
+void StorageBench::verifySessionToken_data()
+{
+    addUserRows();
+}
+
+void StorageBench::verifySessionToken()
+{
+    QFETCH(int, users);
+    QFETCH(int, events);
+    const QString dir = dataset(users, events);
+    AccountStore accountStore(dir);
+    SessionTokens sessionTokens(dir + "/data/session.key");
+    const QString username = benchUser(users - 1);
+    const QString token = sessionTokens.issue(username, accountStore.credentialTag(username));
+
+    // A reconnect presenting its token, checked against the account
+    QBENCHMARK {
+        QByteArray accountTag;
+        const QString user = sessionTokens.verify(token, &accountTag);
+        accountStore.credentialTag(user);
+    }
+}
+
+void StorageBench::showInfo_data()
+{
+    addUserRows();
+}
+
+void StorageBench::showInfo()
+{
+    QFETCH(int, users);
+    QFETCH(int, events);
+    AccountStore accountStore(dataset(users, events));
+    const QString username = benchUser(users - 1);
+
+    QBENCHMARK {
+        accountStore.profile(username);
+    }
+}
+
+void StorageBench::rosterSearch_data()
+{
+    addUserRows();
+}
+
+void StorageBench::rosterSearch()
+{
+    QFETCH(int, users);
+    QFETCH(int, events);
+    AccountStore accountStore(dataset(users, events));
+    RosterIndex rosterIndex;
+    rosterIndex.rebuild(accountStore.accounts(), accountStore.allProfiles());
+    const QString number = QString::number(users - 1);
+
+    // The admin typing an employee number into the search box
+    QBENCHMARK {
+        rosterIndex.search(number);
+    }
+}
+
+void StorageBench::handleUserStatusRequest_data()
+{
+    addUserEventRows();
+}
+
+void StorageBench::handleUserStatusRequest()
+{
+    QFETCH(int, users);
+    QFETCH(int, events);
+    const QString dir = dataset(users, events);
+    TimesheetStore store(dir);
+    AccountStore accountStore(dir);
+    const QTime evening(18, 0);
+
+    QBENCHMARK {
+        const QJsonArray accounts = accountStore.accounts().value("users").toArray();
+        const auto latest = TimesheetStore::latestStatusAt(store.loadStatusEvents(benchDate), evening, false);
+        QJsonArray response;
+        for (const QJsonValue &account : accounts) {
+            auto it = latest.constFind(account.toObject().value("username").toString());
+            if (it != latest.constEnd()) {
+                response.append(*it);
+            }
+        }
+    }
+}
+
+void StorageBench::statusAsOf_data()
+{
+    addUserEventRows();
+}
+
+void StorageBench::statusAsOf()
+{
+    QFETCH(int, users);
+    QFETCH(int, events);
+    TimesheetStore store(dataset(users, events));
+    const QTime noon(12, 0);
+
+    // on_btnSubmit_clicked
+    QBENCHMARK {
+        TimesheetStore::latestStatusAt(store.loadStatusEvents(benchDate), noon, true);
+    }
+}
+
+void StorageBench::showTimesheet_data()
+{
+    addUserEventRows();
+}
+
+void StorageBench::showTimesheet()
+{
+    QFETCH(int, users);
+    QFETCH(int, events);
+    const QString dir = dataset(users, events);
+    TimesheetStore store(dir);
+    AccountStore accountStore(dir);
+    TimesheetModel timesheetModel; // Kept across runs like the admin window's
+    const QTime evening(18, 0);
+
+    QBENCHMARK {
+        const QJsonArray accounts = accountStore.accounts().value("users").toArray();
+        const auto rows = TimesheetStore::computeTimesheet(accounts, store.loadStatusEvents(benchDate), evening);
+        timesheetModel.setTimesheet(rows);
+        QJsonObject points;
+        for (const auto &row : rows) {
+            points[row.username] = int(row.points);
+        }
+        store.savePoints(benchDate, points);
+    }
+}
+
+void StorageBench::saveUserStatus_data()
+{
+    addUserEventRows();
+}
+
+void StorageBench::saveUserStatus()
+{
+    QFETCH(int, users);
+    QFETCH(int, events);
+    TimesheetStore store(dataset(users, events));
+    const QString username = benchUser(users - 1);
+
+    QBENCHMARK {
+        QVERIFY(store.appendStatusEvent(benchDate, username, "online", "18:00:00"));
+    }
+}
+
+QTEST_GUILESS_MAIN(StorageBench)
+#include "tst_storagebench.moc"
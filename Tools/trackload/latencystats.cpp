@@ -0,0 +1,112 @@
+#include "latencystats.h"
+#include <QJsonArray>
+#include <QTextStream>
+#include <algorithm>
+
+void LatencyStats::add(const QString &command, qint64 latencyUs)
+{
+    samples[command].latenciesUs.append(latencyUs);
+}
+
+void LatencyStats::addError(const QString &command)
+{
+    ++samples[command].errors;
+}
+
+void LatencyStats::merge(const LatencyStats &other)
+{
+    for (auto it = other.samples.constBegin(); it != other.samples.constEnd(); ++it) {
+        Samples &target = samples[it.key()];
+        target.latenciesUs += it->latenciesUs;
+        target.errors += it->errors;
+    }
+}
+
+QStringList LatencyStats::commands() const
+{
+    QStringList names = samples.keys();
+    names.sort();
+    return names;
+}
+
+// Nearest-rank percentile of an already sorted list
+static double percentileMs(const QList<qint64> &sorted, double percentile)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    qsizetype rank = qsizetype(percentile / 100.0 * sorted.size() + 0.999999) - 1;
+    rank = qBound<qsizetype>(0, rank, sorted.size() - 1);
+    return sorted.at(rank) / 1000.0;
+}
+
+LatencyStats::Summary LatencyStats::summary(const QString &command) const
+{
+    Summary result;
+    const Samples entry = samples.value(command);
+    QList<qint64> sorted = entry.latenciesUs;
+    std::sort(sorted.begin(), sorted.end());
+
+    result.count = sorted.size();
+    result.errors = entry.errors;
+    if (!sorted.isEmpty()) {
+        qint64 total = 0;
+        for (qint64 us : sorted) {
+            total += us;
+        }
+        result.meanMs = total / 1000.0 / sorted.size();
+        result.p50Ms = percentileMs(sorted, 50);
+        result.p95Ms = percentileMs(sorted, 95);
+        result.p99Ms = percentileMs(sorted, 99);
+        result.maxMs = sorted.last() / 1000.0;
+    }
+    return result;
+}
+
+QString LatencyStats::formatTable(double seconds) const
+{
+    QString text;
+    QTextStream out(&text);
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+               .arg("command", -18).arg("count", 8).arg("errors", 7).arg("req/s", 9)
+               .arg("mean ms", 9).arg("p50 ms", 9).arg("p95 ms", 9).arg("p99 ms", 9).arg("max ms", 9);
+
+    for (const QString &command : commands()) {
+        const Summary s = summary(command);
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+                   .arg(command, -18)
+                   .arg(s.count, 8)
+                   .arg(s.errors, 7)
+                   .arg(seconds > 0 ? s.count / seconds : 0.0, 9, 'f', 1)
+                   .arg(s.meanMs, 9, 'f', 2)
+                   .arg(s.p50Ms, 9, 'f', 2)
+                   .arg(s.p95Ms, 9, 'f', 2)
+                   .arg(s.p99Ms, 9, 'f', 2)
+                   .arg(s.maxMs, 9, 'f', 2);
+    }
+    return text;
+}
+
+QJsonObject LatencyStats::toJson(double seconds) const
+{
+    QJsonArray rows;
+    for (const QString &command : commands()) {
+        const Summary s = summary(command);
+        QJsonObject row;
+        row["command"] = command;
+        row["count"] = s.count;
+        row["errors"] = s.errors;
+        row["throughput"] = seconds > 0 ? s.count / seconds : 0.0;
+        row["mean_ms"] = s.meanMs;
+        row["p50_ms"] = s.p50Ms;
+        row["p95_ms"] = s.p95Ms;
+        row["p99_ms"] = s.p99Ms;
+        row["max_ms"] = s.maxMs;
+        rows.append(row);
+    }
+
+    QJsonObject result;
+    result["seconds"] = seconds;
+    result["commands"] = rows;
+    return result;
+}
@@ -0,0 +1,44 @@
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Per-command latency samples and error counts, summarized as percentiles.
+// Every sample is kept, so the percentiles are exact rather than bucketed.
+class LatencyStats
+{
+public:
+    struct Summary {
+        qint64 count = 0;
+        qint64 errors = 0;
+        double meanMs = 0;
+        double p50Ms = 0;
+        double p95Ms = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+    };
+
+    void add(const QString &command, qint64 latencyUs);
+    void addError(const QString &command);
+    void merge(const LatencyStats &other);
+
+    QStringList commands() const;
+    Summary summary(const QString &command) const;
+
+    // Text table with throughput over the given wall time
+    QString formatTable(double seconds) const;
+    QJsonObject toJson(double seconds) const;
+
+private:
+    struct Samples {
+        QList<qint64> latenciesUs;
+        qint64 errors = 0;
+    };
+    QHash<QString, Samples> samples;
+};
+
+#endif // LATENCYSTATS_H
@@ -0,0 +1,142 @@
+#include "loadrunner.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QTimer>
+#include <QtMath>
+
+LoadRunner::LoadRunner(const Config &config, QObject *parent)
+    : QObject(parent),
+    config(config),
+    rng(config.seed),
+    arrivalTimer(new QTimer(this)),
+    durationTimer(new QTimer(this)),
+    graceTimer(new QTimer(this))
+{
+    arrivalTimer->setSingleShot(true);
+    durationTimer->setSingleShot(true);
+    graceTimer->setSingleShot(true);
+
+    connect(arrivalTimer, &QTimer::timeout, this, [this]() {
+        spawnClient();
+        scheduleArrival();
+    });
+    connect(durationTimer, &QTimer::timeout, this, &LoadRunner::beginShutdown);
+    // Clients that never answer Exit must not keep the run open
+    connect(graceTimer, &QTimer::timeout, this, &LoadRunner::report);
+}
+
+void LoadRunner::start()
+{
+    QTextStream(stdout) << "trackload: " << config.clients << " clients at "
+                        << config.arrivalRate << "/s against " << config.client.host
+                        << ":" << config.client.port << " for " << config.durationSec << "s\n";
+    wallClock.start();
+    durationTimer->start(config.durationSec * 1000);
+    spawnClient();
+    scheduleArrival();
+}
+
+void LoadRunner::scheduleArrival()
+{
+    if (stopping || started >= config.clients) {
+        return;
+    }
+    if (config.arrivalRate <= 0) {
+        // No rate given: everyone connects at once
+        arrivalTimer->start(0);
+        return;
+    }
+    // Exponential inter-arrival gaps give Poisson arrivals
+    const double gapMs = -qLn(1.0 - rng.generateDouble()) * 1000.0 / config.arrivalRate;
+    arrivalTimer->start(int(gapMs));
+}
+
+void LoadRunner::spawnClient()
+{
+    if (stopping || started >= config.clients || config.accounts.isEmpty()) {
+        return;
+    }
+    const int id = started++;
+    const Account &account = config.accounts.at(id % config.accounts.size());
+
+    auto *client = new SimClient(id, account.username, account.password, config.client, &rng, this);
+    connect(client, &SimClient::requestCompleted, this,
+            [this](const QString &command, qint64 latencyUs, bool ok) {
+                if (ok) {
+                    stats.add(command, latencyUs);
+                } else {
+                    stats.addError(command);
+                }
+            });
+    connect(client, &SimClient::finished, this, &LoadRunner::onClientFinished);
+    clients.append(client);
+
+    ++active;
+    peakActive = qMax(peakActive, active);
+    client->start();
+}
+
+void LoadRunner::beginShutdown()
+{
+    if (stopping) {
+        return;
+    }
+    stopping = true;
+    arrivalTimer->stop();
+    graceTimer->start(10000);
+
+    const QList<SimClient *> running = clients;
+    for (SimClient *client : running) {
+        client->finish();
+    }
+    if (active == 0) {
+        report();
+    }
+}
+
+void LoadRunner::onClientFinished()
+{
+    --active;
+    if (stopping && active == 0) {
+        report();
+    }
+}
+
+void LoadRunner::report()
+{
+    if (reported) {
+        return;
+    }
+    reported = true;
+    graceTimer->stop();
+
+    const double seconds = wallClock.elapsed() / 1000.0;
+    QTextStream out(stdout);
+    out << "\nclients started: " << started << ", peak concurrent: " << peakActive
+        << ", wall time: " << QString::number(seconds, 'f', 1) << "s\n\n";
+    out << stats.formatTable(seconds);
+    out.flush();
+
+    if (!config.jsonPath.isEmpty()) {
+        QJsonObject result = stats.toJson(seconds);
+        result["clients"] = started;
+        result["peak_concurrent"] = peakActive;
+        result["arrival_rate"] = config.arrivalRate;
+        result["think_time_ms"] = config.client.thinkTimeMs;
+        result["seed"] = qint64(config.seed);
+
+        QFile file(config.jsonPath);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            file.write(QJsonDocument(result).toJson());
+        } else {
+            QTextStream(stderr) << "trackload: cannot write " << config.jsonPath << "\n";
+        }
+    }
+
+    qint64 errors = 0;
+    for (const QString &command : stats.commands()) {
+        errors += stats.summary(command).errors;
+    }
+    emit done(errors > 0 ? 1 : 0);
+}
@@ -0,0 +1,65 @@
+#ifndef LOADRUNNER_H
+#define LOADRUNNER_H
+
+#include "latencystats.h"
+#include "simclient.h"
+#include <QObject>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QList>
+
+class QTimer;
+
+// Starts simulated clients as a Poisson process, lets them run for the
+// configured duration, then asks each to Exit and reports the latencies.
+class LoadRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Account {
+        QString username;
+        QString password;
+    };
+
+    struct Config {
+        SimClient::Config client;
+        int clients = 50;
+        double arrivalRate = 10;    // New clients per second
+        int durationSec = 60;
+        QList<Account> accounts;    // Cycled when there are more clients than accounts
+        quint32 seed = 1;
+        QString jsonPath;
+    };
+
+    explicit LoadRunner(const Config &config, QObject *parent = nullptr);
+
+    void start();
+
+signals:
+    void done(int exitCode);
+
+private:
+    void scheduleArrival();
+    void spawnClient();
+    void beginShutdown();
+    void onClientFinished();
+    void report();
+
+    Config config;
+    QRandomGenerator rng;
+    LatencyStats stats;
+    QElapsedTimer wallClock;
+
+    QTimer *arrivalTimer;
+    QTimer *durationTimer;
+    QTimer *graceTimer;
+    QList<SimClient *> clients;
+    int started = 0;
+    int active = 0;
+    int peakActive = 0;
+    bool stopping = false;
+    bool reported = false;
+};
+
+#endif // LOADRUNNER_H
@@ -0,0 +1,110 @@
+#include "loadrunner.h"
+#include "replayrunner.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+// Accounts in the server's account.json format: {"users": [{username, password}]}
+static QList<LoadRunner::Account> loadAccounts(const QString &path)
+{
+    QList<LoadRunner::Account> accounts;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return accounts;
+    }
+    const QJsonArray users = QJsonDocument::fromJson(file.readAll()).object().value("users").toArray();
+    for (const QJsonValue &value : users) {
+        const QJsonObject user = value.toObject();
+        accounts.append({user.value("username").toString(), user.value("password").toString()});
+    }
+    return accounts;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("trackload");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulates employee clients against the Time Tracking server "
+                                     "and reports per-command latency.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"host", "Server address.", "host", "127.0.0.1"},
+        {"port", "Server TCP port.", "port", "1235"},
+        {"clients", "Number of simulated clients.", "n", "50"},
+        {"arrival-rate", "New clients per second (0 = all at once).", "rate", "10"},
+        {"think-time", "Mean think time between user actions in ms.", "ms", "5000"},
+        {"poll-interval", "showPoints polling interval in ms.", "ms", "1000"},
+        {"duration", "Length of the run in seconds.", "s", "60"},
+        {"timeout", "Per-request timeout in ms.", "ms", "10000"},
+        {"accounts", "account.json to take usernames and passwords from.", "file"},
+        {"user-prefix", "Without --accounts, log in as <prefix>1..<prefix>N.", "prefix", "loaduser"},
+        {"password", "Password for the generated usernames, and for blanked ones in a replay.", "password", "loadtest"},
+        {"seed", "Random seed for arrivals and think times.", "seed", "1"},
+        {"json", "Also write the report as JSON to this file.", "file"},
+        {"replay", "Replay a server capture (.tcap) instead of simulating; repeat for rolled files.", "file"},
+        {"speed", "Replay speed factor, 0 = as fast as the server answers.", "factor", "1"},
+    });
+    parser.process(app);
+
+    if (parser.isSet("replay")) {
+        ReplayRunner::Config replayConfig;
+        replayConfig.host = parser.value("host");
+        replayConfig.port = quint16(parser.value("port").toUInt());
+        replayConfig.files = parser.values("replay");
+        replayConfig.speed = parser.value("speed").toDouble();
+        replayConfig.timeoutMs = parser.value("timeout").toInt();
+        replayConfig.password = parser.value("password");
+        replayConfig.jsonPath = parser.value("json");
+
+        ReplayRunner replay(replayConfig);
+        QString error;
+        if (!replay.load(&error)) {
+            QTextStream(stderr) << "trackload: " << error << "\n";
+            return 2;
+        }
+        QObject::connect(&replay, &ReplayRunner::done, &app, &QCoreApplication::exit);
+        replay.start();
+        return app.exec();
+    }
+
+    LoadRunner::Config config;
+    config.client.host = parser.value("host");
+    config.client.port = quint16(parser.value("port").toUInt());
+    config.client.thinkTimeMs = parser.value("think-time").toInt();
+    config.client.pollIntervalMs = parser.value("poll-interval").toInt();
+    config.client.timeoutMs = parser.value("timeout").toInt();
+    config.clients = parser.value("clients").toInt();
+    config.arrivalRate = parser.value("arrival-rate").toDouble();
+    config.durationSec = parser.value("duration").toInt();
+    config.seed = parser.value("seed").toUInt();
+    config.jsonPath = parser.value("json");
+
+    if (parser.isSet("accounts")) {
+        config.accounts = loadAccounts(parser.value("accounts"));
+        if (config.accounts.isEmpty()) {
+            QTextStream(stderr) << "trackload: no accounts in " << parser.value("accounts") << "\n";
+            return 2;
+        }
+    } else {
+        for (int i = 1; i <= config.clients; ++i) {
+            config.accounts.append({parser.value("user-prefix") + QString::number(i),
+                                    parser.value("password")});
+        }
+    }
+
+    if (config.clients <= 0 || config.durationSec <= 0 || config.client.pollIntervalMs <= 0) {
+        QTextStream(stderr) << "trackload: --clients, --duration and --poll-interval must be positive\n";
+        return 2;
+    }
+
+    LoadRunner runner(config);
+    QObject::connect(&runner, &LoadRunner::done, &app, &QCoreApplication::exit);
+    runner.start();
+    return app.exec();
+}
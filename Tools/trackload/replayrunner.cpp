@@ -0,0 +1,274 @@
+#include "replayrunner.h"
+#include "simclient.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QTimer>
+#include <limits>
+
+ReplayRunner::ReplayRunner(const Config &config, QObject *parent)
+    : QObject(parent),
+    config(config)
+{
+}
+
+ReplayRunner::~ReplayRunner()
+{
+    qDeleteAll(connections);
+}
+
+// The server blanks passwords in captures; fill them in for the test accounts
+QByteArray ReplayRunner::restorePassword(const QByteArray &payload) const
+{
+    if (config.password.isEmpty() || !payload.contains("\"password\":\"\"")) {
+        return payload;
+    }
+    QJsonObject obj = QJsonDocument::fromJson(payload.trimmed()).object();
+    if (obj.contains("password") && obj.value("password").toString().isEmpty()) {
+        obj["password"] = config.password;
+    }
+    for (const char *key : {"data", "Data"}) {
+        QJsonObject inner = obj.value(key).toObject();
+        if (inner.contains("password") && inner.value("password").toString().isEmpty()) {
+            inner["password"] = config.password;
+            obj[key] = inner;
+        }
+    }
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+
+bool ReplayRunner::load(QString *error)
+{
+    firstUs = std::numeric_limits<qint64>::max();
+    for (const QString &path : config.files) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            *error = "cannot read " + path;
+            return false;
+        }
+        while (!file.atEnd()) {
+            const QByteArray line = file.readLine().trimmed();
+            // Skips the header and the sink's notes about dropped records
+            const QList<QByteArray> fields = line.split('\t');
+            if (line.startsWith('#') || fields.size() < 3 || fields.at(2).size() != 1) {
+                continue;
+            }
+            bool ok = false;
+            const qint64 atUs = fields.at(0).toLongLong(&ok);
+            const quint64 id = fields.at(1).toULongLong();
+            if (!ok) {
+                continue;
+            }
+
+            Connection *&connection = connections[id];
+            if (!connection) {
+                connection = new Connection;
+                connection->id = id;
+                connection->openUs = atUs; // Connections older than the capture open at their first frame
+            }
+            firstUs = qMin(firstUs, atUs);
+
+            switch (fields.at(2).at(0)) {
+            case 'O':
+                connection->openUs = atUs;
+                break;
+            case 'C':
+                connection->closeUs = atUs;
+                break;
+            case 'D': {
+                const QByteArray payload = restorePassword(QByteArray::fromBase64(fields.value(3)));
+                const QString command = QJsonDocument::fromJson(payload.trimmed()).object()
+                                            .value("request").toString();
+                connection->frames.append({atUs, payload, command.isEmpty() ? QString("other") : command});
+                ++frameCount;
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    if (frameCount == 0) {
+        *error = "no frames in the capture";
+        return false;
+    }
+    return true;
+}
+
+qint64 ReplayRunner::wallDelayMs(qint64 capturedUs) const
+{
+    if (config.speed <= 0) {
+        return 0;
+    }
+    const qint64 dueMs = qint64((capturedUs - firstUs) / config.speed / 1000.0);
+    return qMax<qint64>(0, dueMs - wallClock.elapsed());
+}
+
+void ReplayRunner::start()
+{
+    QTextStream(stdout) << "trackload: replaying " << frameCount << " frames on " << connections.size()
+                        << " connections at " << (config.speed > 0 ? QString::number(config.speed) + "x"
+                                                                     : QString("full speed"))
+                        << " against " << config.host << ":" << config.port << "\n";
+    wallClock.start();
+    remaining = connections.size();
+    for (Connection *connection : std::as_const(connections)) {
+        QTimer::singleShot(wallDelayMs(connection->openUs), this, [this, connection]() {
+            openConnection(connection);
+        });
+    }
+}
+
+void ReplayRunner::openConnection(Connection *connection)
+{
+    connection->socket = new QTcpSocket(this);
+    connection->timeoutTimer = new QTimer(this);
+    connection->timeoutTimer->setSingleShot(true);
+
+    connect(connection->socket, &QTcpSocket::connected, this, [this, connection]() {
+        stats.add("connect", connection->requestTimer.nsecsElapsed() / 1000);
+        connection->timeoutTimer->stop();
+        connection->inFlight.clear();
+        pump(connection);
+    });
+    connect(connection->socket, &QTcpSocket::readyRead, this, [this, connection]() {
+        onReadyRead(connection);
+    });
+    connect(connection->socket, &QTcpSocket::errorOccurred, this, [this, connection]() {
+        if (!connection->inFlight.isEmpty()) {
+            stats.addError(connection->inFlight);
+            connection->inFlight.clear();
+        }
+        finishConnection(connection);
+    });
+    connect(connection->timeoutTimer, &QTimer::timeout, this, [this, connection]() {
+        onTimeout(connection);
+    });
+
+    connection->inFlight = "connect";
+    connection->requestTimer.start();
+    connection->timeoutTimer->start(config.timeoutMs);
+    connection->socket->connectToHost(config.host, config.port);
+}
+
+void ReplayRunner::pump(Connection *connection)
+{
+    if (connection->finished || !connection->inFlight.isEmpty()) {
+        return;
+    }
+
+    if (connection->next >= connection->frames.size()) {
+        // Keep the connection for as long as it lived in the capture
+        const qint64 delay = connection->closeUs >= 0 ? wallDelayMs(connection->closeUs) : 0;
+        QTimer::singleShot(delay, this, [this, connection]() {
+            finishConnection(connection);
+        });
+        return;
+    }
+
+    const Frame &frame = connection->frames.at(connection->next);
+    const qint64 delay = wallDelayMs(frame.atUs);
+    if (delay > 0) {
+        QTimer::singleShot(delay, this, [this, connection]() {
+            pump(connection);
+        });
+        return;
+    }
+
+    ++connection->next;
+    connection->inFlight = frame.command;
+    connection->requestTimer.start();
+    connection->timeoutTimer->start(config.timeoutMs);
+    connection->socket->write(frame.payload);
+}
+
+void ReplayRunner::onReadyRead(Connection *connection)
+{
+    connection->buffer.append(connection->socket->readAll());
+    for (;;) {
+        const int start = connection->buffer.indexOf('{');
+        if (start < 0) {
+            connection->buffer.clear();
+            return;
+        }
+        connection->buffer.remove(0, start);
+        const qsizetype length = SimClient::completeJsonLength(connection->buffer);
+        if (length == 0) {
+            return;
+        }
+        const QString response = QJsonDocument::fromJson(connection->buffer.left(length)).object()
+                                     .value("response").toString();
+        connection->buffer.remove(0, length);
+
+        if (connection->inFlight.isEmpty()) {
+            continue;
+        }
+        connection->timeoutTimer->stop();
+        if (response.startsWith("Error") || response.startsWith("Invalid")) {
+            stats.addError(connection->inFlight);
+        } else {
+            stats.add(connection->inFlight, connection->requestTimer.nsecsElapsed() / 1000);
+        }
+        connection->inFlight.clear();
+        pump(connection);
+    }
+}
+
+void ReplayRunner::onTimeout(Connection *connection)
+{
+    stats.addError(connection->inFlight);
+    connection->inFlight.clear();
+    if (connection->socket->state() != QAbstractSocket::ConnectedState) {
+        finishConnection(connection);
+        return;
+    }
+    // Some commands have no answer; carry on with the next frame
+    pump(connection);
+}
+
+void ReplayRunner::finishConnection(Connection *connection)
+{
+    if (connection->finished) {
+        return;
+    }
+    connection->finished = true;
+    connection->timeoutTimer->stop();
+    connection->socket->disconnectFromHost();
+    if (--remaining == 0) {
+        report();
+    }
+}
+
+void ReplayRunner::report()
+{
+    const double seconds = wallClock.elapsed() / 1000.0;
+    QTextStream out(stdout);
+    out << "\nconnections: " << connections.size() << ", frames: " << frameCount
+        << ", wall time: " << QString::number(seconds, 'f', 1) << "s\n\n";
+    out << stats.formatTable(seconds);
+    out.flush();
+
+    if (!config.jsonPath.isEmpty()) {
+        QJsonObject result = stats.toJson(seconds);
+        result["mode"] = "replay";
+        result["connections"] = connections.size();
+        result["frames"] = frameCount;
+        result["speed"] = config.speed;
+
+        QFile file(config.jsonPath);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            file.write(QJsonDocument(result).toJson());
+        } else {
+            QTextStream(stderr) << "trackload: cannot write " << config.jsonPath << "\n";
+        }
+    }
+
+    qint64 errors = 0;
+    for (const QString &command : stats.commands()) {
+        errors += stats.summary(command).errors;
+    }
+    emit done(errors > 0 ? 1 : 0);
+}
@@ -0,0 +1,83 @@
+#ifndef REPLAYRUNNER_H
+#define REPLAYRUNNER_H
+
+#include "latencystats.h"
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+
+class QTcpSocket;
+class QTimer;
+
+// Re-drives a capture recorded by the server (--capture or POST
+// /capture/start) against a server. Connections open and frames are sent at
+// their captured offsets divided by the speed factor; speed 0 sends as fast
+// as the server answers. Like the real clients, a connection sends its next
+// frame only after the previous one was answered, because the server treats
+// every read as one JSON request.
+class ReplayRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config {
+        QString host = "127.0.0.1";
+        quint16 port = 1235;
+        QStringList files;
+        double speed = 1;
+        int timeoutMs = 10000;
+        QString password;   // Put into the passwords the capture blanked
+        QString jsonPath;
+    };
+
+    explicit ReplayRunner(const Config &config, QObject *parent = nullptr);
+    ~ReplayRunner();
+
+    // Reads the capture files; false with a message when nothing can be replayed
+    bool load(QString *error);
+    void start();
+
+signals:
+    void done(int exitCode);
+
+private:
+    struct Frame {
+        qint64 atUs;
+        QByteArray payload;
+        QString command;
+    };
+    struct Connection {
+        quint64 id = 0;
+        qint64 openUs = -1;
+        qint64 closeUs = -1;
+        QList<Frame> frames;
+        int next = 0;
+        QTcpSocket *socket = nullptr;
+        QTimer *timeoutTimer = nullptr;
+        QByteArray buffer;
+        QString inFlight;
+        QElapsedTimer requestTimer;
+        bool finished = false;
+    };
+
+    QByteArray restorePassword(const QByteArray &payload) const;
+    qint64 wallDelayMs(qint64 capturedUs) const;
+    void openConnection(Connection *connection);
+    void pump(Connection *connection);
+    void onReadyRead(Connection *connection);
+    void onTimeout(Connection *connection);
+    void finishConnection(Connection *connection);
+    void report();
+
+    Config config;
+    QMap<quint64, Connection *> connections;
+    qint64 firstUs = 0;
+    qint64 frameCount = 0;
+    int remaining = 0;
+    QElapsedTimer wallClock;
+    LatencyStats stats;
+};
+
+#endif // REPLAYRUNNER_H
@@ -0,0 +1,299 @@
+#include "simclient.h"
+#include <QTcpSocket>
+#include <QTimer>
+#include <QRandomGenerator>
+#include <QJsonDocument>
+#include <QHostAddress>
+#include <QtMath>
+
+// Response names the server sends for a successful request
+static bool isSuccess(const QString &command, const QString &response)
+{
+    if (command == "loginRequest") {
+        return response == "Login successful";
+    }
+    if (command == "currentLoginUser") {
+        return response == "currentLoginUser";
+    }
+    if (command == "showInfo") {
+        return response == "responseInfo" || response == "infoEmpty";
+    }
+    if (command == "showPoints") {
+        return response == "currentPoints";
+    }
+    if (command == "Exit") {
+        return response == "Exit successful";
+    }
+    return !response.startsWith("Error") && !response.startsWith("Invalid");
+}
+
+SimClient::SimClient(int id, const QString &username, const QString &password,
+                     const Config &config, QRandomGenerator *rng, QObject *parent)
+    : QObject(parent),
+    id(id),
+    username(username),
+    password(password),
+    config(config),
+    rng(rng),
+    socket(new QTcpSocket(this)),
+    pollTimer(new QTimer(this)),
+    thinkTimer(new QTimer(this)),
+    timeoutTimer(new QTimer(this))
+{
+    thinkTimer->setSingleShot(true);
+    timeoutTimer->setSingleShot(true);
+
+    connect(socket, &QTcpSocket::connected, this, &SimClient::onConnected);
+    connect(socket, &QTcpSocket::readyRead, this, &SimClient::onReadyRead);
+    connect(socket, &QTcpSocket::errorOccurred, this, &SimClient::onSocketError);
+    connect(timeoutTimer, &QTimer::timeout, this, &SimClient::onTimeout);
+
+    connect(pollTimer, &QTimer::timeout, this, [this]() {
+        // Skip the tick if the previous poll is still queued or in flight
+        if (inFlight == "showPoints") {
+            return;
+        }
+        for (const auto &request : pending) {
+            if (request.first == "showPoints") {
+                return;
+            }
+        }
+        QJsonObject request;
+        request["request"] = "showPoints";
+        request["username"] = this->username;
+        enqueue("showPoints", request);
+    });
+
+    connect(thinkTimer, &QTimer::timeout, this, [this]() {
+        // The user refreshes the online list or opens their info
+        QJsonObject request;
+        if (this->rng->bounded(2) == 0) {
+            request["request"] = "currentLoginUser";
+            enqueue("currentLoginUser", request);
+        } else {
+            request["request"] = "showInfo";
+            request["username"] = this->username;
+            enqueue("showInfo", request);
+        }
+        scheduleThink();
+    });
+}
+
+void SimClient::start()
+{
+    requestTimer.start();
+    inFlight = "connect";
+    timeoutTimer->start(config.timeoutMs);
+    socket->connectToHost(config.host, config.port);
+}
+
+void SimClient::finish()
+{
+    if (exiting || closed) {
+        return;
+    }
+    exiting = true;
+    pollTimer->stop();
+    thinkTimer->stop();
+    pending.clear();
+
+    if (!loggedIn || socket->state() != QAbstractSocket::ConnectedState) {
+        close();
+        return;
+    }
+    QJsonObject request;
+    request["request"] = "Exit";
+    enqueue("Exit", request);
+}
+
+void SimClient::onConnected()
+{
+    timeoutTimer->stop();
+    emit requestCompleted("connect", requestTimer.nsecsElapsed() / 1000, true);
+    inFlight.clear();
+
+    QJsonObject loginData;
+    loginData["username"] = username;
+    loginData["password"] = password;
+    QJsonObject request;
+    request["request"] = "loginRequest";
+    request["data"] = loginData;
+    enqueue("loginRequest", request);
+}
+
+void SimClient::enqueue(const QString &command, const QJsonObject &request)
+{
+    pending.enqueue({command, request});
+    if (inFlight.isEmpty()) {
+        sendNext();
+    }
+}
+
+void SimClient::sendNext()
+{
+    if (pending.isEmpty() || closed) {
+        return;
+    }
+    auto request = pending.dequeue();
+    inFlight = request.first;
+    // statusForm sends the token of its login with every request
+    if (!sessionToken.isEmpty()) {
+        request.second["token"] = sessionToken;
+    }
+    inFlightRequest = request.second;
+    requestTimer.start();
+    timeoutTimer->start(config.timeoutMs);
+    socket->write(QJsonDocument(request.second).toJson(QJsonDocument::Compact));
+}
+
+// Responses are not framed, so complete objects are cut out of the stream by
+// matching braces outside of strings
+qsizetype SimClient::completeJsonLength(const QByteArray &buffer)
+{
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    for (qsizetype i = 0; i < buffer.size(); ++i) {
+        const char c = buffer.at(i);
+        if (inString) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                inString = false;
+            }
+        } else if (c == '"') {
+            inString = true;
+        } else if (c == '{') {
+            ++depth;
+        } else if (c == '}') {
+            if (--depth == 0) {
+                return i + 1;
+            }
+        }
+    }
+    return 0;
+}
+
+void SimClient::onReadyRead()
+{
+    buffer.append(socket->readAll());
+    for (;;) {
+        const int start = buffer.indexOf('{');
+        if (start < 0) {
+            buffer.clear();
+            return;
+        }
+        if (start > 0) {
+            buffer.remove(0, start);
+        }
+        const qsizetype length = completeJsonLength(buffer);
+        if (length == 0) {
+            return;
+        }
+        const QJsonObject response = QJsonDocument::fromJson(buffer.left(length)).object();
+        buffer.remove(0, length);
+        onResponse(response);
+    }
+}
+
+void SimClient::onResponse(const QJsonObject &response)
+{
+    if (inFlight.isEmpty()) {
+        return; // Unsolicited, e.g. a late answer after a timeout
+    }
+    timeoutTimer->stop();
+    const QString command = inFlight;
+
+    // Refused by the server's admission control: counted on its own row so
+    // the latency of real answers stays clean, and sent again when asked to.
+    // The poll timer resends showPoints by itself.
+    if (response.value("response").toString() == "retryAfter") {
+        inFlight.clear();
+        emit requestCompleted("retryAfter", requestTimer.nsecsElapsed() / 1000, true);
+        if (command != "showPoints") {
+            const QJsonObject request = inFlightRequest;
+            QTimer::singleShot(response.value("retryAfterMs").toInt(1000), this, [this, command, request]() {
+                if (!closed) {
+                    enqueue(command, request);
+                }
+            });
+        }
+        sendNext();
+        return;
+    }
+
+    const bool ok = isSuccess(command, response.value("response").toString());
+    inFlight.clear();
+    emit requestCompleted(command, requestTimer.nsecsElapsed() / 1000, ok);
+
+    if (command == "loginRequest") {
+        if (!ok) {
+            close();
+            return;
+        }
+        loggedIn = true;
+        sessionToken = response.value("token").toString();
+        // What statusForm requests as soon as it opens
+        QJsonObject users;
+        users["request"] = "currentLoginUser";
+        enqueue("currentLoginUser", users);
+        QJsonObject info;
+        info["request"] = "showInfo";
+        info["username"] = username;
+        enqueue("showInfo", info);
+        pollTimer->start(config.pollIntervalMs);
+        scheduleThink();
+    } else if (command == "Exit") {
+        close();
+        return;
+    }
+    sendNext();
+}
+
+void SimClient::onTimeout()
+{
+    const QString command = inFlight;
+    inFlight.clear();
+    emit requestCompleted(command, requestTimer.nsecsElapsed() / 1000, false);
+    // Without framing a late answer cannot be told apart, start over clean
+    close();
+}
+
+void SimClient::onSocketError()
+{
+    if (closed) {
+        return;
+    }
+    if (!inFlight.isEmpty()) {
+        const QString command = inFlight;
+        inFlight.clear();
+        emit requestCompleted(command, requestTimer.nsecsElapsed() / 1000, false);
+    }
+    close();
+}
+
+void SimClient::scheduleThink()
+{
+    if (exiting || config.thinkTimeMs <= 0) {
+        return;
+    }
+    // Exponential think time, capped so one draw cannot stall a client forever
+    const double draw = -qLn(1.0 - rng->generateDouble()) * config.thinkTimeMs;
+    thinkTimer->start(int(qMin(draw, config.thinkTimeMs * 10.0)));
+}
+
+void SimClient::close()
+{
+    if (closed) {
+        return;
+    }
+    closed = true;
+    pollTimer->stop();
+    thinkTimer->stop();
+    timeoutTimer->stop();
+    pending.clear();
+    socket->abort();
+    emit finished(id);
+}
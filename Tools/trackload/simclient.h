@@ -0,0 +1,79 @@
+#ifndef SIMCLIENT_H
+#define SIMCLIENT_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QQueue>
+#include <QString>
+
+class QTcpSocket;
+class QTimer;
+class QRandomGenerator;
+
+// One simulated employee. Follows the same sequence as MainWindow and
+// statusForm: loginRequest, then currentLoginUser and showInfo, showPoints
+// polling while the session lasts, occasional refreshes after a random think
+// time, and Exit at the end. Like the real client it keeps at most one
+// request in flight, because the server parses each read as one JSON object.
+class SimClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config {
+        QString host = "127.0.0.1";
+        quint16 port = 1235;
+        int thinkTimeMs = 5000;    // Mean of an exponential distribution
+        int pollIntervalMs = 1000; // statusForm polls showPoints every second
+        int timeoutMs = 10000;
+    };
+
+    SimClient(int id, const QString &username, const QString &password,
+              const Config &config, QRandomGenerator *rng, QObject *parent = nullptr);
+
+    void start();
+    // Ends the session with Exit; emits finished() once the server answered
+    void finish();
+
+    // Length of the first complete JSON object in buffer, 0 if incomplete
+    static qsizetype completeJsonLength(const QByteArray &buffer);
+
+signals:
+    void requestCompleted(const QString &command, qint64 latencyUs, bool ok);
+    void finished(int id);
+
+private:
+    void enqueue(const QString &command, const QJsonObject &request);
+    void sendNext();
+    void onConnected();
+    void onReadyRead();
+    void onResponse(const QJsonObject &response);
+    void onTimeout();
+    void onSocketError();
+    void scheduleThink();
+    void close();
+
+    int id;
+    QString username;
+    QString password;
+    Config config;
+    QRandomGenerator *rng;
+
+    QTcpSocket *socket;
+    QTimer *pollTimer;
+    QTimer *thinkTimer;
+    QTimer *timeoutTimer;
+
+    QQueue<QPair<QString, QJsonObject>> pending;
+    QString inFlight;
+    QJsonObject inFlightRequest; // Sent again when the server asks to retry
+    QElapsedTimer requestTimer;
+    QByteArray buffer;
+    QString sessionToken;
+    bool loggedIn = false;
+    bool exiting = false;
+    bool closed = false;
+};
+
+#endif // SIMCLIENT_H
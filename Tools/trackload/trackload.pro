@@ -0,0 +1,23 @@
+QT += core network
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+SOURCES += \
+    latencystats.cpp \
+    loadrunner.cpp \
+    main.cpp \
+    replayrunner.cpp \
+    simclient.cpp
+
+HEADERS += \
+    latencystats.h \
+    loadrunner.h \
+    replayrunner.h \
+    simclient.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target